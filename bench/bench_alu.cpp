@@ -0,0 +1,90 @@
+// Times the add and compare of each ALU strategy (see cp6502::Alu) over two
+// operand streams: uniformly random bytes, which touch the whole table, and
+// bytes from a 16-value range, whose table entries stay in L1.
+// Configure with -DCMAKE_BUILD_TYPE=Release for meaningful numbers.
+//
+// usage: bench_alu [millions of operations]
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "../core/alu.hpp"
+
+using namespace cp6502;
+
+namespace {
+
+constexpr int Repeats = 5;
+
+std::vector<Byte> Operands(u32 count, Byte mask) {
+    std::mt19937 rng(6502);
+    std::vector<Byte> operands(count);
+    for (Byte& operand : operands)
+        operand = rng() & mask;
+    return operands;
+}
+
+// Best of Repeats runs, in ns per operation. Each add feeds the next one
+// through A and the carry, as a chain of ADCs would.
+template <Alu A, bool Decimal = false>
+double TimeAdd(std::vector<Byte> const& operands, u32& checksum) {
+    double best = 1e9;
+    for (int repeat = 0; repeat < Repeats; ++repeat) {
+        Byte a = 0, flags = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (Byte operand : operands) {
+            const AluResult sum = Decimal ? AddDecimal<A>(a, operand, flags & CarryFlag)
+                                          : Add<A>(a, operand, flags & CarryFlag);
+            a = sum.Result;
+            flags = sum.Flags;
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = std::min(best, seconds * 1e9 / operands.size());
+        checksum += a + flags;
+    }
+    return best;
+}
+
+template <Alu A>
+double TimeCompare(std::vector<Byte> const& operands, u32& checksum) {
+    double best = 1e9;
+    for (int repeat = 0; repeat < Repeats; ++repeat) {
+        Byte reg = 0x80, flags = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (Byte operand : operands) {
+            flags ^= Compare<A>(reg, operand);
+            reg += flags;
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = std::min(best, seconds * 1e9 / operands.size());
+        checksum += reg + flags;
+    }
+    return best;
+}
+
+void Report(const char* stream, std::vector<Byte> const& operands, u32& checksum) {
+    const double addArithmetic = TimeAdd<Alu::Arithmetic>(operands, checksum);
+    const double addTable = TimeAdd<Alu::Table>(operands, checksum);
+    const double decimalArithmetic = TimeAdd<Alu::Arithmetic, true>(operands, checksum);
+    const double decimalTable = TimeAdd<Alu::Table, true>(operands, checksum);
+    const double compareArithmetic = TimeCompare<Alu::Arithmetic>(operands, checksum);
+    const double compareTable = TimeCompare<Alu::Table>(operands, checksum);
+    printf("%-8s %-8s %10.2f %10.2f %9.2fx\n", stream, "add", addArithmetic, addTable, addArithmetic / addTable);
+    printf("%-8s %-8s %10.2f %10.2f %9.2fx\n", stream, "decimal", decimalArithmetic, decimalTable, decimalArithmetic / decimalTable);
+    printf("%-8s %-8s %10.2f %10.2f %9.2fx\n", stream, "compare", compareArithmetic, compareTable, compareArithmetic / compareTable);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const u32 count = (argc > 1 ? atoi(argv[1]) : 20) * 1000000u;
+
+    u32 checksum = 0;
+    printf("%-8s %-8s %10s %10s %10s\n", "operands", "op", "arith ns", "table ns", "vs arith");
+    Report("random", Operands(count, 0xFF), checksum);
+    Report("narrow", Operands(count, 0x0F), checksum);
+    printf("\nchecksum %08x\n", checksum);
+    return 0;
+}
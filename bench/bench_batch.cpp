@@ -0,0 +1,100 @@
+// Runs one program on many inputs, as a parameter sweep does: once as
+// separate CPUs, and once as a CPUBatch whose lanes step in lockstep.
+// Configure with -DCP6502_AVX2=ON to pack 32 lanes a register instead of 16.
+// Configure with -DCMAKE_BUILD_TYPE=Release for meaningful numbers.
+//
+// usage: bench_batch [cycles per lane]
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+
+#include "../core/cp6502.hpp"
+#include "../core/batch.hpp"
+
+using namespace cp6502;
+
+namespace {
+
+constexpr u32 Lanes = 32;
+constexpr int Repeats = 3;
+
+// Mixes the two input bytes at $10/$11 with $12, forever
+Byte Program[] = {
+    0x00, 0x10,
+    0xA2, 0x00,         // $1000 LDX #0
+    0xA5, 0x10,         // $1002 LDA $10
+    0x69, 0x3B,         // $1004 ADC #$3B
+    0x45, 0x11,         // $1006 EOR $11
+    0x0A,               // $1008 ASL A
+    0x26, 0x12,         // $1009 ROL $12
+    0x85, 0x10,         // $100B STA $10
+    0xE5, 0x12,         // $100D SBC $12
+    0x85, 0x11,         // $100F STA $11
+    0xE8,               // $1011 INX
+    0xD0, 0xEE,         // $1012 BNE $1002
+    0x4C, 0x00, 0x10,   // $1014 JMP $1000
+};
+
+Mem Memory[Lanes];
+
+void LoadLane(u32 lane, CPU& cpu) {
+    cpu.Reset(0xFF00, Memory[lane]);
+    cpu.PC = cpu.LoadProg(Program, sizeof(Program), Memory[lane]);
+    Memory[lane][0x10] = lane;
+    Memory[lane][0x11] = lane * 7;
+}
+
+u32 Checksum() {
+    u32 sum = 0;
+    for (u32 lane = 0; lane < Lanes; ++lane)
+        sum = sum * 31 + Memory[lane][0x10] + Memory[lane][0x11] + Memory[lane][0x12];
+    return sum;
+}
+
+template <typename RunFn>
+double Time(RunFn run, u32& checksum) {
+    double best = 1e9;
+    for (int repeat = 0; repeat < Repeats; ++repeat) {
+        const auto start = std::chrono::steady_clock::now();
+        run();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        checksum = Checksum();
+    }
+    return best;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const s32 cycles = argc > 1 ? atoi(argv[1]) : 2000000;
+
+    u32 separateChecksum = 0, batchChecksum = 0;
+    const double separate = Time([cycles] {
+        for (u32 lane = 0; lane < Lanes; ++lane) {
+            CPU cpu;
+            LoadLane(lane, cpu);
+            cpu.Execute(cycles, Memory[lane]);
+        }
+    }, separateChecksum);
+
+    static CPUBatch<Lanes> batch;
+    const double lockstep = Time([cycles] {
+        for (u32 lane = 0; lane < Lanes; ++lane) {
+            CPU cpu;
+            LoadLane(lane, cpu);
+            batch.Load(lane, cpu, Memory[lane]);
+        }
+        batch.Execute(cycles);
+    }, batchChecksum);
+
+    printf("%u lanes, %d cycles each, %u lanes a register\n\n", Lanes, cycles, packed::Widest::WIDTH);
+    printf("%-10s %10s %10s\n", "run", "seconds", "speedup");
+    printf("%-10s %10.3f %9.2fx\n", "separate", separate, 1.0);
+    printf("%-10s %10.3f %9.2fx\n", "lockstep", lockstep, separate / lockstep);
+    if (separateChecksum != batchChecksum) {
+        printf("lanes disagree with separate CPUs: %08x vs %08x\n", batchChecksum, separateChecksum);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,175 @@
+// Runs Klaus Dormann's 6502 functional test under each interpreter
+// configuration and reports emulated MIPS.
+// Configure with -DCMAKE_BUILD_TYPE=Release for meaningful numbers.
+//
+// usage: bench_cp6502 [passes] [path/to/6502_functional_test.bin]
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+
+#include "../core/cp6502.hpp"
+#include "../core/blockcache.hpp"
+#include "../core/bus.hpp"
+#include "../core/profiler.hpp"
+#include "../core/scheduler.hpp"
+#include "../core/trace.hpp"
+#include "../core/tracefile.hpp"
+#if defined(CP6502_JIT)
+#include "../core/jit.hpp"
+#endif
+
+using namespace cp6502;
+
+namespace {
+
+constexpr Word ImageLoadAddress = 0x000A;
+constexpr Word StartAddress = 0x0400;
+constexpr Word SuccessTrap = 0x3699;    // "jmp *" reached once every test passed
+
+struct Workload {
+    Mem image;
+    long long instructions = 0;
+    s32 cycles = 0;
+};
+
+bool LoadImage(const char* path, Mem& image) {
+    image.Initialise();
+    FILE* fp = fopen(path, "rb");
+    if (!fp)
+        return false;
+    const size_t size = Mem::MAX_MEM - ImageLoadAddress;
+    const bool ok = fread(&image[ImageLoadAddress], 1, size, fp) == size;
+    fclose(fp);
+    return ok;
+}
+
+// Single-steps one pass to learn its instruction and cycle counts.
+bool Calibrate(Workload& w) {
+    static Mem memory;
+    CPU cpu;
+    cpu.Reset(StartAddress, memory);
+    memory = w.image;
+    while (cpu.PC != SuccessTrap) {
+        w.cycles += cpu.Execute(1, memory);
+        ++w.instructions;
+        if (w.cycles < 0)
+            return false;
+    }
+    return true;
+}
+
+// The bus a BasicCPU<BusT> runs the workload on, backed by memory
+template <typename BusT>
+BusT& BusOver(Mem& memory);
+
+template <>
+Mem& BusOver<Mem>(Mem& memory) {
+    return memory;
+}
+
+template <>
+Bus& BusOver<Bus>(Mem& memory) {
+    static Bus bus;
+    bus.MapRam(0x00, Bus::NUM_PAGES, memory.Data);
+    return bus;
+}
+
+// execute(cpu, cycles, bus) runs one pass; the fastest counts, as the one
+// least disturbed by the rest of the machine
+template <typename BusT = Mem, Timing T = DefaultTiming, typename ExecuteFn>
+double Run(Workload const& w, int passes, ExecuteFn execute) {
+    static Mem memory;
+    BusT& bus = BusOver<BusT>(memory);
+    BasicCPU<BusT, T> cpu;
+    double seconds = 1e9;
+    for (int pass = 0; pass < passes; ++pass) {
+        cpu.Reset(StartAddress, bus);
+        memory = w.image;
+        const auto start = std::chrono::steady_clock::now();
+        execute(cpu, w.cycles, bus);
+        seconds = std::min(seconds, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        if (cpu.PC != SuccessTrap) {
+            printf("pass %d stopped at 0x%04x instead of the success trap\n", pass, cpu.PC);
+            exit(1);
+        }
+    }
+    return w.instructions / seconds / 1e6;
+}
+
+void Report(const char* name, double mips, double baseline) {
+    printf("%-10s %10.1f %9.2fx\n", name, mips, mips / baseline);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int passes = argc > 1 ? atoi(argv[1]) : 5;
+    const char* path = argc > 2 ? argv[2] : CP6502_STEST_DIR "/6502_functional_test.bin";
+
+    static Workload w;
+    if (!LoadImage(path, w.image)) {
+        printf("cannot read %s\n", path);
+        return 1;
+    }
+    if (!Calibrate(w)) {
+        printf("functional test did not reach the success trap\n");
+        return 1;
+    }
+    printf("%lld instructions, %d cycles per pass, %d passes\n\n", w.instructions, w.cycles, passes);
+
+    printf("%-10s %10s %10s\n", "dispatch", "MIPS", "vs switch");
+    const double baseline = Run(w, passes, [](CPU& cpu, s32 cycles, Mem& memory) {
+        cpu.Execute<Dispatch::Switch>(cycles, memory);
+    });
+    Report("switch", baseline, baseline);
+    Report("table", Run(w, passes, [](CPU& cpu, s32 cycles, Mem& memory) {
+        cpu.Execute<Dispatch::Table>(cycles, memory);
+    }), baseline);
+#if CP6502_HAS_COMPUTED_GOTO
+    Report("threaded", Run(w, passes, [](CPU& cpu, s32 cycles, Mem& memory) {
+        cpu.Execute<Dispatch::Threaded>(cycles, memory);
+    }), baseline);
+#endif
+    Report("per-instr", Run<Mem, Timing::PerInstruction>(w, passes, [](BasicCPU<Mem, Timing::PerInstruction>& cpu, s32 cycles, Mem& memory) {
+        cpu.Execute(cycles, memory);
+    }), baseline);
+    Report("bus", Run<Bus>(w, passes, [](BasicCPU<Bus>& cpu, s32 cycles, Bus& bus) {
+        cpu.Execute(cycles, bus);
+    }), baseline);
+    // A device event every 1000 cycles, about 1000 a second at 1 MHz
+    Report("events", Run(w, passes, [](CPU& cpu, s32 cycles, Mem& memory) {
+        static Scheduler scheduler;
+        u32 fired = 0;
+        const u32 timer = scheduler.Every(1000, [&](u64) { ++fired; });
+        cpu.Execute(cycles, memory, scheduler);
+        scheduler.Cancel(timer);
+    }), baseline);
+    static TraceRing trace;
+    Report("traced", Run(w, passes, [](CPU& cpu, s32 cycles, Mem& memory) {
+        cpu.Execute(cycles, memory, trace);
+    }), baseline);
+    // The whole run delta-encoded into a temporary file by a second thread
+    Report("streamed", Run(w, passes, [](CPU& cpu, s32 cycles, Mem& memory) {
+        FILE* file = tmpfile();
+        TraceWriter writer(file);
+        cpu.Execute(cycles, memory, writer);
+        writer.Close();
+        fclose(file);
+    }), baseline);
+    static Profiler profiler;
+    Report("profiled", Run(w, passes, [](CPU& cpu, s32 cycles, Mem& memory) {
+        cpu.Execute(cycles, memory, profiler);
+    }), baseline);
+    static BlockCache cache;
+    Report("blocks", Run(w, passes, [](CPU& cpu, s32 cycles, Mem& memory) {
+        cpu.Execute(cycles, memory, cache);
+    }), baseline);
+#if defined(CP6502_JIT)
+    static Jit jit;
+    Report("jit", Run(w, passes, [](CPU& cpu, s32 cycles, Mem& memory) {
+        cpu.Execute(cycles, memory, jit);
+    }), baseline);
+#endif
+    return 0;
+}
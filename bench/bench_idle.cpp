@@ -0,0 +1,65 @@
+// Times a program that spends most of its cycles polling a flag that a
+// scheduled device event sets every so often, as code waiting on I/O does,
+// and reports emulated MHz. The busy row adds an INX to the polling loop,
+// which keeps it from being skipped as idle.
+// Configure with -DCMAKE_BUILD_TYPE=Release for meaningful numbers.
+//
+// usage: bench_idle [period in cycles between events]
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+
+#include "../core/cp6502.hpp"
+#include "../core/scheduler.hpp"
+
+using namespace cp6502;
+
+namespace {
+
+constexpr Word Start = 0x0200;
+constexpr Byte Flag = 0x10;
+constexpr Byte Count = 0x11;
+constexpr s32 Cycles = 200'000'000;
+
+// poll: [INX] LDA flag / BEQ poll, then count the event, clear the flag and go back
+std::vector<Byte> Program(bool busy) {
+    std::vector<Byte> code;
+    if (busy)
+        code.push_back(CPU::INS_INX);
+    code.insert(code.end(), { CPU::INS_LDA_ZP, Flag, CPU::INS_BEQ, Byte(busy ? -5 : -4),
+                              CPU::INS_INC_ZP, Count, CPU::INS_LDA_IM, 0x00, CPU::INS_STA_ZP, Flag,
+                              CPU::INS_JMP_ABS, Start & 0xFF, Start >> 8 });
+    return code;
+}
+
+double Run(bool busy, u64 period, u64& skipped) {
+    static Mem memory;
+    CPU cpu;
+    cpu.Reset(Start, memory);
+    Word address = Start;
+    for (Byte value : Program(busy))
+        memory[address++] = value;
+    Scheduler scheduler;
+    scheduler.Every(period, [&](u64) { memory[Flag] = 1; });
+
+    const auto start = std::chrono::steady_clock::now();
+    const s32 used = cpu.Execute(Cycles, memory, scheduler);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    skipped = cpu.IdleCyclesSkipped;
+    return used / seconds / 1e6;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const u64 period = argc > 1 ? atoll(argv[1]) : 1000;
+    printf("%d cycles, an event every %llu cycles\n\n", Cycles, period);
+    printf("%-6s %12s %10s %10s\n", "loop", "MHz", "vs busy", "skipped");
+    u64 busySkipped = 0, idleSkipped = 0;
+    const double busy = Run(true, period, busySkipped);
+    const double idle = Run(false, period, idleSkipped);
+    printf("%-6s %12.1f %9.2fx %9.1f%%\n", "busy", busy, 1.0, 100.0 * busySkipped / Cycles);
+    printf("%-6s %12.1f %9.2fx %9.1f%%\n", "idle", idle, idle / busy, 100.0 * idleSkipped / Cycles);
+    return 0;
+}
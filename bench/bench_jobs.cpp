@@ -0,0 +1,83 @@
+// Runs many short independent jobs: once each on a freshly allocated and
+// initialised Mem, as a process per job would, and then on a JobRunner with
+// 1, 2, 4, ... threads up to the hardware's. Configure with
+// -DCMAKE_BUILD_TYPE=Release for meaningful numbers.
+//
+// usage: bench_jobs [jobs] [cycles per job]
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "../core/cp6502.hpp"
+#include "../core/jobrunner.hpp"
+
+using namespace cp6502;
+
+namespace {
+
+constexpr int Repeats = 3;
+
+std::vector<JobRunner::Job> MakeJobs(u32 numJobs, s32 cycles) {
+    std::vector<JobRunner::Job> jobs(numJobs);
+    for (u32 i = 0; i < numJobs; ++i) {
+        jobs[i].Image = {
+            0x00, 0x10,
+            0xA2, Byte(i),      // $1000 LDX #i
+            0x8A,               // $1002 TXA
+            0x9D, 0x00, 0x20,   // $1003 STA $2000,X
+            0xE8,               // $1006 INX
+            0x4C, 0x02, 0x10,   // $1007 JMP $1002
+        };
+        jobs[i].Cpu.PC = 0x1000;
+        jobs[i].Cpu.SP = 0xFF;
+        jobs[i].Cycles = cycles;
+    }
+    return jobs;
+}
+
+template <typename RunFn>
+double Time(RunFn run) {
+    double best = 1e9;
+    for (int repeat = 0; repeat < Repeats; ++repeat) {
+        const auto start = std::chrono::steady_clock::now();
+        run();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const u32 numJobs = argc > 1 ? atoi(argv[1]) : 20000;
+    const s32 cycles = argc > 2 ? atoi(argv[2]) : 2000;
+    const std::vector<JobRunner::Job> jobs = MakeJobs(numJobs, cycles);
+
+    const double fresh = Time([&jobs] {
+        for (JobRunner::Job const& job : jobs) {
+            auto memory = std::make_unique<Mem>();
+            memory->Initialise();
+            CPU cpu = job.Cpu;
+            cpu.LoadProg(const_cast<Byte*>(job.Image.data()), job.Image.size(), *memory);
+            cpu.Execute(job.Cycles, *memory);
+        }
+    });
+
+    printf("%u jobs, %d cycles each\n\n", numJobs, cycles);
+    printf("%-12s %10s %12s %10s\n", "run", "seconds", "jobs/s", "speedup");
+    printf("%-12s %10.3f %12.0f %9.2fx\n", "fresh Mem", fresh, numJobs / fresh, 1.0);
+    const u32 maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (u32 threads = 1; threads <= maxThreads; threads *= 2) {
+        JobRunner runner(threads);
+        const double seconds = Time([&runner, &jobs] {
+            runner.Run(jobs);
+        });
+        char name[32];
+        snprintf(name, sizeof(name), "%u thread%s", threads, threads == 1 ? "" : "s");
+        printf("%-12s %10.3f %12.0f %9.2fx\n", name, seconds, numJobs / seconds, fresh / seconds);
+    }
+    return 0;
+}
@@ -0,0 +1,78 @@
+// Forks a machine state many times, as a fuzzer or search does: each fork
+// starts from the same CPU and memory and runs a short burst that writes a
+// couple of pages. The 64K copy row copies the whole Mem for each fork; the
+// snapshot row restores a Snapshot, copying only the pages the last fork
+// wrote. Configure with -DCMAKE_BUILD_TYPE=Release for meaningful numbers.
+//
+// usage: bench_snapshot [forks] [cycles per fork]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+
+#include "../core/cp6502.hpp"
+#include "../core/snapshot.hpp"
+
+using namespace cp6502;
+
+namespace {
+
+constexpr int Repeats = 3;
+
+template <typename RunFn>
+double Time(RunFn run) {
+    double best = 1e9;
+    for (int repeat = 0; repeat < Repeats; ++repeat) {
+        const auto start = std::chrono::steady_clock::now();
+        run();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const u32 forks = argc > 1 ? atoi(argv[1]) : 200000;
+    const s32 cycles = argc > 2 ? atoi(argv[2]) : 200;
+
+    static Mem parent;
+    parent.Initialise();
+    Byte prog[] = {
+        0x00, 0x10,
+        0xA2, 0x00,         // $1000 LDX #0
+        0x8A,               // $1002 TXA
+        0x9D, 0x00, 0x20,   // $1003 STA $2000,X
+        0xE8,               // $1006 INX
+        0x4C, 0x02, 0x10,   // $1007 JMP $1002
+    };
+    CPU parentCpu;
+    parentCpu.Reset(0x1000, parent);
+    parentCpu.LoadProg(prog, sizeof(prog), parent);
+
+    static Mem child;
+    CPU cpu;
+    const double copied = Time([&] {
+        for (u32 fork = 0; fork < forks; ++fork) {
+            memcpy(child.Data, parent.Data, Mem::MAX_MEM);
+            cpu = parentCpu;
+            cpu.Execute(cycles, child);
+        }
+    });
+
+    Snapshotter snapshotter;
+    const Snapshot snapshot = snapshotter.Take(parentCpu, parent);
+    const double restored = Time([&] {
+        for (u32 fork = 0; fork < forks; ++fork) {
+            snapshotter.Restore(snapshot, cpu, child);
+            cpu.Execute(cycles, child);
+        }
+    });
+
+    printf("%u forks, %d cycles each\n\n", forks, cycles);
+    printf("%-12s %10s %12s %10s\n", "fork", "seconds", "forks/s", "speedup");
+    printf("%-12s %10.3f %12.0f %9.2fx\n", "64K copy", copied, forks / copied, 1.0);
+    printf("%-12s %10.3f %12.0f %9.2fx\n", "snapshot", restored, forks / restored, copied / restored);
+    return 0;
+}
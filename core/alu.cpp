@@ -0,0 +1,36 @@
+#include "alu.hpp"
+
+namespace cp6502 {
+
+namespace {
+
+constexpr std::array<AluResult, 2 * 256 * 256> MakeAddTable() {
+    std::array<AluResult, 2 * 256 * 256> table{};
+    for (u32 i = 0; i < table.size(); ++i)
+        table[i] = AddArithmetic(i >> 8, i, i >> 16);
+    return table;
+}
+
+template <AluResult (*Fn)(Byte, Byte, Byte)>
+constexpr std::array<AluResult, 2 * 256 * 256> MakeDecimalTable() {
+    std::array<AluResult, 2 * 256 * 256> table{};
+    for (u32 i = 0; i < table.size(); ++i)
+        table[i] = Fn(i >> 8, i, i >> 16);
+    return table;
+}
+
+constexpr std::array<Byte, 256 * 256> MakeCompareTable() {
+    std::array<Byte, 256 * 256> table{};
+    for (u32 i = 0; i < table.size(); ++i)
+        table[i] = CompareArithmetic(i >> 8, i);
+    return table;
+}
+
+} // namespace
+
+constexpr std::array<AluResult, 2 * 256 * 256> AddTable = MakeAddTable();
+constexpr std::array<AluResult, 2 * 256 * 256> AddDecimalTable = MakeDecimalTable<AddDecimalArithmetic>();
+constexpr std::array<AluResult, 2 * 256 * 256> SubtractDecimalTable = MakeDecimalTable<SubtractDecimalArithmetic>();
+constexpr std::array<Byte, 256 * 256> CompareTable = MakeCompareTable();
+
+} // namespace cp6502
@@ -0,0 +1,117 @@
+#pragma once
+#include "cp6502.hpp"
+
+// The binary add and compare behind ADC, SBC (ADC of the complement) and
+// CMP/CPX/CPY, each computed one of two ways.
+namespace cp6502 {
+
+enum class Alu {
+    Arithmetic,     // compute result, carry and overflow from the operands
+    Table,          // look them up in tables built at compile time (alu.cpp)
+};
+
+// Set by the CP6502_ALU_TABLES CMake option
+#if defined(CP6502_ALU_TABLES)
+constexpr Alu DefaultAlu = Alu::Table;
+#else
+constexpr Alu DefaultAlu = Alu::Arithmetic;
+#endif
+
+// Decimal mode always looks its results up: unlike the binary add, the
+// digit adjustments branch on the data, and the tables win (bench_alu)
+constexpr Alu DecimalAlu = Alu::Table;
+
+struct AluResult {
+    Byte Result;
+    Byte Flags;     // C/Z/V/N, in their PS bit positions
+};
+
+constexpr AluResult AddArithmetic(Byte a, Byte operand, Byte carry) {
+    const Word sum = a + operand + carry;
+    const Byte result = sum & 0xFF;
+    Byte flags = (result & NegativeFlag) | (result == 0 ? ZeroFlag : 0) | (sum > 0xFF ? CarryFlag : 0);
+    // overflow: both operands have the same sign, but the result has a different one
+    if (~(a ^ operand) & (a ^ result) & NegativeFlag)
+        flags |= OverflowFlag;
+    return { result, flags };
+}
+
+// ADC with D set, as the NMOS 6502 does it. Result and carry are BCD for
+// BCD operands. Z comes from the binary sum; N and V from the sum after the
+// low digit is adjusted but before the high one is. Non-BCD operands give
+// the results an NMOS part gives.
+constexpr AluResult AddDecimalArithmetic(Byte a, Byte operand, Byte carry) {
+    s32 low = (a & 0x0F) + (operand & 0x0F) + carry;
+    if (low >= 0x0A)
+        low = ((low + 0x06) & 0x0F) + 0x10;
+    s32 sum = (a & 0xF0) + (operand & 0xF0) + low;
+    const s32 signedSum = static_cast<SByte>(a & 0xF0) + static_cast<SByte>(operand & 0xF0) + low;
+    Byte flags = (sum & NegativeFlag) | (signedSum < -128 || signedSum > 127 ? OverflowFlag : 0);
+    if (Byte(a + operand + carry) == 0)
+        flags |= ZeroFlag;
+    if (sum >= 0xA0)
+        sum += 0x60;
+    if (sum >= 0x100)
+        flags |= CarryFlag;
+    return { Byte(sum), flags };
+}
+
+// SBC with D set, as the NMOS 6502 does it: a BCD result, but every flag as
+// the binary subtraction sets it
+constexpr AluResult SubtractDecimalArithmetic(Byte a, Byte operand, Byte carry) {
+    s32 low = (a & 0x0F) - (operand & 0x0F) + carry - 1;
+    if (low < 0)
+        low = ((low - 0x06) & 0x0F) - 0x10;
+    s32 difference = (a & 0xF0) - (operand & 0xF0) + low;
+    if (difference < 0)
+        difference -= 0x60;
+    return { Byte(difference), AddArithmetic(a, ~operand, carry).Flags };
+}
+
+// C/Z/N of reg - operand
+constexpr Byte CompareArithmetic(Byte reg, Byte operand) {
+    const Byte diff = reg - operand;
+    return (diff & NegativeFlag) | (diff == 0 ? ZeroFlag : 0) | (reg >= operand ? CarryFlag : 0);
+}
+
+// Indexed by carry << 16 | a << 8 | operand
+extern const std::array<AluResult, 2 * 256 * 256> AddTable;
+// Indexed as AddTable
+extern const std::array<AluResult, 2 * 256 * 256> AddDecimalTable;
+extern const std::array<AluResult, 2 * 256 * 256> SubtractDecimalTable;
+// Indexed by reg << 8 | operand
+extern const std::array<Byte, 256 * 256> CompareTable;
+
+template <Alu A>
+inline AluResult Add(Byte a, Byte operand, Byte carry) {
+    if constexpr (A == Alu::Table)
+        return AddTable[carry << 16 | a << 8 | operand];
+    else
+        return AddArithmetic(a, operand, carry);
+}
+
+template <Alu A>
+inline AluResult AddDecimal(Byte a, Byte operand, Byte carry) {
+    if constexpr (A == Alu::Table)
+        return AddDecimalTable[carry << 16 | a << 8 | operand];
+    else
+        return AddDecimalArithmetic(a, operand, carry);
+}
+
+template <Alu A>
+inline AluResult SubtractDecimal(Byte a, Byte operand, Byte carry) {
+    if constexpr (A == Alu::Table)
+        return SubtractDecimalTable[carry << 16 | a << 8 | operand];
+    else
+        return SubtractDecimalArithmetic(a, operand, carry);
+}
+
+template <Alu A>
+inline Byte Compare(Byte reg, Byte operand) {
+    if constexpr (A == Alu::Table)
+        return CompareTable[reg << 8 | operand];
+    else
+        return CompareArithmetic(reg, operand);
+}
+
+} // namespace cp6502
@@ -0,0 +1,531 @@
+#pragma once
+#include <string.h>
+#include <array>
+
+#include "cp6502.hpp"
+#include "blockcache.hpp"
+#include "opcodes.hpp"
+#include "packed.hpp"
+
+// N independent CPUs, each with its own Mem, run in lockstep. The registers
+// are kept as structure of arrays (one array per register, indexed by lane)
+// and one Execute call drives the whole batch.
+//
+// Lanes running the same program usually sit at the same PC. Each step looks
+// up the basic block at the first running lane's PC in a BlockCache, and runs
+// its leading instructions that have a lockstep form on every lane that is
+// at that PC with the same code pages: each instruction is decoded once and
+// applied to all of them in packed byte registers (core/packed.hpp), 32 lanes
+// an AVX2 register or 16 an SSE2 one, with N/Z/C/V built as byte masks and
+// each lane's result blended in under its mask. Immediates are broadcast to
+// every lane; memory operands are gathered a byte per lane, as each lane has
+// its own Mem. The lockstep forms are the instructions with a fixed cycle
+// count: immediate, zero page and absolute operands, register transfers,
+// accumulator shifts, flag changes, plus branches and JMP. ADC and SBC in
+// decimal mode, the other lanes, and lanes whose budget could run out part
+// way, run one instruction through the interpreter per step.
+//
+// A lane stops when its budget runs out, as CPU::Execute does, or when it
+// reaches an opcode without a handler; it is then Halted with PC just past
+// that opcode, and the other lanes carry on.
+namespace cp6502::batch_detail {
+
+// Whether CPUBatch::Apply runs the opcode, from its mnemonic and mode
+constexpr bool HasLockstepForm(OpcodeInfo const& op) {
+    using opcodes_detail::IsOneOf;
+    switch (op.Mode) {
+        case AddrMode::Immediate:
+            return IsOneOf(op.Mnemonic, { "LDA", "LDX", "LDY", "AND", "EOR", "ORA", "ADC", "SBC", "CMP", "CPX", "CPY" });
+        case AddrMode::ZeroPage:
+        case AddrMode::Absolute:
+            return IsOneOf(op.Mnemonic, { "LDA", "LDX", "LDY", "STA", "STX", "STY", "AND", "EOR", "ORA", "BIT",
+                                          "ADC", "SBC", "CMP", "CPX", "CPY", "INC", "DEC",
+                                          "ASL", "LSR", "ROL", "ROR" })
+                || (op.Mode == AddrMode::Absolute && op.Mnemonic == "JMP");
+        case AddrMode::Accumulator:
+        case AddrMode::Relative:
+            return op.Implemented();
+        case AddrMode::Implied:
+            return IsOneOf(op.Mnemonic, { "TAX", "TAY", "TXA", "TYA", "TSX", "TXS", "INX", "DEX", "INY", "DEY",
+                                          "CLC", "CLV", "SEC", "NOP" });
+        default:
+            return false;
+    }
+}
+
+constexpr std::array<bool, 256> MakeLockstepForms() {
+    std::array<bool, 256> table{};
+    for (u32 opcode = 0; opcode < 256; ++opcode)
+        table[opcode] = HasLockstepForm(Opcodes[opcode]);
+    return table;
+}
+
+} // namespace cp6502::batch_detail
+
+template <cp6502::u32 N>
+struct cp6502::CPUBatch {
+    static constexpr u32 LANES = N;
+
+    // One byte per lane; 0xFF selects the lane, 0x00 leaves it alone
+    using Lanes = std::array<Byte, N>;
+
+    std::array<Word, N> PC = {};
+    std::array<Byte, N> SP = {};
+    std::array<Byte, N> A = {};
+    std::array<Byte, N> X = {};
+    std::array<Byte, N> Y = {};
+    std::array<Byte, N> PS = {};
+    std::array<s32, N> Cycles = {};     // budget left in the current Execute
+    std::array<bool, N> Halted = {};
+    std::array<Mem*, N> Memory = {};
+
+    BlockCache Cache;       // blocks of the first running lane's Mem
+    u32 VectorSteps = 0;    // steps that ran a group of lanes together
+
+    // As CPU::Reset, for one lane
+    void Reset(u32 lane, Word pc, Mem& memory) {
+        CPU cpu;
+        cpu.Reset(pc, memory);
+        Load(lane, cpu, memory);
+    }
+
+    void Load(u32 lane, CPU const& cpu, Mem& memory) {
+        PC[lane] = cpu.PC;
+        SP[lane] = cpu.SP;
+        A[lane] = cpu.A;
+        X[lane] = cpu.X;
+        Y[lane] = cpu.Y;
+        PS[lane] = cpu.PS;
+        Halted[lane] = false;
+        Memory[lane] = &memory;
+        CodeChecks = {};
+    }
+
+    // The lane as a CPU. Everything the batch does not keep per lane (the
+    // interrupt inputs, the idle-loop state) starts out zero, as after Reset.
+    CPU Lane(u32 lane) const {
+        CPU cpu{};
+        cpu.PC = PC[lane];
+        cpu.SP = SP[lane];
+        cpu.A = A[lane];
+        cpu.X = X[lane];
+        cpu.Y = Y[lane];
+        cpu.PS = PS[lane];
+        return cpu;
+    }
+
+    bool IsRunning(u32 lane) const {
+        return !Halted[lane] && Cycles[lane] > 0;
+    }
+
+    // Runs every lane for at least cycles, or until it halts. Afterwards
+    // cycles - Cycles[lane] is what the lane used, as CPU::Execute returns.
+    void Execute(s32 cycles) {
+        for (u32 lane = 0; lane < N; ++lane)
+            Cycles[lane] = Memory[lane] ? cycles : 0;
+        while (Step() > 0) {
+        }
+    }
+
+    // Runs a block on the lanes the leader can take along, and one instruction
+    // on each other lane with budget left. Returns how many lanes ran.
+    u32 Step() {
+        Lanes running;
+        for (u32 i = 0; i < N; ++i)
+            running[i] = (!Halted[i] && Cycles[i] > 0) ? 0xFF : 0x00;
+        u32 leader = 0;
+        while (leader < N && !running[leader])
+            ++leader;
+        if (leader == N)
+            return 0;
+
+        Lanes group = {};
+        if (StepGroup(leader, running, group))
+            ++VectorSteps;
+        u32 ran = 0;
+        for (u32 i = 0; i < N; ++i)
+            ran += running[i] & 1;
+        Byte rest = 0;
+        for (u32 i = 0; i < N; ++i)
+            rest |= running[i] & ~group[i];
+        if (rest) {
+            for (u32 lane = 0; lane < N; ++lane)
+                if (running[lane] & ~group[lane])
+                    StepLane(lane);
+        }
+        return ran;
+    }
+
+    // One instruction through the interpreter
+    void StepLane(u32 lane) {
+        CPU cpu = Lane(lane);
+        const ExecuteResult step = cpu.Execute(1, *Memory[lane]);
+        Cycles[lane] -= step.Cycles;
+        Halted[lane] = step.Reason == StopReason::IllegalOpcode || step.Reason == StopReason::Halt;
+        PC[lane] = cpu.PC;
+        SP[lane] = cpu.SP;
+        A[lane] = cpu.A;
+        X[lane] = cpu.X;
+        Y[lane] = cpu.Y;
+        PS[lane] = cpu.PS;
+    }
+
+    // Runs the lockstep prefix of the block at the leader's PC on every
+    // running lane at that PC with the same code pages and enough budget to
+    // finish it, setting their bytes in group. Returns false, with group
+    // clear, if fewer than two lanes qualify or the block does not start
+    // with a lockstep instruction.
+    bool StepGroup(u32 leader, Lanes const& running, Lanes& group) {
+        const Word pc = PC[leader];
+        BlockCache::Block const& block = Cache.Lookup(pc, *Memory[leader]);
+
+        // The prefix ends before the first instruction without a lockstep
+        // form, or after a store into the block's own pages
+        u32 count = 0;
+        s32 cycles = 0;
+        s32 budget = 0;     // cycles taken before the last instruction of the prefix
+        bool addsOrSubtracts = false;
+        while (count < block.Count) {
+            BlockCache::Instruction const& ins = block.Instructions[count];
+            if (!HasLockstepForm[ins.Opcode])
+                break;
+            budget = cycles;
+            cycles += ins.Cycles;
+            addsOrSubtracts |= IsAddOrSubtract(ins.Opcode);
+            ++count;
+            const u32 page = ins.Operand / Mem::PAGE_SIZE;
+            if (ins.Writes && page >= block.FirstPage && page <= block.LastPage)
+                break;
+        }
+        if (count == 0)
+            return false;
+
+        Lanes const& sameFirst = SameCode(leader, block.FirstPage);
+        Lanes const& sameLast = SameCode(leader, block.LastPage);
+        for (u32 i = 0; i < N; ++i)
+            group[i] = running[i] & sameFirst[i] & sameLast[i]
+                & (PC[i] == pc ? 0xFF : 0x00) & (Cycles[i] > budget ? 0xFF : 0x00);
+        // Decimal mode ADC/SBC stays with the interpreter
+        if (addsOrSubtracts)
+            for (u32 i = 0; i < N; ++i)
+                group[i] &= (PS[i] & DecimalFlag) ? 0x00 : 0xFF;
+        u32 members = 0;
+        for (u32 i = 0; i < N; ++i)
+            members += group[i] & 1;
+        if (members < 2) {
+            group = {};
+            return false;
+        }
+
+        Word at = pc;
+        for (u32 n = 0; n < count; ++n) {
+            BlockCache::Instruction const& ins = block.Instructions[n];
+            Apply(ins.Opcode, at, ins.Operand, group);
+            at += ins.Length;
+        }
+        if (!IsBranchOrJump(block.Instructions[count - 1].Opcode))
+            for (u32 i = 0; i < N; ++i)
+                PC[i] = group[i] ? at : PC[i];
+        for (u32 i = 0; i < N; ++i)
+            Cycles[i] -= group[i] ? cycles : 0;
+        return true;
+    }
+
+    // The opcodes Apply runs
+    static constexpr std::array<bool, 256> HasLockstepForm = batch_detail::MakeLockstepForms();
+
+    // Lanes whose copy of a page matched the leader's when checked, and the
+    // WriteGeneration each lane's copy had then. Direct-mapped on the page.
+    struct CodeCheck {
+        u32 Page = Mem::NUM_PAGES;
+        u32 Leader = 0;
+        std::array<u32, N> Generations = {};
+        Lanes Same = {};
+    };
+    static constexpr u32 CODE_CHECKS = 4;
+    std::array<CodeCheck, CODE_CHECKS> CodeChecks;
+
+    // Lanes whose page holds the same bytes as the leader's. Pages are
+    // compared again only after a write to them.
+    Lanes const& SameCode(u32 leader, u32 page) {
+        CodeCheck& check = CodeChecks[page % CODE_CHECKS];
+        const bool recheckAll = check.Page != page || check.Leader != leader
+            || Memory[leader]->WriteGeneration[page] != check.Generations[leader];
+        check.Page = page;
+        check.Leader = leader;
+        Byte const* expected = &Memory[leader]->Data[page * Mem::PAGE_SIZE];
+        for (u32 lane = 0; lane < N; ++lane) {
+            if (!Memory[lane]) {
+                check.Same[lane] = 0x00;
+                continue;
+            }
+            const u32 generation = Memory[lane]->WriteGeneration[page];
+            if (recheckAll || generation != check.Generations[lane]) {
+                const bool same = memcmp(&Memory[lane]->Data[page * Mem::PAGE_SIZE], expected, Mem::PAGE_SIZE) == 0;
+                check.Same[lane] = same ? 0xFF : 0x00;
+                check.Generations[lane] = generation;
+            }
+        }
+        return check.Same;
+    }
+
+    static constexpr bool IsAddOrSubtract(Byte opcode) {
+        return Opcodes[opcode].Mnemonic == "ADC" || Opcodes[opcode].Mnemonic == "SBC";
+    }
+
+    static constexpr bool IsBranchOrJump(Byte opcode) {
+        return Opcodes[opcode].Mode == AddrMode::Relative || opcode == CPU::INS_JMP_ABS;
+    }
+
+    // Lanes-wide kernels, each a generic lambda run a register of lanes at a
+    // time by packed::ForEachChunk. Results are blended in under the group
+    // mask, so unselected lanes keep their values.
+
+    // An instruction's operand on every lane: an immediate, broadcast to all
+    // of them, or one byte per lane gathered by Read or taken from a register
+    struct Operand {
+        Lanes const* Gathered = nullptr;
+        Byte Immediate = 0;
+
+        template <typename V>
+        typename V::Reg Get(V, u32 i) const {
+            return Gathered ? V::Load(&(*Gathered)[i]) : V::Splat(Immediate);
+        }
+    };
+
+    static Operand Broadcast(Byte value) {
+        return { nullptr, value };
+    }
+
+    static Operand Gather(Lanes const& value) {
+        return { &value, 0 };
+    }
+
+    template <typename V, typename R>
+    static void SetRegister(V, Lanes& reg, u32 i, R group, R value) {
+        V::Store(&reg[i], V::Select(group, value, V::Load(&reg[i])));
+    }
+
+    // Replaces the PS bits in mask with those of flags
+    template <typename V, typename R>
+    void SetFlags(V, u32 i, R group, Byte mask, R flags) {
+        V::Store(&PS[i], V::Select(V::And(group, V::Splat(mask)), flags, V::Load(&PS[i])));
+    }
+
+    void Blend(Lanes& reg, Operand const& value, Lanes const& group) {
+        packed::ForEachChunk<N>([&](auto v, u32 i) {
+            SetRegister(v, reg, i, v.Load(&group[i]), value.Get(v, i));
+        });
+    }
+
+    void BlendFlags(Byte mask, Byte flags, Lanes const& group) {
+        packed::ForEachChunk<N>([&](auto v, u32 i) {
+            SetFlags(v, i, v.Load(&group[i]), mask, v.Splat(flags));
+        });
+    }
+
+    void LoadRegister(Lanes& reg, Operand const& value, Lanes const& group) {
+        packed::ForEachChunk<N>([&](auto v, u32 i) {
+            const auto g = v.Load(&group[i]);
+            const auto x = value.Get(v, i);
+            SetRegister(v, reg, i, g, x);
+            SetFlags(v, i, g, ZeroFlag | NegativeFlag, v.ZN(x));
+        });
+    }
+
+    enum class Logic { AND, EOR, ORA };
+
+    void Logical(Logic logic, Operand const& value, Lanes const& group) {
+        packed::ForEachChunk<N>([&](auto v, u32 i) {
+            const auto g = v.Load(&group[i]);
+            const auto a = v.Load(&A[i]);
+            const auto x = value.Get(v, i);
+            const auto result = logic == Logic::AND ? v.And(a, x) : logic == Logic::EOR ? v.Xor(a, x) : v.Or(a, x);
+            SetRegister(v, A, i, g, result);
+            SetFlags(v, i, g, ZeroFlag | NegativeFlag, v.ZN(result));
+        });
+    }
+
+    // ADC, or with complement SBC: as CPU::SBC, add the complement
+    void Add(Operand const& value, bool complement, Lanes const& group) {
+        packed::ForEachChunk<N>([&](auto v, u32 i) {
+            const auto g = v.Load(&group[i]);
+            const auto x = value.Get(v, i);
+            const auto carry = v.And(v.Load(&PS[i]), v.Splat(CarryFlag));
+            auto flags = x;
+            const auto sum = v.AddWithCarry(v.Load(&A[i]), complement ? v.Not(x) : x, carry, flags);
+            SetRegister(v, A, i, g, sum);
+            SetFlags(v, i, g, CarryFlag | ZeroFlag | OverflowFlag | NegativeFlag, flags);
+        });
+    }
+
+    void Compare(Lanes const& reg, Operand const& value, Lanes const& group) {
+        packed::ForEachChunk<N>([&](auto v, u32 i) {
+            const auto flags = v.CompareFlags(v.Load(&reg[i]), value.Get(v, i));
+            SetFlags(v, i, v.Load(&group[i]), CarryFlag | ZeroFlag | NegativeFlag, flags);
+        });
+    }
+
+    void Bit(Operand const& value, Lanes const& group) {
+        packed::ForEachChunk<N>([&](auto v, u32 i) {
+            const auto x = value.Get(v, i);
+            const auto flags = v.Or(v.And(x, v.Splat(NegativeFlag | OverflowFlag)),
+                                    v.Flag(v.Equal(v.And(v.Load(&A[i]), x), v.Splat(0)), ZeroFlag));
+            SetFlags(v, i, v.Load(&group[i]), ZeroFlag | OverflowFlag | NegativeFlag, flags);
+        });
+    }
+
+    // INX/INY/INC with delta 1, DEX/DEY/DEC with 0xFF
+    void Increment(Lanes& reg, Byte delta, Lanes const& group) {
+        packed::ForEachChunk<N>([&](auto v, u32 i) {
+            const auto g = v.Load(&group[i]);
+            const auto result = v.Add(v.Load(&reg[i]), v.Splat(delta));
+            SetRegister(v, reg, i, g, result);
+            SetFlags(v, i, g, ZeroFlag | NegativeFlag, v.ZN(result));
+        });
+    }
+
+    enum class Shift { ASL, LSR, ROL, ROR };
+
+    // Shifts value in place, setting C/Z/N
+    void ShiftLanes(Shift shift, Lanes& value, Lanes const& group) {
+        packed::ForEachChunk<N>([&](auto v, u32 i) {
+            const auto g = v.Load(&group[i]);
+            const auto x = v.Load(&value[i]);
+            const auto carryIn = v.And(v.Load(&PS[i]), v.Splat(CarryFlag));
+            auto result = x;
+            auto carryOut = x;
+            if (shift == Shift::ASL || shift == Shift::ROL) {
+                result = v.Add(x, x);
+                if (shift == Shift::ROL)
+                    result = v.Or(result, carryIn);
+                carryOut = v.Flag(v.Negative(x), CarryFlag);
+            } else {
+                result = v.HalfRight(x);
+                if (shift == Shift::ROR)    // 0 - carry is 0xFF with carry set
+                    result = v.Or(result, v.And(v.Sub(v.Splat(0), carryIn), v.Splat(0x80)));
+                carryOut = v.And(x, v.Splat(CarryFlag));
+            }
+            SetRegister(v, value, i, g, result);
+            SetFlags(v, i, g, CarryFlag | ZeroFlag | NegativeFlag, v.Or(v.ZN(result), carryOut));
+        });
+    }
+
+    void Branch(Byte flag, bool ifSet, Word pc, Byte offset, Lanes const& group) {
+        const Word next = pc + 2;
+        const Word target = next + static_cast<SByte>(offset);
+        const s32 takenCycles = (target >> 8) != (next >> 8) ? 2 : 1;
+        for (u32 i = 0; i < N; ++i) {
+            const bool taken = group[i] && ((PS[i] & flag) != 0) == ifSet;
+            PC[i] = taken ? target : group[i] ? next : PC[i];
+            Cycles[i] -= taken ? takenCycles : 0;
+        }
+    }
+
+    // Each lane has its own Mem, so reads gather a byte per lane and writes
+    // scatter them, one lane at a time
+    Lanes Read(Word address, Lanes const& group) const {
+        Lanes value = {};
+        for (u32 i = 0; i < N; ++i)
+            if (group[i])
+                value[i] = Memory[i]->Read(address);
+        return value;
+    }
+
+    void Write(Word address, Lanes const& value, Lanes const& group) {
+        for (u32 i = 0; i < N; ++i)
+            if (group[i])
+                Memory[i]->Write(address, value[i]);
+    }
+
+    // Runs the instruction on the lanes in group, except for PC and the base
+    // cycles. False if it has no lockstep form.
+    bool Apply(Byte opcode, Word pc, Word operand, Lanes const& group) {
+        const Operand immediate = Broadcast(operand);
+        Lanes value;
+        switch (opcode) {
+            case CPU::INS_LDA_IM: LoadRegister(A, immediate, group); return true;
+            case CPU::INS_LDX_IM: LoadRegister(X, immediate, group); return true;
+            case CPU::INS_LDY_IM: LoadRegister(Y, immediate, group); return true;
+            case CPU::INS_LDA_ZP: case CPU::INS_LDA_ABS: value = Read(operand, group); LoadRegister(A, Gather(value), group); return true;
+            case CPU::INS_LDX_ZP: case CPU::INS_LDX_ABS: value = Read(operand, group); LoadRegister(X, Gather(value), group); return true;
+            case CPU::INS_LDY_ZP: case CPU::INS_LDY_ABS: value = Read(operand, group); LoadRegister(Y, Gather(value), group); return true;
+            case CPU::INS_STA_ZP: case CPU::INS_STA_ABS: Write(operand, A, group); return true;
+            case CPU::INS_STX_ZP: case CPU::INS_STX_ABS: Write(operand, X, group); return true;
+            case CPU::INS_STY_ZP: case CPU::INS_STY_ABS: Write(operand, Y, group); return true;
+
+            case CPU::INS_AND_IM: Logical(Logic::AND, immediate, group); return true;
+            case CPU::INS_EOR_IM: Logical(Logic::EOR, immediate, group); return true;
+            case CPU::INS_ORA_IM: Logical(Logic::ORA, immediate, group); return true;
+            case CPU::INS_AND_ZP: case CPU::INS_AND_ABS: value = Read(operand, group); Logical(Logic::AND, Gather(value), group); return true;
+            case CPU::INS_EOR_ZP: case CPU::INS_EOR_ABS: value = Read(operand, group); Logical(Logic::EOR, Gather(value), group); return true;
+            case CPU::INS_ORA_ZP: case CPU::INS_ORA_ABS: value = Read(operand, group); Logical(Logic::ORA, Gather(value), group); return true;
+            case CPU::INS_BIT_ZP: case CPU::INS_BIT_ABS: value = Read(operand, group); Bit(Gather(value), group); return true;
+
+            case CPU::INS_ADC_IM: Add(immediate, false, group); return true;
+            case CPU::INS_SBC_IM: Add(immediate, true, group); return true;
+            case CPU::INS_ADC_ZP: case CPU::INS_ADC_ABS: value = Read(operand, group); Add(Gather(value), false, group); return true;
+            case CPU::INS_SBC_ZP: case CPU::INS_SBC_ABS: value = Read(operand, group); Add(Gather(value), true, group); return true;
+            case CPU::INS_CMP_IM: Compare(A, immediate, group); return true;
+            case CPU::INS_CPX_IM: Compare(X, immediate, group); return true;
+            case CPU::INS_CPY_IM: Compare(Y, immediate, group); return true;
+            case CPU::INS_CMP_ZP: case CPU::INS_CMP_ABS: value = Read(operand, group); Compare(A, Gather(value), group); return true;
+            case CPU::INS_CPX_ZP: case CPU::INS_CPX_ABS: value = Read(operand, group); Compare(X, Gather(value), group); return true;
+            case CPU::INS_CPY_ZP: case CPU::INS_CPY_ABS: value = Read(operand, group); Compare(Y, Gather(value), group); return true;
+
+            case CPU::INS_TAX: LoadRegister(X, Gather(A), group); return true;
+            case CPU::INS_TAY: LoadRegister(Y, Gather(A), group); return true;
+            case CPU::INS_TXA: LoadRegister(A, Gather(X), group); return true;
+            case CPU::INS_TYA: LoadRegister(A, Gather(Y), group); return true;
+            case CPU::INS_TSX: LoadRegister(X, Gather(SP), group); return true;
+            case CPU::INS_TXS: Blend(SP, Gather(X), group); return true;
+            case CPU::INS_INX: Increment(X, 1, group); return true;
+            case CPU::INS_INY: Increment(Y, 1, group); return true;
+            case CPU::INS_DEX: Increment(X, 0xFF, group); return true;
+            case CPU::INS_DEY: Increment(Y, 0xFF, group); return true;
+            case CPU::INS_INC_ZP: case CPU::INS_INC_ABS: case CPU::INS_DEC_ZP: case CPU::INS_DEC_ABS: {
+                const Byte delta = (opcode == CPU::INS_INC_ZP || opcode == CPU::INS_INC_ABS) ? 1 : 0xFF;
+                value = Read(operand, group);
+                Increment(value, delta, group);
+                Write(operand, value, group);
+                return true;
+            }
+
+            case CPU::INS_ASL_ACC: ShiftLanes(Shift::ASL, A, group); return true;
+            case CPU::INS_LSR_ACC: ShiftLanes(Shift::LSR, A, group); return true;
+            case CPU::INS_ROL_ACC: ShiftLanes(Shift::ROL, A, group); return true;
+            case CPU::INS_ROR_ACC: ShiftLanes(Shift::ROR, A, group); return true;
+            case CPU::INS_ASL_ZP: case CPU::INS_ASL_ABS:
+            case CPU::INS_LSR_ZP: case CPU::INS_LSR_ABS:
+            case CPU::INS_ROL_ZP: case CPU::INS_ROL_ABS:
+            case CPU::INS_ROR_ZP: case CPU::INS_ROR_ABS: {
+                // aaa of the aaabbbcc opcode layout picks the shift
+                constexpr Shift shifts[] = { Shift::ASL, Shift::ROL, Shift::LSR, Shift::ROR };
+                value = Read(operand, group);
+                ShiftLanes(shifts[opcode >> 5], value, group);
+                Write(operand, value, group);
+                return true;
+            }
+
+            case CPU::INS_CLC: BlendFlags(CarryFlag, 0, group); return true;
+            case CPU::INS_CLV: BlendFlags(OverflowFlag, 0, group); return true;
+            case CPU::INS_SEC: BlendFlags(CarryFlag, CarryFlag, group); return true;
+            case CPU::INS_NOP: return true;
+
+            case CPU::INS_BPL: Branch(NegativeFlag, false, pc, operand, group); return true;
+            case CPU::INS_BMI: Branch(NegativeFlag, true, pc, operand, group); return true;
+            case CPU::INS_BVC: Branch(OverflowFlag, false, pc, operand, group); return true;
+            case CPU::INS_BVS: Branch(OverflowFlag, true, pc, operand, group); return true;
+            case CPU::INS_BCC: Branch(CarryFlag, false, pc, operand, group); return true;
+            case CPU::INS_BCS: Branch(CarryFlag, true, pc, operand, group); return true;
+            case CPU::INS_BNE: Branch(ZeroFlag, false, pc, operand, group); return true;
+            case CPU::INS_BEQ: Branch(ZeroFlag, true, pc, operand, group); return true;
+            case CPU::INS_JMP_ABS:
+                for (u32 i = 0; i < N; ++i)
+                    PC[i] = group[i] ? operand : PC[i];
+                return true;
+            default:
+                return false;
+        }
+    }
+};
@@ -0,0 +1,140 @@
+#include "blockcache.hpp"
+#include "opcodes.hpp"
+
+#include <algorithm>
+
+namespace cp6502 {
+
+namespace {
+
+template <CPU::Handler Handler>
+void InvokeDecoded(CPU& cpu, s32& cycles, Mem& memory, Word operand) {
+    (cpu.*Handler)(cycles, memory, operand);
+}
+
+constexpr std::array<CPU::DecodedHandler, 256> MakeHandlerTable() {
+    std::array<CPU::DecodedHandler, 256> table{};
+#define CP6502_HANDLER_ENTRY(name, mode, baseCycles) \
+    table[CPU::INS_##name] = &InvokeDecoded<&CPU::Op_##name>;
+    CP6502_OPCODES(CP6502_HANDLER_ENTRY)
+#undef CP6502_HANDLER_ENTRY
+    return table;
+}
+
+constexpr std::array<CPU::DecodedHandler, 256> Handlers = MakeHandlerTable();
+
+} // namespace
+
+BlockCache::BlockCache() : Index(Mem::MAX_MEM, 0) {
+}
+
+void BlockCache::Flush() {
+    Blocks.clear();
+    std::fill(Index.begin(), Index.end(), 0);
+    Memory = nullptr;
+}
+
+BlockCache::Block& BlockCache::Lookup(Word pc, Mem const& memory) {
+    if (Memory != &memory) {
+        Flush();
+        Memory = &memory;
+    }
+    u32& slot = Index[pc];
+    if (slot == 0) {
+        Blocks.emplace_back();
+        slot = Blocks.size();
+        Decode(Blocks.back(), pc, memory);
+    } else if (!IsCurrent(Blocks[slot - 1], memory)) {
+        Decode(Blocks[slot - 1], pc, memory);
+    }
+    return Blocks[slot - 1];
+}
+
+void BlockCache::Decode(Block& block, Word pc, Mem const& memory) {
+    ++Decodes;
+    block.Start = pc;
+    block.FirstPage = pc >> 8;
+    block.LastPage = block.FirstPage;
+    block.Cycles = 0;
+    block.WorstCaseCycles = 0;
+    block.Count = 0;
+    block.Executions = 0;
+    block.Native = nullptr;
+
+    s32 worstCaseCycles = 0;
+    while (block.Count < MAX_INSTRUCTIONS) {
+        const Byte opcode = memory[pc];
+        OpcodeInfo const& info = Opcodes[opcode];
+        if (!info.Implemented())
+            break;
+
+        Instruction& ins = block.Instructions[block.Count++];
+        ins.Handler = Handlers[opcode];
+        ins.Opcode = opcode;
+        ins.Length = info.Length;
+        ins.Cycles = info.Cycles;
+        ins.Writes = info.Writes;
+        ins.Operand = 0;
+        if (ins.Length >= 2)
+            ins.Operand = memory[Word(pc + 1)];
+        if (ins.Length == 3)
+            ins.Operand |= memory[Word(pc + 2)] << 8;
+
+        block.Cycles += ins.Cycles;
+        block.WorstCaseCycles = worstCaseCycles;
+        worstCaseCycles += ins.Cycles + info.PenaltyCycles;
+
+        block.LastPage = Word(pc + ins.Length - 1) >> 8;
+        pc += ins.Length;
+        if (info.EndsBlock || (pc >> 8) != block.FirstPage)
+            break;
+    }
+
+    block.FirstGeneration = memory.WriteGeneration[block.FirstPage];
+    block.LastGeneration = memory.WriteGeneration[block.LastPage];
+}
+
+void BlockCache::Run(Block const& block, CPU& cpu, s32& cycles, Mem& memory) const {
+    // With enough budget left the block cannot run out part way through
+    const bool checkBudget = cycles <= block.WorstCaseCycles;
+    for (u32 i = 0; i < block.Count; ++i) {
+        Instruction const& ins = block.Instructions[i];
+        cpu.PC += ins.Length;
+        cpu.CountOpcode(ins.Opcode);
+        // The handler charges no cycles for fetching the bytes it was decoded from
+        if constexpr (CPU::CycleTiming == Timing::PerInstruction)
+            cycles -= ins.Cycles;
+        else
+            cycles -= ins.Length;
+        ins.Handler(cpu, cycles, memory, ins.Operand);
+        // Stop if the instruction wrote over the code of this block
+        if (ins.Writes && !IsCurrent(block, memory))
+            break;
+        if (checkBudget && cycles <= 0)
+            break;
+    }
+}
+
+template <>
+ExecuteResult CPU::Execute(s32 cycles, Mem& memory, BlockCache& cache) {
+    const s32 cyclesRequested = cycles;
+    LoadFlags();
+    Idle.Armed = false;
+    Stop = StopReason::Budget;
+    while (cycles > 0) {
+        BlockCache::Block const& block = cache.Lookup(PC, memory);
+        if (block.Count == 0) {
+            SyncFlags();
+            const ExecuteResult step = Execute(1, memory);
+            cycles -= step.Cycles;
+            if (step.Reason != StopReason::Budget)
+                return { cyclesRequested - cycles, step.Reason, PC };
+            LoadFlags();
+        } else {
+            cache.Run(block, *this, cycles, memory);
+        }
+    }
+    return EndExecute(cyclesRequested, cycles);
+}
+
+} // namespace cp6502
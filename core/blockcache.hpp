@@ -0,0 +1,68 @@
+#pragma once
+#include <vector>
+
+#include "cp6502.hpp"
+
+// Cache of pre-decoded basic blocks, keyed by the PC of their first
+// instruction. A block runs straight-line code up to and including the first
+// branch, jump, call, return or BRK, and never starts a new instruction
+// outside the page it began in.
+//
+// Each block remembers Mem::WriteGeneration of the (at most two) pages its
+// bytes live in. A store into one of those pages makes the block stale; it is
+// re-decoded the next time it is looked up, while blocks on other pages stay
+// valid. Use with CPU::Execute(cycles, memory, cache).
+struct cp6502::BlockCache {
+    static constexpr u32 MAX_INSTRUCTIONS = 16;
+
+    struct Instruction {
+        CPU::DecodedHandler Handler;
+        Word Operand;
+        Byte Opcode;
+        Byte Length;
+        Byte Cycles;    // base cycle count
+        bool Writes;    // may store to memory
+    };
+
+    struct Block {
+        Word Start;
+        Byte FirstPage;
+        Byte LastPage;
+        u32 FirstGeneration;
+        u32 LastGeneration;
+        s32 Cycles;             // sum of the base cycle counts
+        s32 WorstCaseCycles;    // bound on the cycles taken before the last instruction
+        u32 Count;              // 0 when PC holds an opcode without a handler
+        u32 Executions;         // times run since decoded
+        void const* Native;     // translated code, see jit.hpp
+        Instruction Instructions[MAX_INSTRUCTIONS];
+    };
+
+    BlockCache();
+
+    // Returns the block starting at pc, decoding it if it is missing or stale.
+    Block& Lookup(Word pc, Mem const& memory);
+
+    // Interprets the block, stopping early if the budget runs out or the
+    // block stores over its own code.
+    void Run(Block const& block, CPU& cpu, s32& cycles, Mem& memory) const;
+
+    bool IsCurrent(Block const& block, Mem const& memory) const {
+        return memory.WriteGeneration[block.FirstPage] == block.FirstGeneration
+            && memory.WriteGeneration[block.LastPage] == block.LastGeneration;
+    }
+
+    void Flush();
+
+    u32 NumBlocks() const {
+        return Blocks.size();
+    }
+
+    void Decode(Block& block, Word pc, Mem const& memory);
+
+    u32 Decodes = 0;    // blocks decoded since construction, including re-decodes
+
+    std::vector<Block> Blocks;
+    std::vector<u32> Index;     // PC -> 1 + position in Blocks, 0 if never decoded
+    Mem const* Memory = nullptr;
+};
@@ -0,0 +1,95 @@
+#pragma once
+#include "cp6502.hpp"
+
+// A 64K address space split into 256 pages, each mapped to RAM, ROM or an
+// I/O device. Run a BasicCPU<Bus> on it to emulate a board with devices.
+//
+// RAM and ROM pages are reached through plain page pointers, so a read or
+// write to them is one table load and one indexed access; only device pages
+// pay for a virtual call. Writes to ROM and to unmapped pages are dropped,
+// and unmapped pages read as zero.
+namespace cp6502 {
+
+// Memory-mapped I/O. Gets the full address, so one device can serve
+// several pages or registers.
+struct Device {
+    virtual ~Device() = default;
+    virtual Byte Read(Word address) = 0;
+    virtual void Write(Word address, Byte value) = 0;
+};
+
+}
+
+struct cp6502::Bus {
+    static constexpr u32 MAX_MEM = 1024 * 64;
+    static constexpr u32 PAGE_SIZE = 256;
+    static constexpr u32 NUM_PAGES = MAX_MEM / PAGE_SIZE;
+
+    Bus() {
+        Unmap(0, NUM_PAGES);
+    }
+    Bus(Bus const&) = delete;
+    Bus& operator=(Bus const&) = delete;
+
+    // data holds numPages * PAGE_SIZE bytes, for the pages from firstPage on
+    void MapRam(u32 firstPage, u32 numPages, Byte* data) {
+        for (u32 i = 0; i < numPages; ++i)
+            SetPage(firstPage + i, data + i * PAGE_SIZE, data + i * PAGE_SIZE, nullptr);
+    }
+
+    void MapRom(u32 firstPage, u32 numPages, Byte const* data) {
+        for (u32 i = 0; i < numPages; ++i)
+            SetPage(firstPage + i, data + i * PAGE_SIZE, Discard, nullptr);
+    }
+
+    void MapDevice(u32 firstPage, u32 numPages, Device& device) {
+        for (u32 i = 0; i < numPages; ++i)
+            SetPage(firstPage + i, nullptr, nullptr, &device);
+    }
+
+    void Unmap(u32 firstPage, u32 numPages) {
+        for (u32 i = 0; i < numPages; ++i)
+            SetPage(firstPage + i, Unmapped, Discard, nullptr);
+    }
+
+    // Clears the mapped RAM, as CPU::Reset does for Mem
+    void Initialise() {
+        for (u32 page = 0; page < NUM_PAGES; ++page)
+            if (WritePages[page] && WritePages[page] != Discard)
+                memset(WritePages[page], 0, PAGE_SIZE);
+    }
+
+    Byte Read(u32 address) const {
+        Byte const* page = ReadPages[address / PAGE_SIZE];
+        if (page) [[likely]]
+            return page[address % PAGE_SIZE];
+        return Devices[address / PAGE_SIZE]->Read(address);
+    }
+
+    void Write(u32 address, Byte value) {
+        Byte* page = WritePages[address / PAGE_SIZE];
+        if (page) [[likely]]
+            page[address % PAGE_SIZE] = value;
+        else
+            Devices[address / PAGE_SIZE]->Write(address, value);
+    }
+
+    bool IsDevicePage(u32 page) const {
+        return Devices[page] != nullptr;
+    }
+
+    void SetPage(u32 page, Byte const* read, Byte* write, Device* device) {
+        ReadPages[page] = read;
+        WritePages[page] = write;
+        Devices[page] = device;
+    }
+
+    Byte const* ReadPages[NUM_PAGES];   // nullptr for device pages
+    Byte* WritePages[NUM_PAGES];        // nullptr for device pages, Discard for ROM
+    Device* Devices[NUM_PAGES];
+    Byte Unmapped[PAGE_SIZE] = {};
+    Byte Discard[PAGE_SIZE];
+};
+
+extern template struct cp6502::BasicCPU<cp6502::Bus, cp6502::Timing::PerAccess>;
+extern template struct cp6502::BasicCPU<cp6502::Bus, cp6502::Timing::PerInstruction>;
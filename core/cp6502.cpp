@@ -1,816 +1,1420 @@
 #include "cp6502.hpp"
+#include "alu.hpp"
+#include "bus.hpp"
+#include "opcodes.hpp"
+#include "profiler.hpp"
+#include "trace.hpp"
+#include "tracefile.hpp"
 
 namespace cp6502 {
 
-Word CPU::LoadProg(Byte* prog, u32 numBytes, Mem& memory) {
+u64 OpcodeCounts::Instructions() const {
+    u64 total = 0;
+    for (u64 count : Executed)
+        total += count;
+    return total;
+}
+
+u64 OpcodeCounts::InMode(AddrMode mode) const {
+    u64 total = 0;
+    for (u32 opcode = 0; opcode < 256; ++opcode)
+        if (Opcodes[opcode].Implemented() && Opcodes[opcode].Mode == mode)
+            total += Executed[opcode];
+    return total;
+}
+
+template <typename BusT, Timing T>
+Word BasicCPU<BusT, T>::LoadProg(Byte* prog, u32 numBytes, BusT& memory) {
     if (prog) {
         u32 at = 0;
         Word loadAddr = prog[at++] | (prog[at++] << 8);
         for (Word i = loadAddr; i < loadAddr + numBytes - 2; ++i)
-            memory[i] = prog[at++];
+            memory.Write(i, prog[at++]);
         return loadAddr;
     }
     return 0;
 }
 
-s32 CPU::Execute(s32 cycles, Mem& memory) {
-    auto LoadRegister = [&cycles, &memory, this](Word addr, Byte& reg) {
-        reg = ReadByte(cycles, addr, memory);
-        LoadRegisterSetStatus(reg);
-    };
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::LoadRegister(s32& cycles, Word addr, Byte& reg, BusT const& memory) {
+    reg = ReadByte(cycles, addr, memory);
+    LoadRegisterSetStatus(reg);
+}
 
-    auto And = [&cycles, &memory, this](Word addr) {
-        A &= ReadByte(cycles, addr, memory);
-        LoadRegisterSetStatus(A);
-    };
-    auto Eor = [&cycles, &memory, this](Word addr) {
-        A ^= ReadByte(cycles, addr, memory);
-        LoadRegisterSetStatus(A);
-    };
-    auto Ora = [&cycles, &memory, this](Word addr) {
-        A |= ReadByte(cycles, addr, memory);
-        LoadRegisterSetStatus(A);
-    };
-    auto Bit = [&cycles, &memory, this](Word addr) {
-        Byte value = ReadByte(cycles, addr, memory);
-        Z = (A & value) == 0;
-        N = (value >> 7) & 1;
-        V = (value >> 6) & 1;
-    };
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::And(s32& cycles, Word addr, BusT const& memory) {
+    A &= ReadByte(cycles, addr, memory);
+    LoadRegisterSetStatus(A);
+}
 
-    auto Inc = [&cycles, &memory, this](Word addr) {
-        Byte value = ReadByte(cycles, addr, memory);
-        WriteByte(++value, cycles, addr, memory);
-        LoadRegisterSetStatus(value);
-    };
-    auto Dec = [&cycles, &memory, this](Word addr) {
-        Byte value = ReadByte(cycles, addr, memory);
-        WriteByte(--value, cycles, addr, memory);
-        LoadRegisterSetStatus(value);
-    };
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Eor(s32& cycles, Word addr, BusT const& memory) {
+    A ^= ReadByte(cycles, addr, memory);
+    LoadRegisterSetStatus(A);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Ora(s32& cycles, Word addr, BusT const& memory) {
+    A |= ReadByte(cycles, addr, memory);
+    LoadRegisterSetStatus(A);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Bit(s32& cycles, Word addr, BusT const& memory) {
+    Byte value = ReadByte(cycles, addr, memory);
+    SetZN(A & value, value);
+    SetV((value >> 6) & 1);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Inc(s32& cycles, Word addr, BusT& memory) {
+    Byte value = ReadByte(cycles, addr, memory);
+    WriteByte(++value, cycles, addr, memory);
+    LoadRegisterSetStatus(value);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Dec(s32& cycles, Word addr, BusT& memory) {
+    Byte value = ReadByte(cycles, addr, memory);
+    WriteByte(--value, cycles, addr, memory);
+    LoadRegisterSetStatus(value);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::BranchIf(s32& cycles, BusT const& memory, bool condition, Byte offset) {
+    if (condition)
+    {
+        const Word oldPC = PC;
+        PC += static_cast<SByte>(offset);
+        SpendExtra(cycles);
+        const bool pageChanged = (PC >> 8) != (oldPC >> 8);
+        if (pageChanged)
+            SpendExtra(cycles);
+        CountBranch(true, pageChanged);
+        if (PC == Word(oldPC - 2) && StopOnTrap)
+            StopAt(cycles, StopReason::Trap);
+        else if (PC < oldPC)
+            JumpedBack(cycles, memory, oldPC);
+    }
+    else
+    {
+        // Falling out of the loop: whatever runs next may change memory
+        Idle.Armed = false;
+        CountBranch(false, false);
+    }
+}
 
-    auto BranchIf = [&cycles, &memory, this](auto predicate) {
-        Byte offset = FetchByte(cycles, memory);
-        if (predicate())
-        {
-            const Word oldPC = PC;
-            PC += static_cast<SByte>(offset);
-            cycles--;
-            const bool pageChanged = (PC >> 8) != (oldPC >> 8);
-            if (pageChanged)
-                cycles--;
+template <typename BusT, Timing T>
+bool BasicCPU<BusT, T>::IsIdleCandidate(Word start, Word end, BusT const& memory) const {
+    if (end - start > MAX_IDLE_LOOP)
+        return false;
+    Word pc = start;
+    while (pc < end) {
+        OpcodeInfo const& info = Opcodes[memory.Read(pc)];
+        if (!info.Implemented())
+            return false;
+        const Word next = pc + info.Length;
+        if (next == end)
+            return info.Mode == AddrMode::Relative || memory.Read(pc) == INS_JMP_ABS;
+        if (info.Writes || info.EndsBlock)
+            return false;
+        // A device can answer differently each time it is read, so on a bus
+        // with devices the loop may only read RAM and ROM pages
+        if constexpr (!std::is_same_v<BusT, Mem>) {
+            const Word operand = memory.Read(Word(pc + 1)) | memory.Read(Word(pc + 2)) << 8;
+            switch (info.Mode) {
+                case AddrMode::Implied:
+                case AddrMode::Accumulator:
+                case AddrMode::Immediate:
+                    break;
+                case AddrMode::ZeroPage:
+                case AddrMode::ZeroPageX:
+                case AddrMode::ZeroPageY:
+                    if (memory.IsDevicePage(0))
+                        return false;
+                    break;
+                case AddrMode::Absolute:
+                    if (memory.IsDevicePage(operand >> 8))
+                        return false;
+                    break;
+                case AddrMode::AbsoluteX:
+                case AddrMode::AbsoluteY:
+                    // Either page the index can reach
+                    if (memory.IsDevicePage(operand >> 8) || memory.IsDevicePage(Word(operand + 0xFF) >> 8))
+                        return false;
+                    break;
+                default:
+                    // Where an indirect read lands is not known up front
+                    return false;
+            }
         }
-    };
+        pc = next;
+    }
+    return false;
+}
 
-    auto ADC = [this](Byte operand) {
-        if (D) printf("Decimal not implemented\n");
-        Byte ASign = (A & NegativeFlag);
-        Byte operandSign = (operand & NegativeFlag);
-        Word sum = A;
-        sum += C;
-        sum += operand;
-        A = (sum & 0xFF);
-        C = sum > 0xFF;
-        Z = (A == 0);
-        // overflow:
-        // two operand have same sign, but the result has different sign
-        V = (ASign == operandSign) && ((A & NegativeFlag) != ASign);
-        N = (A & NegativeFlag) > 0;
-    };
+// Called once PC has jumped back to the start of a loop ending at end. Takes
+// the registers on each trip round; when one trip leaves them as they were,
+// every later trip will too, so all the whole trips that fit in the budget,
+// bar the last, are charged at once. The last runs as usual, so Execute stops
+// at the same instruction and cycle count as it would have without skipping.
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::JumpedBack(s32& cycles, BusT const& memory, Word end) {
+    if (PC != Idle.Start || end != Idle.End) {
+        Idle.Start = PC;
+        Idle.End = end;
+        Idle.Candidate = IsIdleCandidate(PC, end, memory);
+        Idle.Armed = false;
+    }
+    if (!Idle.Candidate)
+        return;
+    SyncFlags();
+    if (!Idle.Armed) {
+        // The code may have changed since it was last looked at
+        Idle.Candidate = IsIdleCandidate(PC, end, memory);
+        Idle.Armed = Idle.Candidate;
+    } else if (A == Idle.A && X == Idle.X && Y == Idle.Y && SP == Idle.SP && PS == Idle.PS) {
+        const s32 perTrip = Idle.Cycles - cycles;
+        if (perTrip > 0 && cycles > perTrip) {
+            const s32 skipped = (cycles - 1) / perTrip * perTrip;
+            cycles -= skipped;
+            IdleCyclesSkipped += skipped;
+        }
+    }
+    Idle.A = A;
+    Idle.X = X;
+    Idle.Y = Y;
+    Idle.SP = SP;
+    Idle.PS = PS;
+    Idle.Cycles = cycles;
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::ADC(Byte operand) {
+    const AluResult sum = D ? AddDecimal<DecimalAlu>(A, operand, GetC())
+                            : Add<DefaultAlu>(A, operand, GetC());
+    A = sum.Result;
+    SetFlags(CarryFlag | ZeroFlag | OverflowFlag | NegativeFlag, sum.Flags);
+}
 
-    auto SBC = [ADC](Byte operand) {
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::SBC(Byte operand) {
+    if (!D) {
         ADC(~operand);
-    };
+        return;
+    }
+    const AluResult difference = SubtractDecimal<DecimalAlu>(A, operand, GetC());
+    A = difference.Result;
+    SetFlags(CarryFlag | ZeroFlag | OverflowFlag | NegativeFlag, difference.Flags);
+}
 
-    auto Compare = [this](Byte operand, Byte reg) {
-        Byte diff = reg - operand;
-        C = reg >= operand;
-        Z = reg == operand;
-        N = (diff & NegativeFlag) > 0;
-    };
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Compare(Byte operand, Byte reg) {
+    SetFlags(CarryFlag | ZeroFlag | NegativeFlag, cp6502::Compare<DefaultAlu>(reg, operand));
+}
 
-    auto ASL = [&cycles, this](Byte operand) {
-        Byte result = operand << 1;
-        C = (operand & NegativeFlag) >> 7;
-        Z = result == 0;
-        N = (result & NegativeFlag) >> 7;
-        --cycles;
-        return result;
-    };
-    auto LSR = [&cycles, this](Byte operand) {
-        Byte result = operand >> 1;
-        C = (operand & 0b00000001) > 0;
-        Z = result == 0;
-        N = false;
-        --cycles;
-        return result;
-    };
-    auto ROL = [&cycles, this](Byte operand) {
-        Byte result = operand << 1;
-        result |= (C & 0b00000001);
-        C = (operand & NegativeFlag) >> 7;
-        Z = result == 0;
-        N = (result & NegativeFlag) >> 7;
-        --cycles;
-        return result;
-    };
-    auto ROR = [&cycles, this](Byte operand) {
-        Byte result = operand >> 1;
-        result |= (C << 7);
-        C = (operand & 0b00000001);
-        Z = result == 0;
-        N = (result & NegativeFlag) >> 7;
-        --cycles;
-        return result;
-    };
-    auto PushPSToStack = [&cycles, &memory, this]() {
-        Byte PSStack = PS | BreakFlag | UnusedFlag;
-        PushByteOntoStack(cycles, PSStack, memory);
-    };
-    auto PopPSFromStack = [&cycles, &memory, this]() {
-        PS = PopByteFromStack(cycles, memory);
-        B = false;
-        Unused = false;
+template <typename BusT, Timing T>
+Byte BasicCPU<BusT, T>::ASL(s32& cycles, Byte operand) {
+    Byte result = operand << 1;
+    SetC((operand & NegativeFlag) >> 7);
+    LoadRegisterSetStatus(result);
+    Spend(cycles);
+    return result;
+}
+
+template <typename BusT, Timing T>
+Byte BasicCPU<BusT, T>::LSR(s32& cycles, Byte operand) {
+    Byte result = operand >> 1;
+    SetC((operand & 0b00000001) > 0);
+    LoadRegisterSetStatus(result);
+    Spend(cycles);
+    return result;
+}
+
+template <typename BusT, Timing T>
+Byte BasicCPU<BusT, T>::ROL(s32& cycles, Byte operand) {
+    Byte result = operand << 1;
+    result |= (GetC() & 0b00000001);
+    SetC((operand & NegativeFlag) >> 7);
+    LoadRegisterSetStatus(result);
+    Spend(cycles);
+    return result;
+}
+
+template <typename BusT, Timing T>
+Byte BasicCPU<BusT, T>::ROR(s32& cycles, Byte operand) {
+    Byte result = operand >> 1;
+    result |= (GetC() << 7);
+    SetC(operand & 0b00000001);
+    LoadRegisterSetStatus(result);
+    Spend(cycles);
+    return result;
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::PushPSToStack(s32& cycles, BusT& memory) {
+    SyncFlags();
+    Byte PSStack = PS | BreakFlag | UnusedFlag;
+    PushByteOntoStack(cycles, PSStack, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::PopPSFromStack(s32& cycles, BusT& memory) {
+    PS = PopByteFromStack(cycles, memory);
+    B = false;
+    Unused = false;
+    LoadFlags();
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_LDA_IM(s32& cycles, BusT& memory, Word operand) {
+    A = operand;
+    LoadRegisterSetStatus(A);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_LDX_IM(s32& cycles, BusT& memory, Word operand) {
+    X = operand;
+    LoadRegisterSetStatus(X);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_LDY_IM(s32& cycles, BusT& memory, Word operand) {
+    Y = operand;
+    LoadRegisterSetStatus(Y);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_LDA_ZP(s32& cycles, BusT& memory, Word operand) {
+    LoadRegister(cycles, operand, A, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_LDX_ZP(s32& cycles, BusT& memory, Word operand) {
+    LoadRegister(cycles, operand, X, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_LDY_ZP(s32& cycles, BusT& memory, Word operand) {
+    LoadRegister(cycles, operand, Y, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_LDA_ZPX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrZeroPageXY(cycles, operand, X);
+    LoadRegister(cycles, addr, A, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_LDX_ZPY(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrZeroPageXY(cycles, operand, Y);
+    LoadRegister(cycles, addr, X, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_LDY_ZPX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrZeroPageXY(cycles, operand, X);
+    LoadRegister(cycles, addr, Y, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_LDA_ABS(s32& cycles, BusT& memory, Word operand) {
+    LoadRegister(cycles, operand, A, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_LDX_ABS(s32& cycles, BusT& memory, Word operand) {
+    LoadRegister(cycles, operand, X, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_LDY_ABS(s32& cycles, BusT& memory, Word operand) {
+    LoadRegister(cycles, operand, Y, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_LDA_ABSX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrAbsoluteXY(cycles, operand, X);
+    LoadRegister(cycles, addr, A, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_LDA_ABSY(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrAbsoluteXY(cycles, operand, Y);
+    LoadRegister(cycles, addr, A, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_LDX_ABSY(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrAbsoluteXY(cycles, operand, Y);
+    LoadRegister(cycles, addr, X, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_LDY_ABSX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrAbsoluteXY(cycles, operand, X);
+    LoadRegister(cycles, addr, Y, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_LDA_INDX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrIndirectX(cycles, operand, memory);
+    A = ReadByte(cycles, addr, memory);
+    LoadRegisterSetStatus(A);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_LDA_INDY(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrIndirectY(cycles, operand, memory);
+    A = ReadByte(cycles, addr, memory);
+    LoadRegisterSetStatus(A);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_STA_ZP(s32& cycles, BusT& memory, Word operand) {
+    WriteByte(A, cycles, operand, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_STX_ZP(s32& cycles, BusT& memory, Word operand) {
+    WriteByte(X, cycles, operand, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_STY_ZP(s32& cycles, BusT& memory, Word operand) {
+    WriteByte(Y, cycles, operand, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_STA_ABS(s32& cycles, BusT& memory, Word operand) {
+    WriteByte(A, cycles, operand, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_STX_ABS(s32& cycles, BusT& memory, Word operand) {
+    WriteByte(X, cycles, operand, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_STY_ABS(s32& cycles, BusT& memory, Word operand) {
+    WriteByte(Y, cycles, operand, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_STA_ZPX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrZeroPageXY(cycles, operand, X);
+    WriteByte(A, cycles, addr, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_STX_ZPY(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrZeroPageXY(cycles, operand, Y);
+    WriteByte(X, cycles, addr, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_STY_ZPX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrZeroPageXY(cycles, operand, X);
+    WriteByte(Y, cycles, addr, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_STA_ABSX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrAbsoluteXY_5(cycles, operand, X);
+    WriteByte(A, cycles, addr, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_STA_ABSY(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrAbsoluteXY_5(cycles, operand, Y);
+    WriteByte(A, cycles, addr, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_STA_INDX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrIndirectX(cycles, operand, memory);
+    WriteByte(A, cycles, addr, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_STA_INDY(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrIndirectY_6(cycles, operand, memory);
+    WriteByte(A, cycles, addr, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_JSR(s32& cycles, BusT& memory, Word operand) {
+    PushPCMinusOneToStack(cycles, memory);
+    // PushPCToStack(cycles, memory);
+    PC = operand;
+    Spend(cycles);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_RTS(s32& cycles, BusT& memory, Word operand) {
+    Word retAddrMinusOne = PopWordFromStack(cycles, memory);
+    PC = retAddrMinusOne + 1;
+    Spend(cycles, 2);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_JMP_ABS(s32& cycles, BusT& memory, Word operand) {
+    const Word end = PC;
+    PC = operand;
+    if (PC == Word(end - 3) && StopOnTrap)
+        StopAt(cycles, StopReason::Trap);
+    else if (PC < end)
+        JumpedBack(cycles, memory, end);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_JMP_IND(s32& cycles, BusT& memory, Word operand) {
+    PC = ReadWord(cycles, operand, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_TSX(s32& cycles, BusT& memory, Word operand) {
+    X = SP;
+    Spend(cycles);
+    LoadRegisterSetStatus(X);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_TXS(s32& cycles, BusT& memory, Word operand) {
+    SP = X;
+    Spend(cycles);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_PHA(s32& cycles, BusT& memory, Word operand) {
+    PushByteOntoStack(cycles, A, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_PLA(s32& cycles, BusT& memory, Word operand) {
+    A = PopByteFromStack(cycles, memory);
+    LoadRegisterSetStatus(A);
+    Spend(cycles);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_PHP(s32& cycles, BusT& memory, Word operand) {
+    PushPSToStack(cycles, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_PLP(s32& cycles, BusT& memory, Word operand) {
+    PopPSFromStack(cycles, memory);
+    Spend(cycles);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_AND_IM(s32& cycles, BusT& memory, Word operand) {
+    A = A & operand;
+    LoadRegisterSetStatus(A);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_EOR_IM(s32& cycles, BusT& memory, Word operand) {
+    A = A ^ operand;
+    LoadRegisterSetStatus(A);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_ORA_IM(s32& cycles, BusT& memory, Word operand) {
+    A = A | operand;
+    LoadRegisterSetStatus(A);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_AND_ZP(s32& cycles, BusT& memory, Word operand) {
+    And(cycles, operand, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_EOR_ZP(s32& cycles, BusT& memory, Word operand) {
+    Eor(cycles, operand, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_ORA_ZP(s32& cycles, BusT& memory, Word operand) {
+    Ora(cycles, operand, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_AND_ZPX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrZeroPageXY(cycles, operand, X);
+    And(cycles, addr, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_EOR_ZPX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrZeroPageXY(cycles, operand, X);
+    Eor(cycles, addr, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_ORA_ZPX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrZeroPageXY(cycles, operand, X);
+    Ora(cycles, addr, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_AND_ABS(s32& cycles, BusT& memory, Word operand) {
+    And(cycles, operand, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_EOR_ABS(s32& cycles, BusT& memory, Word operand) {
+    Eor(cycles, operand, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_ORA_ABS(s32& cycles, BusT& memory, Word operand) {
+    Ora(cycles, operand, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_AND_ABSX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrAbsoluteXY(cycles, operand, X);
+    And(cycles, addr, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_EOR_ABSX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrAbsoluteXY(cycles, operand, X);
+    Eor(cycles, addr, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_ORA_ABSX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrAbsoluteXY(cycles, operand, X);
+    Ora(cycles, addr, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_AND_ABSY(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrAbsoluteXY(cycles, operand, Y);
+    And(cycles, addr, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_EOR_ABSY(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrAbsoluteXY(cycles, operand, Y);
+    Eor(cycles, addr, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_ORA_ABSY(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrAbsoluteXY(cycles, operand, Y);
+    Ora(cycles, addr, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_AND_INDX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrIndirectX(cycles, operand, memory);
+    And(cycles, addr, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_EOR_INDX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrIndirectX(cycles, operand, memory);
+    Eor(cycles, addr, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_ORA_INDX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrIndirectX(cycles, operand, memory);
+    Ora(cycles, addr, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_AND_INDY(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrIndirectY(cycles, operand, memory);
+    And(cycles, addr, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_EOR_INDY(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrIndirectY(cycles, operand, memory);
+    Eor(cycles, addr, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_ORA_INDY(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrIndirectY(cycles, operand, memory);
+    Ora(cycles, addr, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_BIT_ZP(s32& cycles, BusT& memory, Word operand) {
+    Bit(cycles, operand, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_BIT_ABS(s32& cycles, BusT& memory, Word operand) {
+    Bit(cycles, operand, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_TAX(s32& cycles, BusT& memory, Word operand) {
+    X = A;
+    LoadRegisterSetStatus(X);
+    Spend(cycles);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_TAY(s32& cycles, BusT& memory, Word operand) {
+    Y = A;
+    LoadRegisterSetStatus(Y);
+    Spend(cycles);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_TXA(s32& cycles, BusT& memory, Word operand) {
+    A = X;
+    LoadRegisterSetStatus(A);
+    Spend(cycles);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_TYA(s32& cycles, BusT& memory, Word operand) {
+    A = Y;
+    LoadRegisterSetStatus(A);
+    Spend(cycles);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_INX(s32& cycles, BusT& memory, Word operand) {
+    ++X;
+    LoadRegisterSetStatus(X);
+    Spend(cycles);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_INY(s32& cycles, BusT& memory, Word operand) {
+    ++Y;
+    LoadRegisterSetStatus(Y);
+    Spend(cycles);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_DEX(s32& cycles, BusT& memory, Word operand) {
+    --X;
+    LoadRegisterSetStatus(X);
+    Spend(cycles);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_DEY(s32& cycles, BusT& memory, Word operand) {
+    --Y;
+    LoadRegisterSetStatus(Y);
+    Spend(cycles);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_INC_ZP(s32& cycles, BusT& memory, Word operand) {
+    Inc(cycles, operand, memory);
+    Spend(cycles);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_INC_ZPX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrZeroPageXY(cycles, operand, X);
+    Inc(cycles, addr, memory);
+    Spend(cycles);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_INC_ABS(s32& cycles, BusT& memory, Word operand) {
+    Inc(cycles, operand, memory);
+    Spend(cycles);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_INC_ABSX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrAbsoluteXY_5(cycles, operand, X);
+    Inc(cycles, addr, memory);
+    Spend(cycles);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_DEC_ZP(s32& cycles, BusT& memory, Word operand) {
+    Dec(cycles, operand, memory);
+    Spend(cycles);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_DEC_ZPX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrZeroPageXY(cycles, operand, X);
+    Dec(cycles, addr, memory);
+    Spend(cycles);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_DEC_ABS(s32& cycles, BusT& memory, Word operand) {
+    Dec(cycles, operand, memory);
+    Spend(cycles);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_DEC_ABSX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrAbsoluteXY_5(cycles, operand, X);
+    Dec(cycles, addr, memory);
+    Spend(cycles);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_BEQ(s32& cycles, BusT& memory, Word operand) {
+    BranchIf(cycles, memory, GetZ(), operand);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_BNE(s32& cycles, BusT& memory, Word operand) {
+    BranchIf(cycles, memory, !GetZ(), operand);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_BCC(s32& cycles, BusT& memory, Word operand) {
+    BranchIf(cycles, memory, !GetC(), operand);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_BCS(s32& cycles, BusT& memory, Word operand) {
+    BranchIf(cycles, memory, GetC(), operand);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_BMI(s32& cycles, BusT& memory, Word operand) {
+    BranchIf(cycles, memory, GetN(), operand);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_BPL(s32& cycles, BusT& memory, Word operand) {
+    BranchIf(cycles, memory, !GetN(), operand);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_BVS(s32& cycles, BusT& memory, Word operand) {
+    BranchIf(cycles, memory, GetV(), operand);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_BVC(s32& cycles, BusT& memory, Word operand) {
+    BranchIf(cycles, memory, !GetV(), operand);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_CLC(s32& cycles, BusT& memory, Word operand) {
+    SetC(0);
+    Spend(cycles);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_CLD(s32& cycles, BusT& memory, Word operand) {
+    D = 0;
+    Spend(cycles);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_CLI(s32& cycles, BusT& memory, Word operand) {
+    I = 0;
+    Spend(cycles);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_CLV(s32& cycles, BusT& memory, Word operand) {
+    SetV(0);
+    Spend(cycles);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_SEC(s32& cycles, BusT& memory, Word operand) {
+    SetC(1);
+    Spend(cycles);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_SED(s32& cycles, BusT& memory, Word operand) {
+    D = 1;
+    Spend(cycles);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_SEI(s32& cycles, BusT& memory, Word operand) {
+    I = 1;
+    Spend(cycles);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_NOP(s32& cycles, BusT& memory, Word operand) {
+    Spend(cycles);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_ADC_IM(s32& cycles, BusT& memory, Word operand) {
+    ADC(operand);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_ADC_ZP(s32& cycles, BusT& memory, Word operand) {
+    Byte value = ReadByte(cycles, operand, memory);
+    ADC(value);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_ADC_ZPX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrZeroPageXY(cycles, operand, X);
+    Byte value = ReadByte(cycles, addr, memory);
+    ADC(value);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_ADC_ABS(s32& cycles, BusT& memory, Word operand) {
+    Byte value = ReadByte(cycles, operand, memory);
+    ADC(value);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_ADC_ABSX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrAbsoluteXY(cycles, operand, X);
+    Byte value = ReadByte(cycles, addr, memory);
+    ADC(value);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_ADC_ABSY(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrAbsoluteXY(cycles, operand, Y);
+    Byte value = ReadByte(cycles, addr, memory);
+    ADC(value);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_ADC_INDX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrIndirectX(cycles, operand, memory);
+    Byte value = ReadByte(cycles, addr, memory);
+    ADC(value);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_ADC_INDY(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrIndirectY(cycles, operand, memory);
+    Byte value = ReadByte(cycles, addr, memory);
+    ADC(value);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_CMP_IM(s32& cycles, BusT& memory, Word operand) {
+    Compare(operand, A);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_CMP_ZP(s32& cycles, BusT& memory, Word operand) {
+    Byte value = ReadByte(cycles, operand, memory);
+    Compare(value, A);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_CMP_ZPX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrZeroPageXY(cycles, operand, X);
+    Byte value = ReadByte(cycles, addr, memory);
+    Compare(value, A);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_CMP_ABS(s32& cycles, BusT& memory, Word operand) {
+    Byte value = ReadByte(cycles, operand, memory);
+    Compare(value, A);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_CMP_ABSX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrAbsoluteXY(cycles, operand, X);
+    Byte value = ReadByte(cycles, addr, memory);
+    Compare(value, A);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_CMP_ABSY(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrAbsoluteXY(cycles, operand, Y);
+    Byte value = ReadByte(cycles, addr, memory);
+    Compare(value, A);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_CMP_INDX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrIndirectX(cycles, operand, memory);
+    Byte value = ReadByte(cycles, addr, memory);
+    Compare(value, A);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_CMP_INDY(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrIndirectY(cycles, operand, memory);
+    Byte value = ReadByte(cycles, addr, memory);
+    Compare(value, A);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_CPX_IM(s32& cycles, BusT& memory, Word operand) {
+    Compare(operand, X);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_CPX_ZP(s32& cycles, BusT& memory, Word operand) {
+    Byte value = ReadByte(cycles, operand, memory);
+    Compare(value, X);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_CPX_ABS(s32& cycles, BusT& memory, Word operand) {
+    Byte value = ReadByte(cycles, operand, memory);
+    Compare(value, X);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_CPY_IM(s32& cycles, BusT& memory, Word operand) {
+    Compare(operand, Y);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_CPY_ZP(s32& cycles, BusT& memory, Word operand) {
+    Byte value = ReadByte(cycles, operand, memory);
+    Compare(value, Y);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_CPY_ABS(s32& cycles, BusT& memory, Word operand) {
+    Byte value = ReadByte(cycles, operand, memory);
+    Compare(value, Y);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_SBC_IM(s32& cycles, BusT& memory, Word operand) {
+    SBC(operand);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_SBC_ZP(s32& cycles, BusT& memory, Word operand) {
+    Byte value = ReadByte(cycles, operand, memory);
+    SBC(value);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_SBC_ZPX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrZeroPageXY(cycles, operand, X);
+    Byte value = ReadByte(cycles, addr, memory);
+    SBC(value);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_SBC_ABS(s32& cycles, BusT& memory, Word operand) {
+    Byte value = ReadByte(cycles, operand, memory);
+    SBC(value);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_SBC_ABSX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrAbsoluteXY(cycles, operand, X);
+    Byte value = ReadByte(cycles, addr, memory);
+    SBC(value);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_SBC_ABSY(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrAbsoluteXY(cycles, operand, Y);
+    Byte value = ReadByte(cycles, addr, memory);
+    SBC(value);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_SBC_INDX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrIndirectX(cycles, operand, memory);
+    Byte value = ReadByte(cycles, addr, memory);
+    SBC(value);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_SBC_INDY(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrIndirectY(cycles, operand, memory);
+    Byte value = ReadByte(cycles, addr, memory);
+    SBC(value);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_ASL_ACC(s32& cycles, BusT& memory, Word operand) {
+    A = ASL(cycles, A);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_ASL_ZP(s32& cycles, BusT& memory, Word operand) {
+    Byte value = ReadByte(cycles, operand, memory);
+    WriteByte(ASL(cycles, value), cycles, operand, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_ASL_ZPX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrZeroPageXY(cycles, operand, X);
+    Byte value = ReadByte(cycles, addr, memory);
+    WriteByte(ASL(cycles, value), cycles, addr, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_ASL_ABS(s32& cycles, BusT& memory, Word operand) {
+    Byte value = ReadByte(cycles, operand, memory);
+    WriteByte(ASL(cycles, value), cycles, operand, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_ASL_ABSX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrAbsoluteXY_5(cycles, operand, X);
+    Byte value = ReadByte(cycles, addr, memory);
+    WriteByte(ASL(cycles, value), cycles, addr, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_LSR_ACC(s32& cycles, BusT& memory, Word operand) {
+    A = LSR(cycles, A);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_LSR_ZP(s32& cycles, BusT& memory, Word operand) {
+    Byte value = ReadByte(cycles, operand, memory);
+    WriteByte(LSR(cycles, value), cycles, operand, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_LSR_ZPX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrZeroPageXY(cycles, operand, X);
+    Byte value = ReadByte(cycles, addr, memory);
+    WriteByte(LSR(cycles, value), cycles, addr, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_LSR_ABS(s32& cycles, BusT& memory, Word operand) {
+    Byte value = ReadByte(cycles, operand, memory);
+    WriteByte(LSR(cycles, value), cycles, operand, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_LSR_ABSX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrAbsoluteXY_5(cycles, operand, X);
+    Byte value = ReadByte(cycles, addr, memory);
+    WriteByte(LSR(cycles, value), cycles, addr, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_ROL_ACC(s32& cycles, BusT& memory, Word operand) {
+    A = ROL(cycles, A);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_ROL_ZP(s32& cycles, BusT& memory, Word operand) {
+    Byte value = ReadByte(cycles, operand, memory);
+    WriteByte(ROL(cycles, value), cycles, operand, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_ROL_ZPX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrZeroPageXY(cycles, operand, X);
+    Byte value = ReadByte(cycles, addr, memory);
+    WriteByte(ROL(cycles, value), cycles, addr, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_ROL_ABS(s32& cycles, BusT& memory, Word operand) {
+    Byte value = ReadByte(cycles, operand, memory);
+    WriteByte(ROL(cycles, value), cycles, operand, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_ROL_ABSX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrAbsoluteXY_5(cycles, operand, X);
+    Byte value = ReadByte(cycles, addr, memory);
+    WriteByte(ROL(cycles, value), cycles, addr, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_ROR_ACC(s32& cycles, BusT& memory, Word operand) {
+    A = ROR(cycles, A);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_ROR_ZP(s32& cycles, BusT& memory, Word operand) {
+    Byte value = ReadByte(cycles, operand, memory);
+    WriteByte(ROR(cycles, value), cycles, operand, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_ROR_ZPX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrZeroPageXY(cycles, operand, X);
+    Byte value = ReadByte(cycles, addr, memory);
+    WriteByte(ROR(cycles, value), cycles, addr, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_ROR_ABS(s32& cycles, BusT& memory, Word operand) {
+    Byte value = ReadByte(cycles, operand, memory);
+    WriteByte(ROR(cycles, value), cycles, operand, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_ROR_ABSX(s32& cycles, BusT& memory, Word operand) {
+    Word addr = AddrAbsoluteXY_5(cycles, operand, X);
+    Byte value = ReadByte(cycles, addr, memory);
+    WriteByte(ROR(cycles, value), cycles, addr, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_BRK(s32& cycles, BusT& memory, Word operand) {
+    if (StopOnBRK) {
+        // Give back the fetch, or the whole base count, as if it never ran
+        --PC;
+        cycles += T == Timing::PerInstruction ? 7 : 1;
+        StopAt(cycles, StopReason::Breakpoint);
+        return;
+    }
+    // BRK is differnet from other push: it pushes PC+1 instead of PC
+    PushPCPlusOneToStack(cycles, memory);
+    PushPSToStack(cycles, memory);
+    constexpr Word InterruptVector = 0xFFFE;
+    PC = ReadWord(cycles, InterruptVector, memory);
+    B = true;
+    I = true;
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_RTI(s32& cycles, BusT& memory, Word operand) {
+    PopPSFromStack(cycles, memory);
+    PC = PopWordFromStack(cycles, memory);
+}
+
+template <typename BusT, Timing T>
+void BasicCPU<BusT, T>::Op_Illegal(s32& cycles, BusT& memory, Word operand) {
+    // The NMOS part locks up on $x2 opcodes, bar the immediate NOPs $82-$E2
+    const Byte opcode = memory.Read(PC - 1);
+    const bool jams = (opcode & 0x0F) == 0x02 && (opcode & 0x90) != 0x80;
+    StopAt(cycles, jams ? StopReason::Halt : StopReason::IllegalOpcode);
+}
+
+template <typename BusT, Timing T>
+bool BasicCPU<BusT, T>::TakeInterrupt(s32& cycles, BusT& memory) {
+    constexpr Word NMIVector = 0xFFFA;
+    constexpr Word ResetVector = 0xFFFC;
+    constexpr Word IRQVector = 0xFFFE;
+    if (!RESET && !NMI && !(IRQ && !I))
+        return false;
+    SpendInstruction(cycles, 7);
+    if (RESET) {
+        // The three pushes happen as reads, so only SP moves
+        RESET = false;
+        SP -= 3;
+        Spend(cycles, 5);
+        PC = ReadWord(cycles, ResetVector, memory);
+        I = true;
+        return true;
+    }
+    const bool nmi = NMI;
+    NMI = false;
+    // As BRK, but the PC pushed is that of the next instruction and B is clear
+    Spend(cycles);
+    PushPCToStack(cycles, memory);
+    PushByteOntoStack(cycles, (PS | UnusedFlag) & ~BreakFlag, memory);
+    PC = ReadWord(cycles, nmi ? NMIVector : IRQVector, memory);
+    I = true;
+    return true;
+}
+
+namespace {
+
+// Plain function wrapper around a handler that also fetches its operand, so
+// that a table call is a single indirect call rather than a pointer-to-member
+// call.
+template <typename BusT, Timing T, typename BasicCPU<BusT, T>::Handler Handler, AddrMode Mode, s32 BaseCycles>
+void Invoke(BasicCPU<BusT, T>& cpu, s32& cycles, BusT& memory) {
+    BasicCPU<BusT, T>::SpendInstruction(cycles, BaseCycles);
+    (cpu.*Handler)(cycles, memory, cpu.template FetchOperand<Mode>(cycles, memory));
+}
+
+template <typename BusT, Timing T>
+constexpr std::array<typename BasicCPU<BusT, T>::OpHandler, 256> MakeDispatchTable() {
+    using CPU = BasicCPU<BusT, T>;
+    std::array<typename CPU::OpHandler, 256> table;
+    table.fill(&Invoke<BusT, T, &CPU::Op_Illegal, AddrMode::Implied, 0>);
+#define CP6502_TABLE_ENTRY(name, mode, baseCycles) \
+    table[CPU::INS_##name] = &Invoke<BusT, T, &CPU::Op_##name, AddrMode::mode, baseCycles>;
+    CP6502_OPCODES(CP6502_TABLE_ENTRY)
+#undef CP6502_TABLE_ENTRY
+    return table;
+}
+
+template <typename BusT, Timing T>
+constexpr std::array<typename BasicCPU<BusT, T>::OpHandler, 256> DispatchTable = MakeDispatchTable<BusT, T>();
+
+constexpr u32 NumImplementedOpcodes() {
+    u32 count = 0;
+    for (CPU::OpHandler handler : DispatchTable<Mem, DefaultTiming>)
+        count += (handler != &Invoke<Mem, DefaultTiming, &CPU::Op_Illegal, AddrMode::Implied, 0>);
+    return count;
+}
+
+// Catches two names in CP6502_OPCODES sharing one opcode value.
+#define CP6502_COUNT(name, mode, baseCycles) + 1
+static_assert(NumImplementedOpcodes() == 0 CP6502_OPCODES(CP6502_COUNT));
+#undef CP6502_COUNT
+
+} // namespace
+
+#if CP6502_HAS_COMPUTED_GOTO
+namespace {
+
+// Position of each opcode in CP6502_OPCODES, which is also the order of the
+// label table in ExecuteThreaded; opcodes without a handler map past the end.
+constexpr std::array<Byte, 256> MakeLabelIndex() {
+    std::array<Byte, 256> index;
+    Byte next = 0;
+    index.fill(NumImplementedOpcodes());
+#define CP6502_LABEL_INDEX(name, mode, baseCycles) index[CPU::INS_##name] = next++;
+    CP6502_OPCODES(CP6502_LABEL_INDEX)
+#undef CP6502_LABEL_INDEX
+    return index;
+}
+
+constexpr std::array<Byte, 256> LabelIndex = MakeLabelIndex();
+
+} // namespace
+
+// Every handler is followed by its own copy of the fetch and indirect jump,
+// so the branch predictor sees one jump site per opcode.
+template <typename BusT, Timing T>
+template <typename TraceT>
+ExecuteResult BasicCPU<BusT, T>::ExecuteThreaded(s32 cycles, BusT& memory, TraceT trace) {
+    static const void* const labels[] = {
+#define CP6502_LABEL_ADDRESS(name, mode, baseCycles) &&op_##name,
+        CP6502_OPCODES(CP6502_LABEL_ADDRESS)
+#undef CP6502_LABEL_ADDRESS
+        &&op_Illegal
     };
+    static_assert(sizeof(labels) / sizeof(labels[0]) == NumImplementedOpcodes() + 1);
 
     const s32 cyclesRequested = cycles;
-    while (cycles > 0) {
-        Byte ins = FetchByte(cycles, memory);
-        switch (ins) {
-            case INS_LDA_IM: {
-                A = FetchByte(cycles, memory);
-                LoadRegisterSetStatus(A);
-            } break;
-            case INS_LDX_IM: {
-                X = FetchByte(cycles, memory);
-                LoadRegisterSetStatus(X);
-            } break;
-            case INS_LDY_IM: {
-                Y = FetchByte(cycles, memory);
-                LoadRegisterSetStatus(Y);
-            } break;
-            case INS_LDA_ZP: {
-                Word addr = AddrZeroPage(cycles, memory);
-                LoadRegister(addr, A);
-            } break;
-            case INS_LDX_ZP: {
-                Word addr = AddrZeroPage(cycles, memory);
-                LoadRegister(addr, X);
-            } break;
-            case INS_LDY_ZP: {
-                Word addr = AddrZeroPage(cycles, memory);
-                LoadRegister(addr, Y);
-            } break;
-            case INS_LDA_ZPX: {
-                Word addr = AddrZeroPageXY(cycles, X, memory);
-                LoadRegister(addr, A);
-            } break;
-            case INS_LDX_ZPY: {
-                Word addr = AddrZeroPageXY(cycles, Y, memory);
-                LoadRegister(addr, X);
-            } break;
-            case INS_LDY_ZPX: {
-                Word addr = AddrZeroPageXY(cycles, X, memory);
-                LoadRegister(addr, Y);
-            } break;
-            case INS_LDA_ABS: {
-                Word addr = AddrAbsolute(cycles, memory);
-                LoadRegister(addr, A);
-            } break;
-            case INS_LDX_ABS: {
-                Word addr = AddrAbsolute(cycles, memory);
-                LoadRegister(addr, X);
-            } break;
-            case INS_LDY_ABS: {
-                Word addr = AddrAbsolute(cycles, memory);
-                LoadRegister(addr, Y);
-            } break;
-            case INS_LDA_ABSX: {
-                Word addr = AddrAbsoluteXY(cycles, X, memory);
-                LoadRegister(addr, A);
-            } break;
-            case INS_LDA_ABSY: {
-                Word addr = AddrAbsoluteXY(cycles, Y, memory);
-                LoadRegister(addr, A);
-            } break;
-            case INS_LDX_ABSY: {
-                Word addr = AddrAbsoluteXY(cycles, Y, memory);
-                LoadRegister(addr, X);
-            } break;
-            case INS_LDY_ABSX: {
-                Word addr = AddrAbsoluteXY(cycles, X, memory);
-                LoadRegister(addr, Y);
-            } break;
-            case INS_LDA_INDX: {
-                Word addr = AddrIndirectX(cycles, memory);
-                A = ReadByte(cycles, addr, memory);
-                LoadRegisterSetStatus(A);
-            } break;
-            case INS_LDA_INDY: {
-                Word addr = AddrIndirectY(cycles, memory);
-                A = ReadByte(cycles, addr, memory);
-                LoadRegisterSetStatus(A);
-            } break;
-            case INS_STA_ZP: {
-                Word addr = AddrZeroPage(cycles, memory);
-                WriteByte(A, cycles, addr, memory);
-            } break;
-            case INS_STX_ZP: {
-                Word addr = AddrZeroPage(cycles, memory);
-                WriteByte(X, cycles, addr, memory);
-            } break;
-            case INS_STY_ZP: {
-                Word addr = AddrZeroPage(cycles, memory);
-                WriteByte(Y, cycles, addr, memory);
-            } break;
-            case INS_STA_ABS: {
-                Word addr = AddrAbsolute(cycles, memory);
-                WriteByte(A, cycles, addr, memory);
-            } break;
-            case INS_STX_ABS: {
-                Word addr = AddrAbsolute(cycles, memory);
-                WriteByte(X, cycles, addr, memory);
-            } break;
-            case INS_STY_ABS: {
-                Word addr = AddrAbsolute(cycles, memory);
-                WriteByte(Y, cycles, addr, memory);
-            } break;
-            case INS_STA_ZPX: {
-                Word addr = AddrZeroPageXY(cycles, X, memory);
-                WriteByte(A, cycles, addr, memory);
-            } break;
-            case INS_STX_ZPY: {
-                Word addr = AddrZeroPageXY(cycles, Y, memory);
-                WriteByte(X, cycles, addr, memory);
-            } break;
-            case INS_STY_ZPX: {
-                Word addr = AddrZeroPageXY(cycles, X, memory);
-                WriteByte(Y, cycles, addr, memory);
-            } break;
-            case INS_STA_ABSX: {
-                Word addr = AddrAbsoluteXY_5(cycles, X, memory);
-                WriteByte(A, cycles, addr, memory);
-            } break;
-            case INS_STA_ABSY: {
-                Word addr = AddrAbsoluteXY_5(cycles, Y, memory);
-                WriteByte(A, cycles, addr, memory);
-            } break;
-            case INS_STA_INDX: {
-                Word addr = AddrIndirectX(cycles, memory);
-                WriteByte(A, cycles, addr, memory);
-            } break;
-            case INS_STA_INDY: {
-                Word addr = AddrIndirectY_6(cycles, memory);
-                WriteByte(A, cycles, addr, memory);
-            } break;
-            case INS_JSR: {
-                Word subAddr = FetchWord(cycles, memory);
-                PushPCMinusOneToStack(cycles, memory);
-                // PushPCToStack(cycles, memory);
-                PC = subAddr;
-                --cycles;
-            } break;
-            case INS_RTS: {
-                Word retAddrMinusOne = PopWordFromStack(cycles, memory);
-                PC = retAddrMinusOne + 1;
-                cycles -= 2;
-            } break;
-            case INS_JMP_ABS: {
-                Word addr = AddrAbsolute(cycles, memory);
-                PC = addr;
-            } break;
-            case INS_JMP_IND: {
-                Word addr = AddrAbsolute(cycles, memory);
-                addr = ReadWord(cycles, addr, memory);
-                PC = addr;
-            } break;
-            // Stacks
-            case INS_TSX: {
-                X = SP;
-                --cycles;
-                LoadRegisterSetStatus(X);
-            } break;
-            case INS_TXS: {
-                SP = X;
-                --cycles;
-            } break;
-            case INS_PHA: {
-                PushByteOntoStack(cycles, A, memory);
-            } break;
-            case INS_PLA: {
-                A = PopByteFromStack(cycles, memory);
-                LoadRegisterSetStatus(A);
-                --cycles;
-            } break;
-            case INS_PHP: {
-                PushPSToStack();
-            } break;
-            case INS_PLP: {
-                PopPSFromStack();
-                --cycles;
-            } break;
-            // Logicals
-            case INS_AND_IM: {
-                A = A & FetchByte(cycles, memory);
-                LoadRegisterSetStatus(A);
-            } break;
-            case INS_EOR_IM: {
-                A = A ^ FetchByte(cycles, memory);
-                LoadRegisterSetStatus(A);
-            } break;
-            case INS_ORA_IM: {
-                A = A | FetchByte(cycles, memory);
-                LoadRegisterSetStatus(A);
-            } break;
-            case INS_AND_ZP: {
-                Word addr = AddrZeroPage(cycles, memory);
-                And(addr);
-            } break;
-            case INS_EOR_ZP: {
-                Word addr = AddrZeroPage(cycles, memory);
-                Eor(addr);
-            } break;
-            case INS_ORA_ZP: {
-                Word addr = AddrZeroPage(cycles, memory);
-                Ora(addr);
-            } break;
-            case INS_AND_ZPX: {
-                Word addr = AddrZeroPageXY(cycles, X, memory);
-                And(addr);
-            } break;
-            case INS_EOR_ZPX: {
-                Word addr = AddrZeroPageXY(cycles, X, memory);
-                Eor(addr);
-            } break;
-            case INS_ORA_ZPX: {
-                Word addr = AddrZeroPageXY(cycles, X, memory);
-                Ora(addr);
-            } break;
-            case INS_AND_ABS: {
-                Word addr = AddrAbsolute(cycles, memory);
-                And(addr);
-            } break;
-            case INS_EOR_ABS: {
-                Word addr = AddrAbsolute(cycles, memory);
-                Eor(addr);
-            } break;
-            case INS_ORA_ABS: {
-                Word addr = AddrAbsolute(cycles, memory);
-                Ora(addr);
-            } break;
-            case INS_AND_ABSX: {
-                Word addr = AddrAbsoluteXY(cycles, X, memory);
-                And(addr);
-            } break;
-            case INS_EOR_ABSX: {
-                Word addr = AddrAbsoluteXY(cycles, X, memory);
-                Eor(addr);
-            } break;
-            case INS_ORA_ABSX: {
-                Word addr = AddrAbsoluteXY(cycles, X, memory);
-                Ora(addr);
-            } break;
-            case INS_AND_ABSY: {
-                Word addr = AddrAbsoluteXY(cycles, Y, memory);
-                And(addr);
-            } break;
-            case INS_EOR_ABSY: {
-                Word addr = AddrAbsoluteXY(cycles, Y, memory);
-                Eor(addr);
-            } break;
-            case INS_ORA_ABSY: {
-                Word addr = AddrAbsoluteXY(cycles, Y, memory);
-                Ora(addr);
-            } break;
-            case INS_AND_INDX: {
-                Word addr = AddrIndirectX(cycles, memory);
-                And(addr);
-            } break;
-            case INS_EOR_INDX: {
-                Word addr = AddrIndirectX(cycles, memory);
-                Eor(addr);
-            } break;
-            case INS_ORA_INDX: {
-                Word addr = AddrIndirectX(cycles, memory);
-                Ora(addr);
-            } break;
-            case INS_AND_INDY: {
-                Word addr = AddrIndirectY(cycles, memory);
-                And(addr);
-            } break;
-            case INS_EOR_INDY: {
-                Word addr = AddrIndirectY(cycles, memory);
-                Eor(addr);
-            } break;
-            case INS_ORA_INDY: {
-                Word addr = AddrIndirectY(cycles, memory);
-                Ora(addr);
-            } break;
-            case INS_BIT_ZP: {
-                Word addr = AddrZeroPage(cycles, memory);
-                Bit(addr);
-            } break;
-            case INS_BIT_ABS: {
-                Word addr = AddrAbsolute(cycles, memory);
-                Bit(addr);
-            } break;
-            case INS_TAX: {
-                X = A;
-                LoadRegisterSetStatus(X);
-                cycles -= 2;
-            } break;
-            case INS_TAY: {
-                Y = A;
-                LoadRegisterSetStatus(Y);
-                cycles -= 2;
-            } break;
-            case INS_TXA: {
-                A = X;
-                LoadRegisterSetStatus(A);
-                cycles -= 2;
-            } break;
-            case INS_TYA: {
-                A = Y;
-                LoadRegisterSetStatus(A);
-                cycles -= 2;
-            } break;
-            case INS_INX: {
-                ++X;
-                LoadRegisterSetStatus(X);
-                cycles -= 2;
-            } break;
-            case INS_INY: {
-                ++Y;
-                LoadRegisterSetStatus(Y);
-                cycles -= 2;
-            } break;
-            case INS_DEX: {
-                --X;
-                LoadRegisterSetStatus(X);
-                cycles -= 2;
-            } break;
-            case INS_DEY: {
-                --Y;
-                LoadRegisterSetStatus(Y);
-                cycles -= 2;
-            } break;
-            case INS_INC_ZP: {
-                Word addr = AddrZeroPage(cycles, memory);
-                Inc(addr);
-                cycles -= 2;
-            } break;
-            case INS_INC_ZPX: {
-                Word addr = AddrZeroPageXY(cycles, X, memory);
-                Inc(addr);
-                cycles -= 2;
-            } break;
-            case INS_INC_ABS: {
-                Word addr = AddrAbsolute(cycles, memory);
-                Inc(addr);
-                cycles -= 2;
-            } break;
-            case INS_INC_ABSX: {
-                Word addr = AddrAbsoluteXY(cycles, X, memory);
-                Inc(addr);
-                cycles -= 2;
-            } break;
-            case INS_DEC_ZP: {
-                Word addr = AddrZeroPage(cycles, memory);
-                Dec(addr);
-                cycles -= 2;
-            } break;
-            case INS_DEC_ZPX: {
-                Word addr = AddrZeroPageXY(cycles, X, memory);
-                Dec(addr);
-                cycles -= 2;
-            } break;
-            case INS_DEC_ABS: {
-                Word addr = AddrAbsolute(cycles, memory);
-                Dec(addr);
-                cycles -= 2;
-            } break;
-            case INS_DEC_ABSX: {
-                Word addr = AddrAbsoluteXY(cycles, X, memory);
-                Dec(addr);
-                cycles -= 2;
-            } break;
-            case INS_BEQ: {
-                BranchIf([this]() -> bool { return Z; });
-            } break;
-            case INS_BNE: {
-                BranchIf([this]() -> bool { return !Z; });
-            } break;
-            case INS_BCC: {
-                BranchIf([this]() -> bool { return !C; });
-            } break;
-            case INS_BCS: {
-                BranchIf([this]() -> bool { return C; });
-            } break;
-            case INS_BMI: {
-                BranchIf([this]() -> bool { return N; });
-            } break;
-            case INS_BPL: {
-                BranchIf([this]() -> bool { return !N; });
-            } break;
-            case INS_BVS: {
-                BranchIf([this]() -> bool { return V; });
-            } break;
-            case INS_BVC: {
-                BranchIf([this]() -> bool { return !V; });
-            } break;
-            case INS_CLC: {
-                C = 0;
-                --cycles;
-            } break;
-            case INS_CLD: {
-                D = 0;
-                --cycles;
-            } break;
-            case INS_CLI: {
-                I = 0;
-                --cycles;
-            } break;
-            case INS_CLV: {
-                V = 0;
-                --cycles;
-            } break;
-            case INS_SEC: {
-                C = 1;
-                --cycles;
-            } break;
-            case INS_SED: {
-                D = 1;
-                --cycles;
-            } break;
-            case INS_SEI: {
-                I = 1;
-                --cycles;
-            } break;
-            case INS_NOP: {
-                --cycles;
-            } break;
-            case INS_ADC_IM: {
-                Byte operand = FetchByte(cycles, memory);
-                ADC(operand);
-            } break;
-            case INS_ADC_ZP: {
-                Word addr = AddrZeroPage(cycles, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                ADC(operand);
-            } break;
-            case INS_ADC_ZPX: {
-                Word addr = AddrZeroPageXY(cycles, X, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                ADC(operand);
-            } break;
-            case INS_ADC_ABS: {
-                Word addr = AddrAbsolute(cycles, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                ADC(operand);
-            } break;
-            case INS_ADC_ABSX: {
-                Word addr = AddrAbsoluteXY(cycles, X, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                ADC(operand);
-            } break;
-            case INS_ADC_ABSY: {
-                Word addr = AddrAbsoluteXY(cycles, Y, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                ADC(operand);
-            } break;
-            case INS_ADC_INDX: {
-                Word addr = AddrIndirectX(cycles, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                ADC(operand);
-            } break;
-            case INS_ADC_INDY: {
-                Word addr = AddrIndirectY(cycles, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                ADC(operand);
-            } break;
-            case INS_CMP_IM: {
-                Byte operand = FetchByte(cycles, memory);
-                Compare(operand, A);
-            } break;
-            case INS_CMP_ZP: {
-                Word addr = AddrZeroPage(cycles, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                Compare(operand, A);
-            } break;
-            case INS_CMP_ZPX: {
-                Word addr = AddrZeroPageXY(cycles, X, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                Compare(operand, A);
-            } break;
-            case INS_CMP_ABS: {
-                Word addr = AddrAbsolute(cycles, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                Compare(operand, A);
-            } break;
-            case INS_CMP_ABSX: {
-                Word addr = AddrAbsoluteXY(cycles, X, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                Compare(operand, A);
-            } break;
-            case INS_CMP_ABSY: {
-                Word addr = AddrAbsoluteXY(cycles, Y, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                Compare(operand, A);
-            } break;
-            case INS_CMP_INDX: {
-                Word addr = AddrIndirectX(cycles, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                Compare(operand, A);
-            } break;
-            case INS_CMP_INDY: {
-                Word addr = AddrIndirectY(cycles, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                Compare(operand, A);
-            } break;
-            case INS_CPX_IM: {
-                Byte operand = FetchByte(cycles, memory);
-                Compare(operand, X);
-            } break;
-            case INS_CPX_ZP: {
-                Word addr = AddrZeroPage(cycles, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                Compare(operand, X);
-            } break;
-            case INS_CPX_ABS: {
-                Word addr = AddrAbsolute(cycles, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                Compare(operand, X);
-            } break;
-            case INS_CPY_IM: {
-                Byte operand = FetchByte(cycles, memory);
-                Compare(operand, Y);
-            } break;
-            case INS_CPY_ZP: {
-                Word addr = AddrZeroPage(cycles, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                Compare(operand, Y);
-            } break;
-            case INS_CPY_ABS: {
-                Word addr = AddrAbsolute(cycles, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                Compare(operand, Y);
-            } break;
-            case INS_SBC_IM: {
-                Byte operand = FetchByte(cycles, memory);
-                SBC(operand);
-            } break;
-            case INS_SBC_ZP: {
-                Word addr = AddrZeroPage(cycles, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                SBC(operand);
-            } break;
-            case INS_SBC_ZPX: {
-                Word addr = AddrZeroPageXY(cycles, X, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                SBC(operand);
-            } break;
-            case INS_SBC_ABS: {
-                Word addr = AddrAbsolute(cycles, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                SBC(operand);
-            } break;
-            case INS_SBC_ABSX: {
-                Word addr = AddrAbsoluteXY(cycles, X, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                SBC(operand);
-            } break;
-            case INS_SBC_ABSY: {
-                Word addr = AddrAbsoluteXY(cycles, Y, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                SBC(operand);
-            } break;
-            case INS_SBC_INDX: {
-                Word addr = AddrIndirectX(cycles, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                SBC(operand);
-            } break;
-            case INS_SBC_INDY: {
-                Word addr = AddrIndirectY(cycles, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                SBC(operand);
-            } break;
-            case INS_ASL_ACC: {
-                Byte operand = A;
-                A = ASL(operand);
-            } break;
-            case INS_ASL_ZP: {
-                Word addr = AddrZeroPage(cycles, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                WriteByte(ASL(operand), cycles, addr, memory);
-            } break;
-            case INS_ASL_ZPX: {
-                Word addr = AddrZeroPageXY(cycles, X, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                WriteByte(ASL(operand), cycles, addr, memory);
-            } break;
-            case INS_ASL_ABS: {
-                Word addr = AddrAbsolute(cycles, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                WriteByte(ASL(operand), cycles, addr, memory);
-            } break;
-            case INS_ASL_ABSX: {
-                Word addr = AddrAbsoluteXY_5(cycles, X, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                WriteByte(ASL(operand), cycles, addr, memory);
-            } break;
-            case INS_LSR_ACC: {
-                Byte operand = A;
-                A = LSR(operand);
-            } break;
-            case INS_LSR_ZP: {
-                Word addr = AddrZeroPage(cycles, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                WriteByte(LSR(operand), cycles, addr, memory);
-            } break;
-            case INS_LSR_ZPX: {
-                Word addr = AddrZeroPageXY(cycles, X, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                WriteByte(LSR(operand), cycles, addr, memory);
-            } break;
-            case INS_LSR_ABS: {
-                Word addr = AddrAbsolute(cycles, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                WriteByte(LSR(operand), cycles, addr, memory);
-            } break;
-            case INS_LSR_ABSX: {
-                Word addr = AddrAbsoluteXY_5(cycles, X, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                WriteByte(LSR(operand), cycles, addr, memory);
-            } break;
-            case INS_ROL_ACC: {
-                Byte operand = A;
-                A = ROL(operand);
-            } break;
-            case INS_ROL_ZP: {
-                Word addr = AddrZeroPage(cycles, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                WriteByte(ROL(operand), cycles, addr, memory);
-            } break;
-            case INS_ROL_ZPX: {
-                Word addr = AddrZeroPageXY(cycles, X, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                WriteByte(ROL(operand), cycles, addr, memory);
-            } break;
-            case INS_ROL_ABS: {
-                Word addr = AddrAbsolute(cycles, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                WriteByte(ROL(operand), cycles, addr, memory);
-            } break;
-            case INS_ROL_ABSX: {
-                Word addr = AddrAbsoluteXY_5(cycles, X, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                WriteByte(ROL(operand), cycles, addr, memory);
-            } break;
-            case INS_ROR_ACC: {
-                Byte operand = A;
-                A = ROR(operand);
-            } break;
-            case INS_ROR_ZP: {
-                Word addr = AddrZeroPage(cycles, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                WriteByte(ROR(operand), cycles, addr, memory);
-            } break;
-            case INS_ROR_ZPX: {
-                Word addr = AddrZeroPageXY(cycles, X, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                WriteByte(ROR(operand), cycles, addr, memory);
-            } break;
-            case INS_ROR_ABS: {
-                Word addr = AddrAbsolute(cycles, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                WriteByte(ROR(operand), cycles, addr, memory);
-            } break;
-            case INS_ROR_ABSX: {
-                Word addr = AddrAbsoluteXY_5(cycles, X, memory);
-                Byte operand = ReadByte(cycles, addr, memory);
-                WriteByte(ROR(operand), cycles, addr, memory);
-            } break;
-            case INS_BRK: {
-                // BRK is differnet from other push: it pushes PC+1 instead of PC
-                PushPCPlusOneToStack(cycles, memory);
-                PushPSToStack();
-                constexpr Word InterruptVector = 0xFFFE;
-                PC = ReadWord(cycles, InterruptVector, memory);
-                B = true;
-                I = true;
-            } break;
-            case INS_RTI: {
-                PopPSFromStack();
-                PC = PopWordFromStack(cycles, memory);
-            } break;
-
-            default: {
-                printf("Instruction not implemented: %x\n", ins);
-                throw -1;
-            } break;
+    LoadFlags();
+    Idle.Armed = false;
+    Stop = StopReason::Budget;
+#define CP6502_DISPATCH_NEXT() \
+    if (cycles <= 0) { \
+        const ExecuteResult result = EndExecute(cyclesRequested, cycles); \
+        trace.Advance(result.Cycles); \
+        return result; \
+    } \
+    { \
+        const s32 cyclesUsed = cyclesRequested - cycles; \
+        const Byte opcode = FetchByte(cycles, memory); \
+        trace.Record(*this, memory, opcode, cyclesUsed); \
+        CountOpcode(opcode); \
+        goto *labels[LabelIndex[opcode]]; \
+    }
+
+    CP6502_DISPATCH_NEXT();
+#define CP6502_LABEL(name, mode, baseCycles) \
+    op_##name: \
+    SpendInstruction(cycles, baseCycles); \
+    Op_##name(cycles, memory, FetchOperand<AddrMode::mode>(cycles, memory)); \
+    CP6502_DISPATCH_NEXT();
+    CP6502_OPCODES(CP6502_LABEL)
+    CP6502_LABEL(Illegal, Implied, 0)
+#undef CP6502_LABEL
+#undef CP6502_DISPATCH_NEXT
+}
+#endif
+
+template <typename BusT, Timing T>
+template <Dispatch D>
+ExecuteResult BasicCPU<BusT, T>::Execute(s32 cycles, BusT& memory) {
+    return Run<D>(cycles, memory, NoTrace());
+}
+
+template <typename BusT, Timing T>
+template <Dispatch D>
+ExecuteResult BasicCPU<BusT, T>::Execute(s32 cycles, BusT& memory, TraceRing& trace) {
+    return Run<D>(cycles, memory, TraceRing::Recorder(trace));
+}
+
+template <typename BusT, Timing T>
+template <Dispatch D>
+ExecuteResult BasicCPU<BusT, T>::Execute(s32 cycles, BusT& memory, TraceWriter& trace) {
+    return Run<D>(cycles, memory, TraceWriter::Recorder(trace));
+}
+
+template <typename BusT, Timing T>
+template <Dispatch D>
+ExecuteResult BasicCPU<BusT, T>::Execute(s32 cycles, BusT& memory, Profiler& profiler) {
+    return Run<D>(cycles, memory, Profiler::Recorder(profiler));
+}
+
+template <typename BusT, Timing T>
+template <Dispatch D, typename TraceT>
+ExecuteResult BasicCPU<BusT, T>::Run(s32 cycles, BusT& memory, TraceT trace) {
+    if constexpr (D == Dispatch::Threaded) {
+        static_assert(D != Dispatch::Threaded || CP6502_HAS_COMPUTED_GOTO,
+                      "Dispatch::Threaded needs GCC or Clang labels-as-values");
+        return ExecuteThreaded(cycles, memory, trace);
+    } else {
+        const s32 cyclesRequested = cycles;
+        LoadFlags();
+        Idle.Armed = false;
+        Stop = StopReason::Budget;
+        while (cycles > 0) {
+            const s32 cyclesUsed = cyclesRequested - cycles;
+            Byte ins = FetchByte(cycles, memory);
+            trace.Record(*this, memory, ins, cyclesUsed);
+            CountOpcode(ins);
+            if constexpr (D == Dispatch::Table) {
+                DispatchTable<BusT, T>[ins](*this, cycles, memory);
+            } else {
+                switch (ins) {
+#define CP6502_CASE(name, mode, baseCycles) \
+                    case INS_##name: \
+                        SpendInstruction(cycles, baseCycles); \
+                        Op_##name(cycles, memory, FetchOperand<AddrMode::mode>(cycles, memory)); \
+                        break;
+                    CP6502_OPCODES(CP6502_CASE)
+#undef CP6502_CASE
+                    default: Op_Illegal(cycles, memory, 0); break;
+                }
+            }
         }
+        const ExecuteResult result = EndExecute(cyclesRequested, cycles);
+        trace.Advance(result.Cycles);
+        return result;
     }
-    return cyclesRequested - cycles;
 }
 
+#define CP6502_INSTANTIATE(BusT, T) \
+    template struct BasicCPU<BusT, T>; \
+    template ExecuteResult BasicCPU<BusT, T>::Execute<Dispatch::Switch>(s32 cycles, BusT& memory); \
+    template ExecuteResult BasicCPU<BusT, T>::Execute<Dispatch::Table>(s32 cycles, BusT& memory); \
+    template ExecuteResult BasicCPU<BusT, T>::Execute<Dispatch::Switch>(s32 cycles, BusT& memory, TraceRing& trace); \
+    template ExecuteResult BasicCPU<BusT, T>::Execute<Dispatch::Table>(s32 cycles, BusT& memory, TraceRing& trace); \
+    template ExecuteResult BasicCPU<BusT, T>::Execute<Dispatch::Switch>(s32 cycles, BusT& memory, TraceWriter& trace); \
+    template ExecuteResult BasicCPU<BusT, T>::Execute<Dispatch::Table>(s32 cycles, BusT& memory, TraceWriter& trace); \
+    template ExecuteResult BasicCPU<BusT, T>::Execute<Dispatch::Switch>(s32 cycles, BusT& memory, Profiler& profiler); \
+    template ExecuteResult BasicCPU<BusT, T>::Execute<Dispatch::Table>(s32 cycles, BusT& memory, Profiler& profiler); \
+    CP6502_INSTANTIATE_THREADED(BusT, T)
+#if CP6502_HAS_COMPUTED_GOTO
+#define CP6502_INSTANTIATE_THREADED(BusT, T) \
+    template ExecuteResult BasicCPU<BusT, T>::Execute<Dispatch::Threaded>(s32 cycles, BusT& memory); \
+    template ExecuteResult BasicCPU<BusT, T>::Execute<Dispatch::Threaded>(s32 cycles, BusT& memory, TraceRing& trace); \
+    template ExecuteResult BasicCPU<BusT, T>::Execute<Dispatch::Threaded>(s32 cycles, BusT& memory, TraceWriter& trace); \
+    template ExecuteResult BasicCPU<BusT, T>::Execute<Dispatch::Threaded>(s32 cycles, BusT& memory, Profiler& profiler);
+#else
+#define CP6502_INSTANTIATE_THREADED(BusT, T)
+#endif
+CP6502_INSTANTIATE(Mem, Timing::PerAccess)
+CP6502_INSTANTIATE(Mem, Timing::PerInstruction)
+CP6502_INSTANTIATE(Bus, Timing::PerAccess)
+CP6502_INSTANTIATE(Bus, Timing::PerInstruction)
+#undef CP6502_INSTANTIATE_THREADED
+#undef CP6502_INSTANTIATE
+
 } // namespace cp6502
@@ -1,6 +1,10 @@
 #pragma once
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#include <array>
+#include <type_traits>
 
 namespace cp6502 
 {
@@ -10,6 +14,7 @@ using Word = unsigned short;
 
 using u32 = unsigned int;
 using s32 = signed int;
+using u64 = unsigned long long;
 
 constexpr Byte CarryFlag        = 0b00000001;
 constexpr Byte ZeroFlag         = 0b00000010;
@@ -17,22 +22,212 @@ constexpr Byte InterruptFlag    = 0b00000100;
 constexpr Byte DecimalFlag      = 0b00001000;
 constexpr Byte BreakFlag        = 0b00010000;
 constexpr Byte UnusedFlag       = 0b00100000;
-constexpr Byte OverflowFlag     = 0b00100000;
+constexpr Byte OverflowFlag     = 0b01000000;
 constexpr Byte NegativeFlag     = 0b10000000;
 
 const static Word StackBase = 0x0100;
 
+// How CPU::Execute decodes an opcode into its handler.
+enum class Dispatch {
+    Switch,     // one switch statement over the opcode
+    Table,      // indirect call through a 256-entry handler table
+    Threaded,   // computed goto at the end of every handler (GCC/Clang only)
+};
+
+// How CPU::Execute charges cycles against its budget.
+enum class Timing {
+    PerAccess,      // a cycle at a time, as each bus access and internal step happens
+    PerInstruction, // the base count once per opcode, plus page-cross and branch penalties
+};
+
+// Why CPU::Execute returned.
+enum class StopReason : Byte {
+    Budget,         // used up the cycles it was given
+    IllegalOpcode,  // PC is just past an opcode without a handler
+    Breakpoint,     // PC is at a BRK, not taken, with StopOnBRK set
+    Trap,           // PC is at a jump or branch to itself, with StopOnTrap set
+    Halt,           // PC is just past an opcode that locks up the NMOS 6502
+};
+
+struct ExecuteResult {
+    s32 Cycles;         // used, as many as were given or more unless stopped early
+    StopReason Reason;
+    Word PC;
+
+    // Reads as the cycles used, which is all Execute used to return
+    operator s32() const {
+        return Cycles;
+    }
+};
+
+// Set by the CP6502_INSTRUCTION_TIMING CMake option
+#if defined(CP6502_INSTRUCTION_TIMING)
+constexpr Timing DefaultTiming = Timing::PerInstruction;
+#else
+constexpr Timing DefaultTiming = Timing::PerAccess;
+#endif
+
+#if defined(__GNUC__)
+#define CP6502_HAS_COMPUTED_GOTO 1
+#else
+#define CP6502_HAS_COMPUTED_GOTO 0
+#endif
+
+// Set by the CP6502_THREADED_DISPATCH CMake option
+#if defined(CP6502_THREADED_DISPATCH)
+#if !CP6502_HAS_COMPUTED_GOTO
+#error "CP6502_THREADED_DISPATCH needs a compiler with labels-as-values"
+#endif
+constexpr Dispatch DefaultDispatch = Dispatch::Threaded;
+#else
+constexpr Dispatch DefaultDispatch = Dispatch::Table;
+#endif
+
+enum class AddrMode : Byte {
+    Implied,
+    Accumulator,
+    Immediate,
+    ZeroPage,
+    ZeroPageX,
+    ZeroPageY,
+    Absolute,
+    AbsoluteX,
+    AbsoluteY,
+    Indirect,
+    IndirectX,
+    IndirectY,
+    Relative,
+};
+
+// Opcode plus operand bytes
+constexpr Byte InstructionLength(AddrMode mode) {
+    switch (mode) {
+        case AddrMode::Implied:
+        case AddrMode::Accumulator:
+            return 1;
+        case AddrMode::Absolute:
+        case AddrMode::AbsoluteX:
+        case AddrMode::AbsoluteY:
+        case AddrMode::Indirect:
+            return 3;
+        default:
+            return 2;
+    }
+}
+
+// What CPU::Execute ran, counted when built with the CP6502_OPCODE_COUNTS
+// CMake option (see BasicCPU::Counts): the mix of opcodes and addressing
+// modes in a workload, and how often it pays page-cross and branch penalties.
+struct OpcodeCounts {
+    std::array<u64, 256> Executed{};    // per opcode, including those without a handler
+    u64 PageCrosses = 0;        // indexed reads that crossed a page and took a cycle more
+    u64 BranchesTaken = 0;
+    u64 BranchesNotTaken = 0;
+    u64 BranchPageCrosses = 0;  // branches taken to another page, a cycle more again
+
+    u64 Instructions() const;
+
+    // Instructions run in mode, by Opcodes[].Mode; opcodes without a handler
+    // are left out
+    u64 InMode(AddrMode mode) const;
+};
+
 struct Mem;
-struct CPU;
+struct Bus;
+// The CPU runs on any bus type with Read(address) const, Write(address, value)
+// and Initialise(): a plain Mem, or a Bus with devices (bus.hpp)
+template <typename BusT, Timing T = DefaultTiming>
+struct BasicCPU;
+using CPU = BasicCPU<Mem>;
+struct BlockCache;
+struct Mapper;
+struct Snapshot;
+struct Snapshotter;
+struct DirtyPages;
+template <u32 N>
+struct CPUBatch;
+struct JobRunner;
+struct Scheduler;
+struct TraceRing;
+struct TraceWriter;
+struct TraceReader;
+struct Profiler;
+struct Symbols;
+
+// The trace policy of an untraced CPU::Execute: records nothing, and
+// compiles to nothing. Execute calls Record with each opcode as it fetches
+// it, PC one past it, and Advance with the cycles used as it returns.
+struct NoTrace {
+    template <typename CPUT, typename BusT>
+    void Record(CPUT const&, BusT const&, Byte, s32) {}
+    void Advance(s32) {}
+};
+struct Jit;
 }
 
 struct cp6502::Mem {
     static constexpr u32 MAX_MEM = 1024 * 64;
+    static constexpr u32 PAGE_SIZE = 256;
+    static constexpr u32 NUM_PAGES = MAX_MEM / PAGE_SIZE;
     Byte Data[MAX_MEM];
+    // Bumped whenever a page may have been written through a non-const
+    // accessor, so that decoded code can be checked for staleness
+    u32 WriteGeneration[NUM_PAGES] = {};
+    // Pages known to hold zeros: set by Initialise, and only trusted while
+    // the page's WriteGeneration is still ZeroGeneration
+    bool Zeroed[NUM_PAGES] = {};
+    u32 ZeroGeneration[NUM_PAGES] = {};
+
+    Mem() = default;
+    Mem(Mem const& other) = default;
+
+    Mem& operator=(Mem const& other) {
+        memcpy(Data, other.Data, MAX_MEM);
+        TouchAllPages();
+        return *this;
+    }
 
+    // Zeroes memory. Only the pages written since the last Initialise are
+    // cleared, a run of consecutive pages at a time; the others keep their
+    // WriteGeneration, so code decoded from them stays valid. Writes through
+    // Data or a pointer taken from operator[] (fread, Bus::MapRam) leave
+    // WriteGeneration alone, so a page is only skipped once it is also seen
+    // to hold zeros: reading it is still far cheaper than clearing it.
     void Initialise() {
-        for (u32 i = 0; i < MAX_MEM; ++i)
-            Data[i] = 0;
+        u32 page = 0;
+        while (page < NUM_PAGES) {
+            if (IsZeroed(page) && HoldsZeros(page)) {
+                ++page;
+                continue;
+            }
+            const u32 first = page;
+            while (page < NUM_PAGES && !(IsZeroed(page) && HoldsZeros(page)))
+                ++page;
+            memset(&Data[first * PAGE_SIZE], 0, (page - first) * PAGE_SIZE);
+            for (u32 cleared = first; cleared < page; ++cleared) {
+                ZeroGeneration[cleared] = ++WriteGeneration[cleared];
+                Zeroed[cleared] = true;
+            }
+        }
+    }
+
+    bool IsZeroed(u32 page) const {
+        return Zeroed[page] && WriteGeneration[page] == ZeroGeneration[page];
+    }
+
+    bool HoldsZeros(u32 page) const {
+        u64 bits = 0;
+        for (u32 offset = 0; offset < PAGE_SIZE; offset += sizeof(u64)) {
+            u64 word;
+            memcpy(&word, &Data[page * PAGE_SIZE + offset], sizeof(word));
+            bits |= word;
+        }
+        return bits == 0;
+    }
+
+    void TouchAllPages() {
+        for (u32 page = 0; page < NUM_PAGES; ++page)
+            ++WriteGeneration[page];
     }
 
     Byte operator[](u32 address) const {
@@ -40,12 +235,106 @@ struct cp6502::Mem {
     }
 
     Byte& operator[](u32 address) {
+        ++WriteGeneration[address / PAGE_SIZE];
         return Data[address];
     }
 
+    Byte Read(u32 address) const {
+        return Data[address];
+    }
+
+    void Write(u32 address, Byte value) {
+        ++WriteGeneration[address / PAGE_SIZE];
+        Data[address] = value;
+    }
+
 };
 
-struct cp6502::CPU {
+// Every implemented opcode as X(name, mode, cycles): the suffix of its
+// CPU::INS_* constant, its AddrMode and its base cycle count (no page
+// crossing, branch not taken). Expanded once per opcode to build dispatch code.
+#define CP6502_OPCODES(X) \
+    /* LDA */ \
+    X(LDA_IM, Immediate, 2) X(LDA_ZP, ZeroPage, 3) X(LDA_ZPX, ZeroPageX, 4) \
+    X(LDA_ABS, Absolute, 4) X(LDA_ABSX, AbsoluteX, 4) X(LDA_ABSY, AbsoluteY, 4) \
+    X(LDA_INDX, IndirectX, 6) X(LDA_INDY, IndirectY, 5) \
+    /* LDX */ \
+    X(LDX_IM, Immediate, 2) X(LDX_ZP, ZeroPage, 3) X(LDX_ZPY, ZeroPageY, 4) \
+    X(LDX_ABS, Absolute, 4) X(LDX_ABSY, AbsoluteY, 4) \
+    /* LDY */ \
+    X(LDY_IM, Immediate, 2) X(LDY_ZP, ZeroPage, 3) X(LDY_ZPX, ZeroPageX, 4) \
+    X(LDY_ABS, Absolute, 4) X(LDY_ABSX, AbsoluteX, 4) \
+    /* STA */ \
+    X(STA_ZP, ZeroPage, 3) X(STA_ZPX, ZeroPageX, 4) X(STA_ABS, Absolute, 4) \
+    X(STA_ABSX, AbsoluteX, 5) X(STA_ABSY, AbsoluteY, 5) X(STA_INDX, IndirectX, 6) \
+    X(STA_INDY, IndirectY, 6) \
+    /* STX */ \
+    X(STX_ZP, ZeroPage, 3) X(STX_ZPY, ZeroPageY, 4) X(STX_ABS, Absolute, 4) \
+    /* STY */ \
+    X(STY_ZP, ZeroPage, 3) X(STY_ZPX, ZeroPageX, 4) X(STY_ABS, Absolute, 4) \
+    /* Stack */ \
+    X(TSX, Implied, 2) X(TXS, Implied, 2) X(PHA, Implied, 3) X(PHP, Implied, 3) \
+    X(PLA, Implied, 4) X(PLP, Implied, 4) \
+    /* AND */ \
+    X(AND_IM, Immediate, 2) X(AND_ZP, ZeroPage, 3) X(AND_ZPX, ZeroPageX, 4) \
+    X(AND_ABS, Absolute, 4) X(AND_ABSX, AbsoluteX, 4) X(AND_ABSY, AbsoluteY, 4) \
+    X(AND_INDX, IndirectX, 6) X(AND_INDY, IndirectY, 5) \
+    /* EOR */ \
+    X(EOR_IM, Immediate, 2) X(EOR_ZP, ZeroPage, 3) X(EOR_ZPX, ZeroPageX, 4) \
+    X(EOR_ABS, Absolute, 4) X(EOR_ABSX, AbsoluteX, 4) X(EOR_ABSY, AbsoluteY, 4) \
+    X(EOR_INDX, IndirectX, 6) X(EOR_INDY, IndirectY, 5) \
+    /* ORA */ \
+    X(ORA_IM, Immediate, 2) X(ORA_ZP, ZeroPage, 3) X(ORA_ZPX, ZeroPageX, 4) \
+    X(ORA_ABS, Absolute, 4) X(ORA_ABSX, AbsoluteX, 4) X(ORA_ABSY, AbsoluteY, 4) \
+    X(ORA_INDX, IndirectX, 6) X(ORA_INDY, IndirectY, 5) \
+    /* BIT */ \
+    X(BIT_ZP, ZeroPage, 3) X(BIT_ABS, Absolute, 4) \
+    /* Register Transfer */ \
+    X(TAX, Implied, 2) X(TAY, Implied, 2) X(TXA, Implied, 2) X(TYA, Implied, 2) \
+    /* Increment Decrement */ \
+    X(INX, Implied, 2) X(INY, Implied, 2) X(DEX, Implied, 2) X(DEY, Implied, 2) \
+    X(INC_ZP, ZeroPage, 5) X(INC_ZPX, ZeroPageX, 6) X(INC_ABS, Absolute, 6) \
+    X(INC_ABSX, AbsoluteX, 7) X(DEC_ZP, ZeroPage, 5) X(DEC_ZPX, ZeroPageX, 6) \
+    X(DEC_ABS, Absolute, 6) X(DEC_ABSX, AbsoluteX, 7) \
+    /* Branches */ \
+    X(BEQ, Relative, 2) X(BNE, Relative, 2) X(BCC, Relative, 2) X(BCS, Relative, 2) \
+    X(BMI, Relative, 2) X(BPL, Relative, 2) X(BVS, Relative, 2) X(BVC, Relative, 2) \
+    /* Status Flags Changes */ \
+    X(CLC, Implied, 2) X(CLD, Implied, 2) X(CLI, Implied, 2) X(CLV, Implied, 2) \
+    X(SEC, Implied, 2) X(SED, Implied, 2) X(SEI, Implied, 2) \
+    /* Arithmetic */ \
+    X(ADC_IM, Immediate, 2) X(ADC_ZP, ZeroPage, 3) X(ADC_ZPX, ZeroPageX, 4) \
+    X(ADC_ABS, Absolute, 4) X(ADC_ABSX, AbsoluteX, 4) X(ADC_ABSY, AbsoluteY, 4) \
+    X(ADC_INDX, IndirectX, 6) X(ADC_INDY, IndirectY, 5) \
+    /* CMP */ \
+    X(CMP_IM, Immediate, 2) X(CMP_ZP, ZeroPage, 3) X(CMP_ZPX, ZeroPageX, 4) \
+    X(CMP_ABS, Absolute, 4) X(CMP_ABSX, AbsoluteX, 4) X(CMP_ABSY, AbsoluteY, 4) \
+    X(CMP_INDX, IndirectX, 6) X(CMP_INDY, IndirectY, 5) \
+    /* CPX */ \
+    X(CPX_IM, Immediate, 2) X(CPX_ZP, ZeroPage, 3) X(CPX_ABS, Absolute, 4) \
+    /* CPY */ \
+    X(CPY_IM, Immediate, 2) X(CPY_ZP, ZeroPage, 3) X(CPY_ABS, Absolute, 4) \
+    /* SBC */ \
+    X(SBC_IM, Immediate, 2) X(SBC_ZP, ZeroPage, 3) X(SBC_ZPX, ZeroPageX, 4) \
+    X(SBC_ABS, Absolute, 4) X(SBC_ABSX, AbsoluteX, 4) X(SBC_ABSY, AbsoluteY, 4) \
+    X(SBC_INDX, IndirectX, 6) X(SBC_INDY, IndirectY, 5) \
+    /* Shift */ \
+    X(ASL_ACC, Accumulator, 2) X(ASL_ZP, ZeroPage, 5) X(ASL_ZPX, ZeroPageX, 6) \
+    X(ASL_ABS, Absolute, 6) X(ASL_ABSX, AbsoluteX, 7) X(LSR_ACC, Accumulator, 2) \
+    X(LSR_ZP, ZeroPage, 5) X(LSR_ZPX, ZeroPageX, 6) X(LSR_ABS, Absolute, 6) \
+    X(LSR_ABSX, AbsoluteX, 7) X(ROL_ACC, Accumulator, 2) X(ROL_ZP, ZeroPage, 5) \
+    X(ROL_ZPX, ZeroPageX, 6) X(ROL_ABS, Absolute, 6) X(ROL_ABSX, AbsoluteX, 7) \
+    X(ROR_ACC, Accumulator, 2) X(ROR_ZP, ZeroPage, 5) X(ROR_ZPX, ZeroPageX, 6) \
+    X(ROR_ABS, Absolute, 6) X(ROR_ABSX, AbsoluteX, 7) \
+    /* Jumps And Calls */ \
+    X(JSR, Absolute, 6) X(RTS, Implied, 6) X(JMP_ABS, Absolute, 3) X(JMP_IND, Indirect, 5) \
+    /* System functions */ \
+    X(BRK, Implied, 7) X(RTI, Implied, 6) X(NOP, Implied, 2)
+
+template <typename BusT, cp6502::Timing T>
+struct cp6502::BasicCPU {
+    static constexpr Timing CycleTiming = T;
+
     Word PC;        // program counter
     Byte SP;        // stack pointer
 
@@ -65,100 +354,276 @@ struct cp6502::CPU {
         };
     };
 
-    void Reset(Word pc, Mem &memory) {
+#if defined(CP6502_LAZY_FLAGS)
+    // C/Z/V/N while Execute runs; see SyncFlags
+    Byte LazyC, LazyV;
+    Byte LazyZ, LazyN;  // values Z and N were last set from
+#endif
+
+    // Interrupt inputs, taken between instructions by TakeInterrupt. IRQ is a
+    // level, one bit per device holding it; NMI and RESET are edges, each
+    // taken once.
+    Byte IRQ = 0;
+    bool NMI = false;
+    bool RESET = false;
+
+    // The loop last jumped back to. A loop whose body only reads, and which
+    // comes round to the same registers and flags, will go on doing so until
+    // something outside Execute changes memory or raises an interrupt, such
+    // as "JMP *" or "LDA status / BEQ back"; JumpedBack then charges its
+    // iterations in bulk up to the end of the budget.
+    struct IdleLoop {
+        Word Start, End;    // the loop spans [Start, End), End just past its jump back
+        bool Candidate;     // the body runs straight through and writes nothing
+        bool Armed;         // what follows was taken at the last jump back, with
+                            // nothing but the body run since
+        Byte A, X, Y, SP, PS;
+        s32 Cycles;         // budget left then
+    };
+    static constexpr Word MAX_IDLE_LOOP = 32;   // bytes
+    IdleLoop Idle{};
+    u64 IdleCyclesSkipped = 0;
+
+#if defined(CP6502_OPCODE_COUNTS)
+    // Counted by Execute since Reset or ClearCounts, through any dispatch
+    // and the block cache; not the trips of an idle loop charged in bulk, or
+    // blocks the JIT runs as native code
+    OpcodeCounts Counts;
+
+    void ClearCounts() {
+        Counts = {};
+    }
+#endif
+
+    // Stops Execute at a BRK instead of taking it, or at a jump or branch to
+    // itself, the trap 6502 test suites end on
+    bool StopOnBRK = false;
+    bool StopOnTrap = false;
+    // Why the running Execute is to stop, and the budget it had left then
+    StopReason Stop;
+    s32 StopCycles;
+
+    void Reset(Word pc, BusT& memory) {
+        Reset(pc);
+        memory.Initialise();
+    }
+
+    // Resets the registers only, leaving memory as it is
+    void Reset(Word pc) {
         PC = pc;
         SP = 0xFF;
         C = Z = I = D = B = V = N = 0;
         A = X = Y = 0;
-        memory.Initialise();
+        IRQ = 0;
+        NMI = RESET = false;
+        Idle.Armed = false;
+        IdleCyclesSkipped = 0;
+#if defined(CP6502_OPCODE_COUNTS)
+        ClearCounts();
+#endif
+    }
+
+    void AssertIRQ(Byte source = 1) {
+        IRQ |= source;
+    }
+
+    void ReleaseIRQ(Byte source = 1) {
+        IRQ &= ~source;
+    }
+
+    // Takes a pending RESET, else NMI, else IRQ unless I is set, charging
+    // its 7 cycles; false if there is none to take. Call between Executes.
+    bool TakeInterrupt(s32& cycles, BusT& memory);
+
+    // Charges n cycles of the opcode's base count. With Timing::PerInstruction
+    // Execute charges the whole base count up front, so this does nothing.
+    static void Spend(s32& cycles, s32 n = 1) {
+        if constexpr (T == Timing::PerAccess)
+            cycles -= n;
+    }
+
+    // Charges an opcode's whole base count, with Timing::PerInstruction
+    static void SpendInstruction(s32& cycles, s32 baseCycles) {
+        if constexpr (T == Timing::PerInstruction)
+            cycles -= baseCycles;
     }
 
-    Byte FetchByte(s32& cycles, Mem const& memory) {
-        Byte data = memory[PC++];
+    // Charges a cycle beyond the base count: a page crossed or a branch taken
+    static void SpendExtra(s32& cycles) {
         --cycles;
+    }
+
+    // Counts into Counts with CP6502_OPCODE_COUNTS, and compile to nothing
+    // without it
+    void CountOpcode([[maybe_unused]] Byte opcode) {
+#if defined(CP6502_OPCODE_COUNTS)
+        ++Counts.Executed[opcode];
+#endif
+    }
+    void CountPageCross() {
+#if defined(CP6502_OPCODE_COUNTS)
+        ++Counts.PageCrosses;
+#endif
+    }
+    void CountBranch([[maybe_unused]] bool taken, [[maybe_unused]] bool pageChanged) {
+#if defined(CP6502_OPCODE_COUNTS)
+        ++(taken ? Counts.BranchesTaken : Counts.BranchesNotTaken);
+        Counts.BranchPageCrosses += pageChanged;
+#endif
+    }
+
+    Byte FetchByte(s32& cycles, BusT const& memory) {
+        Byte data = memory.Read(PC++);
+        Spend(cycles);
         return data;
     }
 
-    Word FetchWord(s32& cycles, Mem const& memory) {
+    Word FetchWord(s32& cycles, BusT const& memory) {
         // 6502 is little endian;
-        Word data = memory[PC++];
-        data |= (memory[PC++] << 8);
-        cycles -= 2;
+        Word data = memory.Read(PC++);
+        data |= (memory.Read(PC++) << 8);
+        Spend(cycles, 2);
         return data;
     }
 
-    Byte ReadByte(s32& cycles, Word addr, Mem const& memory) {
-        Byte data = memory[addr];
-        --cycles;
+    Byte ReadByte(s32& cycles, Word addr, BusT const& memory) {
+        Byte data = memory.Read(addr);
+        Spend(cycles);
         return data;
     }
 
-    Word ReadWord(s32& cycles, Word addr, Mem const& memory) {
+    Word ReadWord(s32& cycles, Word addr, BusT const& memory) {
         Byte loByte = ReadByte(cycles, addr, memory);
         Byte hiByte = ReadByte(cycles, addr + 1, memory);
         return loByte | (hiByte << 8);
     }
 
-    void WriteByte(Byte value, s32& cycles, Word addr, Mem& memory) {
-        memory[addr] = value;
-        --cycles;
+    void WriteByte(Byte value, s32& cycles, Word addr, BusT& memory) {
+        memory.Write(addr, value);
+        Spend(cycles);
     }
 
-    void WriteWord(Word value, s32& cycles, u32 address, Mem& memory) {
-        memory.Data[address] = value & 0xFF;
-        memory.Data[address + 1] = (value >> 8);
-        cycles -= 2;
+    void WriteWord(Word value, s32& cycles, u32 address, BusT& memory) {
+        memory.Write(address, value & 0xFF);
+        memory.Write(Word(address + 1), value >> 8);
+        Spend(cycles, 2);
     }
 
     Word SPToAddress() const {
         return StackBase + SP;
     }
 
-    void PushPCMinusOneToStack(s32& cycles, Mem& memory) {
+    void PushPCMinusOneToStack(s32& cycles, BusT& memory) {
         --SP;
         WriteWord(PC-1, cycles, SPToAddress(), memory);
         --SP;
     }
 
-    void PushPCPlusOneToStack(s32& cycles, Mem& memory) {
+    void PushPCPlusOneToStack(s32& cycles, BusT& memory) {
         --SP;
         WriteWord(PC+1, cycles, SPToAddress(), memory);
         --SP;
     }
 
-    void PushPCToStack(s32& cycles, Mem& memory) {
+    void PushPCToStack(s32& cycles, BusT& memory) {
         --SP;
         WriteWord(PC, cycles, SPToAddress(), memory);
         --SP;
     }
 
-    void PushByteOntoStack(s32& cycles, Byte value, Mem& memory) {
-        memory[SPToAddress()] = value;
-        --cycles;
+    void PushByteOntoStack(s32& cycles, Byte value, BusT& memory) {
+        memory.Write(SPToAddress(), value);
+        Spend(cycles);
         --SP;
-        --cycles;
+        Spend(cycles);
     }
 
-    Byte PopByteFromStack(s32& cycles, Mem& memory) {
+    Byte PopByteFromStack(s32& cycles, BusT& memory) {
         ++SP;
         Byte value = ReadByte(cycles, SPToAddress(), memory);
-        cycles--;
+        Spend(cycles);
         return value;
     }
 
-    Word PopWordFromStack(s32& cycles, Mem& memory) {
+    Word PopWordFromStack(s32& cycles, BusT& memory) {
         ++SP;
         Word addr = ReadWord(cycles, SPToAddress(), memory);
         ++SP;
-        --cycles;
+        Spend(cycles);
         return addr;
     }
 
     void LoadRegisterSetStatus(Byte reg) {
-        Z = (reg == 0);
-        N = (reg & 0b10000000) > 0;
+        SetZN(reg, reg);
+    }
+
+    // Condition flags as instructions see them. With CP6502_LAZY_FLAGS,
+    // Execute keeps C/Z/V/N out of PS: Z and N as the values they were last
+    // set from, C and V as whole bytes, so setting a flag is a plain store
+    // rather than a read-modify-write of the PS bitfield. SyncFlags writes
+    // them back for PHP/BRK, an illegal opcode and the caller of Execute;
+    // LoadFlags picks up PS after PLP/RTI and on entry to Execute.
+#if defined(CP6502_LAZY_FLAGS)
+    Byte GetC() const { return LazyC; }
+    bool GetZ() const { return LazyZ == 0; }
+    bool GetV() const { return LazyV; }
+    bool GetN() const { return LazyN & NegativeFlag; }
+    void SetC(Byte carry) { LazyC = carry; }
+    void SetV(bool overflow) { LazyV = overflow; }
+    void SetZN(Byte zero, Byte negative) {
+        LazyZ = zero;
+        LazyN = negative;
+    }
+    // Sets the flags in mask (C/Z/V/N only) from their PS bit positions in flags
+    void SetFlags(Byte mask, Byte flags) {
+        if (mask & CarryFlag) LazyC = flags & CarryFlag;
+        if (mask & ZeroFlag) LazyZ = !(flags & ZeroFlag);
+        if (mask & OverflowFlag) LazyV = (flags & OverflowFlag) != 0;
+        if (mask & NegativeFlag) LazyN = flags & NegativeFlag;
+    }
+
+    void SyncFlags() {
+        C = LazyC;
+        Z = LazyZ == 0;
+        V = LazyV;
+        N = LazyN >> 7;
+    }
+
+    void LoadFlags() {
+        LazyC = C;
+        LazyZ = !Z;
+        LazyV = V;
+        LazyN = N << 7;
     }
 
+    // PS with C/Z/V/N as instructions see them, at any time
+    Byte Status() const {
+        return (PS & ~(CarryFlag | ZeroFlag | OverflowFlag | NegativeFlag)) |
+               GetC() | (GetZ() << 1) | (GetV() << 6) | (GetN() << 7);
+    }
+#else
+    Byte GetC() const { return C; }
+    bool GetZ() const { return Z; }
+    bool GetV() const { return V; }
+    bool GetN() const { return N; }
+    void SetC(Byte carry) { C = carry; }
+    void SetV(bool overflow) { V = overflow; }
+    void SetZN(Byte zero, Byte negative) {
+        Z = (zero == 0);
+        N = (negative & 0b10000000) > 0;
+    }
+    void SetFlags(Byte mask, Byte flags) {
+        PS = (PS & ~mask) | flags;
+    }
+
+    void SyncFlags() {}
+    void LoadFlags() {}
+
+    Byte Status() const {
+        return PS;
+    }
+#endif
+
     static constexpr Byte
         // LDA
         INS_LDA_IM = 0xA9,
@@ -336,72 +801,163 @@ struct cp6502::CPU {
         INS_NOP = 0xEA
         ;
 
-    Word LoadProg(Byte* prog, u32 numBytes, Mem& memory);
-    s32 Execute(s32 cycles, Mem& memory);
+    using Handler = void (BasicCPU::*)(s32& cycles, BusT& memory, Word operand);
+    // Fetches the operand bytes and runs the opcode
+    using OpHandler = void (*)(BasicCPU& cpu, s32& cycles, BusT& memory);
+    // Runs the opcode on operand bytes decoded ahead of time
+    using DecodedHandler = void (*)(BasicCPU& cpu, s32& cycles, BusT& memory, Word operand);
+
+    Word LoadProg(Byte* prog, u32 numBytes, BusT& memory);
+    // Runs until cycles are used or something in StopReason stops it first.
+    // Nothing is thrown.
+    template <Dispatch D = DefaultDispatch>
+    ExecuteResult Execute(s32 cycles, BusT& memory);
+    // As above, recording each instruction in trace first; see trace.hpp
+    template <Dispatch D = DefaultDispatch>
+    ExecuteResult Execute(s32 cycles, BusT& memory, TraceRing& trace);
+    // As above, streaming the trace to a file; see tracefile.hpp
+    template <Dispatch D = DefaultDispatch>
+    ExecuteResult Execute(s32 cycles, BusT& memory, TraceWriter& trace);
+    // As above, counting where the cycles go; see profiler.hpp
+    template <Dispatch D = DefaultDispatch>
+    ExecuteResult Execute(s32 cycles, BusT& memory, Profiler& profiler);
+    // Both of the above, with the trace as a policy
+    template <Dispatch D, typename TraceT>
+    ExecuteResult Run(s32 cycles, BusT& memory, TraceT trace);
+    template <typename TraceT>
+    ExecuteResult ExecuteThreaded(s32 cycles, BusT& memory, TraceT trace);
+    // Runs pre-decoded basic blocks from cache instead of decoding every
+    // instruction; see blockcache.hpp
+    ExecuteResult Execute(s32 cycles, BusT& memory, BlockCache& cache) requires std::is_same_v<BasicCPU, CPU>;
+#if defined(CP6502_JIT)
+    // As above, translating hot blocks to native code; see jit.hpp
+    ExecuteResult Execute(s32 cycles, BusT& memory, Jit& jit) requires std::is_same_v<BasicCPU, CPU>;
+#endif
+    // As Execute, returning to run events only when one falls due and taking
+    // interrupts in between; see scheduler.hpp
+    template <Dispatch D = DefaultDispatch>
+    ExecuteResult Execute(s32 cycles, BusT& memory, Scheduler& scheduler);
+
+    // Ends the running Execute once the instruction in hand has finished,
+    // without a check per instruction: the budget left is put aside and the
+    // loop sees none
+    void StopAt(s32& cycles, StopReason reason) {
+        Stop = reason;
+        StopCycles = cycles;
+        cycles = 0;
+    }
+
+    // What Execute returns, from the cycles it was given and has left
+    ExecuteResult EndExecute(s32 cyclesRequested, s32 cycles) {
+        SyncFlags();
+        if (Stop != StopReason::Budget)
+            cycles = StopCycles;
+        return { cyclesRequested - cycles, Stop, PC };
+    }
 
     void PrintStatus() const {
         printf("A: %d X: %d Y: %d\n", A, X, Y);
         printf("PC: %d SP: %d\n", PC, SP);
     }
 
-    Word AddrZeroPage(s32& cycles, Mem const& memory) {
-        Byte zeroPageAddr = FetchByte(cycles, memory);
-        return zeroPageAddr;
+    template <AddrMode Mode>
+    Word FetchOperand(s32& cycles, BusT const& memory) {
+        if constexpr (InstructionLength(Mode) == 3)
+            return FetchWord(cycles, memory);
+        else if constexpr (InstructionLength(Mode) == 2)
+            return FetchByte(cycles, memory);
+        else
+            return 0;
     }
 
-    Word AddrZeroPageXY(s32& cycles, Byte regXY, Mem const& memory) {
-        Byte addr = FetchByte(cycles, memory);
-        addr += regXY;
-        --cycles;
-        return addr;
-    }
+    // Effective address helpers, given the operand bytes of the instruction
 
-    Word AddrAbsolute(s32& cycles, Mem const& memory) {
-        Word addr = FetchWord(cycles, memory);
+    Word AddrZeroPageXY(s32& cycles, Word operand, Byte regXY) {
+        Byte addr = operand;
+        addr += regXY;
+        Spend(cycles);
         return addr;
     }
 
-    Word AddrAbsoluteXY(s32& cycles, Byte regXY, Mem const& memory) {
-        Word absAddr = FetchWord(cycles, memory);
-        Word addr = absAddr + regXY;
-        bool pageCrossed = (absAddr & 0xFF00) != (addr & 0xFF00);
-        if (pageCrossed)
-            --cycles;
+    Word AddrAbsoluteXY(s32& cycles, Word operand, Byte regXY) {
+        Word addr = operand + regXY;
+        bool pageCrossed = (operand & 0xFF00) != (addr & 0xFF00);
+        if (pageCrossed) {
+            SpendExtra(cycles);
+            CountPageCross();
+        }
         return addr;
     }
 
-    Word AddrAbsoluteXY_5(s32& cycles, Byte regXY, Mem const& memory) {
-        Word absAddr = FetchWord(cycles, memory);
-        Word addr = absAddr + regXY;
-        --cycles;
+    Word AddrAbsoluteXY_5(s32& cycles, Word operand, Byte regXY) {
+        Word addr = operand + regXY;
+        Spend(cycles);
         return addr;
     }
 
-    Word AddrIndirectX(s32& cycles, Mem const& memory) {
-        Byte zpAddr = FetchByte(cycles, memory);
+    Word AddrIndirectX(s32& cycles, Word operand, BusT const& memory) {
+        Byte zpAddr = operand;
         zpAddr += X;
-        --cycles;
+        Spend(cycles);
         Word effectiveAddr = ReadWord(cycles, zpAddr, memory);
         return effectiveAddr;
     }
 
-    Word AddrIndirectY(s32& cycles, Mem const& memory) {
-        Byte zpAddr = FetchByte(cycles, memory);
-        Word effectiveAddr = ReadWord(cycles, zpAddr, memory);
+    Word AddrIndirectY(s32& cycles, Word operand, BusT const& memory) {
+        Word effectiveAddr = ReadWord(cycles, operand, memory);
         Word effectiveAddrY = effectiveAddr + Y;
         const bool pageCrossed = (effectiveAddr & 0xFF00) != (effectiveAddrY & 0xFF00);
-        if (pageCrossed)
-            --cycles;
+        if (pageCrossed) {
+            SpendExtra(cycles);
+            CountPageCross();
+        }
         return effectiveAddrY;
     }
 
-    Word AddrIndirectY_6(s32& cycles, Mem const& memory) {
-        Byte zpAddr = FetchByte(cycles, memory);
-        Word effectiveAddr = ReadWord(cycles, zpAddr, memory);
+    Word AddrIndirectY_6(s32& cycles, Word operand, BusT const& memory) {
+        Word effectiveAddr = ReadWord(cycles, operand, memory);
         Word effectiveAddrY = effectiveAddr + Y;
-        --cycles;
+        Spend(cycles);
         return effectiveAddrY;
     }
 
+    // Operations shared between the opcode handlers
+    void LoadRegister(s32& cycles, Word addr, Byte& reg, BusT const& memory);
+    void And(s32& cycles, Word addr, BusT const& memory);
+    void Eor(s32& cycles, Word addr, BusT const& memory);
+    void Ora(s32& cycles, Word addr, BusT const& memory);
+    void Bit(s32& cycles, Word addr, BusT const& memory);
+    void Inc(s32& cycles, Word addr, BusT& memory);
+    void Dec(s32& cycles, Word addr, BusT& memory);
+    void BranchIf(s32& cycles, BusT const& memory, bool condition, Byte offset);
+    void JumpedBack(s32& cycles, BusT const& memory, Word end);
+    bool IsIdleCandidate(Word start, Word end, BusT const& memory) const;
+    void ADC(Byte operand);
+    void SBC(Byte operand);
+    void Compare(Byte operand, Byte reg);
+    Byte ASL(s32& cycles, Byte operand);
+    Byte LSR(s32& cycles, Byte operand);
+    Byte ROL(s32& cycles, Byte operand);
+    Byte ROR(s32& cycles, Byte operand);
+    void PushPSToStack(s32& cycles, BusT& memory);
+    void PopPSFromStack(s32& cycles, BusT& memory);
+
+    // Opcode handlers, called with PC just past the whole instruction and the
+    // operand bytes (if any) already fetched
+#define CP6502_DECLARE_HANDLER(name, mode, baseCycles) \
+    void Op_##name(s32& cycles, BusT& memory, Word operand);
+    CP6502_OPCODES(CP6502_DECLARE_HANDLER)
+#undef CP6502_DECLARE_HANDLER
+    void Op_Illegal(s32& cycles, BusT& memory, Word operand);
 };
 
+// The block cache and the translator run on Mem only
+template <>
+cp6502::ExecuteResult cp6502::CPU::Execute(s32 cycles, Mem& memory, BlockCache& cache);
+#if defined(CP6502_JIT)
+template <>
+cp6502::ExecuteResult cp6502::CPU::Execute(s32 cycles, Mem& memory, Jit& jit);
+#endif
+
+extern template struct cp6502::BasicCPU<cp6502::Mem, cp6502::Timing::PerAccess>;
+extern template struct cp6502::BasicCPU<cp6502::Mem, cp6502::Timing::PerInstruction>;
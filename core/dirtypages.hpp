@@ -0,0 +1,58 @@
+#pragma once
+#include <bitset>
+
+#include "cp6502.hpp"
+
+// Pages of a Mem written since the last Clear, for exporting memory a few
+// pages at a time instead of all 64K.
+//
+// Built on Mem::WriteGeneration rather than a bitmap of its own, so the
+// interpreter and translated code keep doing one increment per store. Like
+// the block cache, it counts any access through the non-const
+// Mem::operator[] as a write.
+struct cp6502::DirtyPages {
+    using Bitmap = std::bitset<Mem::NUM_PAGES>;
+
+    explicit DirtyPages(Mem const& memory) : Memory(memory) {
+        Clear();
+    }
+
+    bool IsDirty(u32 page) const {
+        return Memory.WriteGeneration[page] != Seen[page];
+    }
+
+    Bitmap Dirty() const {
+        Bitmap dirty;
+        for (u32 page = 0; page < Mem::NUM_PAGES; ++page)
+            dirty[page] = IsDirty(page);
+        return dirty;
+    }
+
+    // Calls fn(address, size) for each run of consecutive dirty pages
+    template <typename Fn>
+    void ForEachDirtyRange(Fn fn) const {
+        u32 page = 0;
+        while (page < Mem::NUM_PAGES) {
+            if (!IsDirty(page)) {
+                ++page;
+                continue;
+            }
+            const u32 first = page;
+            while (page < Mem::NUM_PAGES && IsDirty(page))
+                ++page;
+            fn(first * Mem::PAGE_SIZE, (page - first) * Mem::PAGE_SIZE);
+        }
+    }
+
+    void Clear() {
+        for (u32 page = 0; page < Mem::NUM_PAGES; ++page)
+            Seen[page] = Memory.WriteGeneration[page];
+    }
+
+    void Clear(u32 page) {
+        Seen[page] = Memory.WriteGeneration[page];
+    }
+
+    Mem const& Memory;
+    u32 Seen[Mem::NUM_PAGES];   // WriteGeneration as of the last Clear
+};
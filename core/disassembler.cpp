@@ -0,0 +1,90 @@
+#include "disassembler.hpp"
+
+#include <stdio.h>
+
+#include "opcodes.hpp"
+#include "symbols.hpp"
+
+namespace cp6502 {
+
+namespace {
+
+// "$10" or "$0400", or the label at or below address
+std::string Address(Word address, bool zeroPage, Symbols const* symbols) {
+    if (symbols && !symbols->Find(address).Name.empty())
+        return symbols->Format(address);
+    char text[8];
+    snprintf(text, sizeof(text), zeroPage ? "$%02X" : "$%04X", address);
+    return text;
+}
+
+} // namespace
+
+std::string Disassemble(Word pc, Byte opcode, Byte low, Byte high, Symbols const* symbols) {
+    OpcodeInfo const& info = Opcodes[opcode];
+    char text[8];
+    if (!info.Implemented()) {
+        snprintf(text, sizeof(text), "$%02X", opcode);
+        return std::string(".byte ") + text;
+    }
+    const Word absolute = Word(low | high << 8);
+    std::string line(info.Mnemonic);
+    switch (info.Mode) {
+        case AddrMode::Implied:
+            break;
+        case AddrMode::Accumulator:
+            line += " A";
+            break;
+        case AddrMode::Immediate:
+            snprintf(text, sizeof(text), " #$%02X", low);
+            line += text;
+            break;
+        case AddrMode::ZeroPage:
+            line += " " + Address(low, true, symbols);
+            break;
+        case AddrMode::ZeroPageX:
+            line += " " + Address(low, true, symbols) + ",X";
+            break;
+        case AddrMode::ZeroPageY:
+            line += " " + Address(low, true, symbols) + ",Y";
+            break;
+        case AddrMode::Absolute:
+            line += " " + Address(absolute, false, symbols);
+            break;
+        case AddrMode::AbsoluteX:
+            line += " " + Address(absolute, false, symbols) + ",X";
+            break;
+        case AddrMode::AbsoluteY:
+            line += " " + Address(absolute, false, symbols) + ",Y";
+            break;
+        case AddrMode::Indirect:
+            line += " (" + Address(absolute, false, symbols) + ")";
+            break;
+        case AddrMode::IndirectX:
+            line += " (" + Address(low, true, symbols) + ",X)";
+            break;
+        case AddrMode::IndirectY:
+            line += " (" + Address(low, true, symbols) + "),Y";
+            break;
+        case AddrMode::Relative:
+            line += " " + Address(Word(pc + 2 + SByte(low)), false, symbols);
+            break;
+    }
+    return line;
+}
+
+std::string FormatTrace(TraceEntry const& entry, Symbols const* symbols) {
+    char text[64];
+    snprintf(text, sizeof(text), "$%04X ", entry.PC);
+    std::string line = text;
+    if (symbols) {
+        snprintf(text, sizeof(text), "%-24s ", symbols->Format(entry.PC).c_str());
+        line += text;
+    }
+    snprintf(text, sizeof(text), "A=%02X X=%02X Y=%02X SP=%02X PS=%02X ", entry.A, entry.X, entry.Y, entry.SP,
+             entry.PS);
+    line += text;
+    return line + Disassemble(entry, symbols);
+}
+
+} // namespace cp6502
@@ -0,0 +1,31 @@
+#pragma once
+#include <string>
+
+#include "cp6502.hpp"
+#include "trace.hpp"
+
+// One instruction as assembly text, decoded through Opcodes: "LDA #$01",
+// "STA $0200,X", "BNE $0403". Given symbols, addresses the instruction
+// refers to (not immediates) read as "label+offset" instead, e.g.
+// "JSR report_error" or "BNE start+3". Opcodes without a handler read as
+// ".byte $FF".
+namespace cp6502 {
+
+// The instruction at pc made of opcode and the operand bytes after it
+std::string Disassemble(Word pc, Byte opcode, Byte low, Byte high, Symbols const* symbols = nullptr);
+
+inline std::string Disassemble(TraceEntry const& entry, Symbols const* symbols = nullptr) {
+    return Disassemble(entry.PC, entry.Opcode, entry.Operand[0], entry.Operand[1], symbols);
+}
+
+// The instruction at pc in memory
+template <typename BusT>
+std::string Disassemble(Word pc, BusT const& memory, Symbols const* symbols = nullptr) {
+    return Disassemble(pc, memory.Read(pc), memory.Read(Word(pc + 1)), memory.Read(Word(pc + 2)), symbols);
+}
+
+// "$0400 start      A=00 X=00 Y=00 SP=FF PS=24 LDA #$01", one line of a
+// trace as text; the label column is left out without symbols
+std::string FormatTrace(TraceEntry const& entry, Symbols const* symbols = nullptr);
+
+}
@@ -0,0 +1,690 @@
+#include "jit.hpp"
+#include "opcodes.hpp"
+
+#include <stddef.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <initializer_list>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace cp6502 {
+
+namespace {
+
+// x86-64 general purpose registers, by encoding
+enum Reg : Byte { RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15 };
+
+// Register use inside translated code. The 6502 registers and flags are kept
+// zero-extended (flags as 0 or 1) so they can be combined as 32-bit values.
+constexpr Reg CpuPtr = RDI, MemPtr = RSI, Taken = RDX, Budget = R14, Entries = R15;
+constexpr Reg RegA = R8, RegX = R9, RegY = R10, RegSP = R11;
+constexpr Reg FlagC = RBX, FlagZ = RBP, FlagV = R12, FlagN = R13;
+constexpr Reg SavedRegs[] = { RBX, RBP, R12, R13, R14, R15 };
+
+enum Cond : Byte { O = 0x0, B = 0x2, AE = 0x3, E = 0x4, NE = 0x5, S = 0x8, GE = 0xD };
+enum AluOp : Byte { Add = 0, Or = 1, Adc = 2, And = 4, Xor = 6, Cmp = 7 };
+enum ShiftOp : Byte { Rcl = 2, Rcr = 3, Shl = 4, Shr = 5 };
+
+// A register, or memory at [Base + Index * (1 << Scale) + Disp]
+struct Operand {
+    bool IsReg;
+    Reg Base;
+    int Index;
+    Byte Scale;
+    s32 Disp;
+
+    bool IsStatic() const {
+        return !IsReg && Index < 0;
+    }
+};
+
+constexpr Operand R(Reg reg) {
+    return { true, reg, -1, 0, 0 };
+}
+
+constexpr Operand M(Reg base, s32 disp) {
+    return { false, base, -1, 0, disp };
+}
+
+constexpr Operand M(Reg base, Reg index, Byte scale, s32 disp) {
+    return { false, base, index, scale, disp };
+}
+
+// Just enough of an x86-64 assembler for the translator. Every instruction
+// gets a REX prefix, so byte registers 4-7 always mean SPL/BPL/SIL/DIL, and
+// memory operands always use a 32-bit displacement.
+struct Emitter {
+    std::vector<Byte> Bytes;
+
+    u32 Here() const {
+        return Bytes.size();
+    }
+
+    void Emit(Byte b) {
+        Bytes.push_back(b);
+    }
+
+    void Emit32(u32 value) {
+        for (int i = 0; i < 4; ++i)
+            Emit(value >> (8 * i));
+    }
+
+    void Instr(std::initializer_list<Byte> opcode, int reg, Operand const& rm, bool wide = false) {
+        Byte rex = 0x40 | (wide ? 8 : 0) | ((reg & 8) >> 1) | ((rm.Base & 8) >> 3);
+        if (rm.Index >= 0)
+            rex |= (rm.Index & 8) >> 2;
+        Emit(rex);
+        for (Byte b : opcode)
+            Emit(b);
+        if (rm.IsReg) {
+            Emit(0xC0 | (reg & 7) << 3 | (rm.Base & 7));
+        } else if (rm.Index < 0) {
+            Emit(0x80 | (reg & 7) << 3 | (rm.Base & 7));
+            Emit32(rm.Disp);
+        } else {
+            Emit(0x84 | (reg & 7) << 3);
+            Emit(rm.Scale << 6 | (rm.Index & 7) << 3 | (rm.Base & 7));
+            Emit32(rm.Disp);
+        }
+    }
+
+    // 8-bit
+    void Load8(Reg dst, Operand const& src) { Instr({ 0x8A }, dst, src); }
+    void Store8(Operand const& dst, Reg src) { Instr({ 0x88 }, src, dst); }
+    void Store8(Operand const& dst, Byte value) { Instr({ 0xC6 }, 0, dst); Emit(value); }
+    void MovImm8(Reg dst, Byte value) { Store8(R(dst), value); }
+    void Alu8(AluOp op, Reg dst, Operand const& src) { Instr({ Byte(op * 8 + 2) }, dst, src); }
+    void Alu8(AluOp op, Operand const& dst, Byte value) { Instr({ 0x80 }, op, dst); Emit(value); }
+    void Test8(Reg a, Reg b) { Instr({ 0x84 }, b, R(a)); }
+    void Test8(Operand const& a, Byte value) { Instr({ 0xF6 }, 0, a); Emit(value); }
+    void Not8(Reg reg) { Instr({ 0xF6 }, 2, R(reg)); }
+    void Inc8(Operand const& dst) { Instr({ 0xFE }, 0, dst); }
+    void Dec8(Operand const& dst) { Instr({ 0xFE }, 1, dst); }
+    void Shift8(ShiftOp op, Operand const& dst) { Instr({ 0xD0 }, op, dst); }
+    void Set(Cond cond, Reg dst) { Instr({ 0x0F, Byte(0x90 + cond) }, 0, R(dst)); }
+
+    // 16-bit
+    void Store16(Operand const& dst, Reg src) { Emit(0x66); Instr({ 0x89 }, src, dst); }
+    void Movzx16(Reg dst, Reg src) { Instr({ 0x0F, 0xB7 }, dst, R(src)); }
+
+    // 32-bit
+    void Movzx8(Reg dst, Operand const& src) { Instr({ 0x0F, 0xB6 }, dst, src); }
+    void Mov32(Reg dst, Reg src) { Instr({ 0x89 }, src, R(dst)); }
+    void MovImm32(Reg dst, u32 value) { Instr({ 0xC7 }, 0, R(dst)); Emit32(value); }
+    void Alu32(AluOp op, Reg dst, Reg src) { Instr({ Byte(op * 8 + 1) }, src, R(dst)); }
+    void Alu32(AluOp op, Reg dst, u32 value) { Instr({ 0x81 }, op, R(dst)); Emit32(value); }
+    void Cmp32(Operand const& a, u32 value) { Instr({ 0x81 }, Cmp, a); Emit32(value); }
+    void Inc32(Operand const& dst) { Instr({ 0xFF }, 0, dst); }
+    void Shift32(ShiftOp op, Reg dst, Byte count) { Instr({ 0xC1 }, op, R(dst)); Emit(count); }
+    void Bt32(Reg reg, Byte bit) { Instr({ 0x0F, 0xBA }, 4, R(reg)); Emit(bit); }
+
+    // 64-bit
+    void Load64(Reg dst, Operand const& src) { Instr({ 0x8B }, dst, src, true); }
+    void Mov64(Reg dst, Reg src) { Instr({ 0x89 }, src, R(dst), true); }
+    void Test64(Reg a, Reg b) { Instr({ 0x85 }, b, R(a), true); }
+    void JumpTo(Reg target) { Instr({ 0xFF }, 4, R(target)); }
+
+    void Push(Reg reg) { Emit(0x40 | (reg >> 3)); Emit(0x50 + (reg & 7)); }
+    void Pop(Reg reg) { Emit(0x40 | (reg >> 3)); Emit(0x58 + (reg & 7)); }
+    void Ret() { Emit(0xC3); }
+
+    // Jumps return the position of their displacement for Bind
+    u32 Jump(Cond cond) {
+        Emit(0x0F);
+        Emit(0x80 + cond);
+        Emit32(0);
+        return Here() - 4;
+    }
+
+    u32 Jump() {
+        Emit(0xE9);
+        Emit32(0);
+        return Here() - 4;
+    }
+
+    void Bind(u32 jump, u32 target) {
+        const u32 rel = target - (jump + 4);
+        memcpy(&Bytes[jump], &rel, 4);
+    }
+
+    void Bind(u32 jump) {
+        Bind(jump, Here());
+    }
+};
+
+const s32 OffsetPC = offsetof(CPU, PC);
+const s32 OffsetSP = offsetof(CPU, SP);
+const s32 OffsetA = offsetof(CPU, A);
+const s32 OffsetX = offsetof(CPU, X);
+const s32 OffsetY = offsetof(CPU, Y);
+const s32 OffsetPS = offsetof(CPU, PS);
+const s32 OffsetGenerations = offsetof(Mem, WriteGeneration);
+
+class Translator {
+public:
+    explicit Translator(BlockCache::Block const& block) : Block(block) {
+    }
+
+    // Fills Code, or returns false if some instruction is not handled
+    bool Translate() {
+        Prologue();
+        Word pc = Block.Start;
+        for (u32 i = 0; i < Block.Count && !Ended; ++i) {
+            BlockCache::Instruction const& ins = Block.Instructions[i];
+            const Word next = pc + ins.Length;
+            Cycles += ins.Cycles;
+            if (!Instruction(ins, Opcodes[ins.Opcode], next))
+                return false;
+            pc = next;
+        }
+        if (!Ended)
+            ExitTo(pc);
+        Bind(Bails, Code.Here());
+        Code.MovImm32(RCX, Block.Start);
+        Bind(Exits, Code.Here());
+        Epilogue();
+        return true;
+    }
+
+    Emitter Code;
+    u32 Body = 0;   // where chained blocks enter, with the 6502 state in registers
+
+private:
+    void Prologue() {
+        for (Reg reg : SavedRegs)
+            Code.Push(reg);
+        Code.Mov32(Budget, Taken);
+        Code.Mov64(Entries, RCX);
+        Code.Alu32(Xor, Taken, Taken);
+        Code.Movzx8(RegA, M(CpuPtr, OffsetA));
+        Code.Movzx8(RegX, M(CpuPtr, OffsetX));
+        Code.Movzx8(RegY, M(CpuPtr, OffsetY));
+        Code.Movzx8(RegSP, M(CpuPtr, OffsetSP));
+        Code.Movzx8(RAX, M(CpuPtr, OffsetPS));
+        UnpackStatus(RAX);
+
+        // Leave to the interpreter if the budget could run out part way
+        // through, the code has been written over or the decimal flag is set
+        Body = Code.Here();
+        Code.Mov32(RAX, Taken);
+        Code.Alu32(Add, RAX, Block.WorstCaseCycles);
+        Code.Alu32(Cmp, RAX, Budget);
+        Bails.push_back(Code.Jump(GE));
+        Code.Cmp32(M(MemPtr, OffsetGenerations + Block.FirstPage * 4), Block.FirstGeneration);
+        Bails.push_back(Code.Jump(NE));
+        if (Block.LastPage != Block.FirstPage) {
+            Code.Cmp32(M(MemPtr, OffsetGenerations + Block.LastPage * 4), Block.LastGeneration);
+            Bails.push_back(Code.Jump(NE));
+        }
+        if (UsesDecimal()) {
+            Code.Test8(M(CpuPtr, OffsetPS), DecimalFlag);
+            Bails.push_back(Code.Jump(NE));
+        }
+    }
+
+    // Charges the base cycles so far and continues with the translated block
+    // starting at the PC in ECX, if there is one, or else returns to Execute.
+    // Every exit gets its own indirect jump, which predicts better than
+    // sharing one.
+    void Chain() {
+        Code.Alu32(Add, Taken, Cycles);
+        Code.Load64(RAX, M(Entries, RCX, 3, 0));
+        Code.Test64(RAX, RAX);
+        Exits.push_back(Code.Jump(E));
+        Code.JumpTo(RAX);
+    }
+
+    void Bind(std::vector<u32> const& jumps, u32 target) {
+        for (u32 jump : jumps)
+            Code.Bind(jump, target);
+    }
+
+    // Arrives with the new PC in ECX
+    void Epilogue() {
+        Code.Store16(M(CpuPtr, OffsetPC), RCX);
+        Code.Store8(M(CpuPtr, OffsetA), RegA);
+        Code.Store8(M(CpuPtr, OffsetX), RegX);
+        Code.Store8(M(CpuPtr, OffsetY), RegY);
+        Code.Store8(M(CpuPtr, OffsetSP), RegSP);
+        PackStatus(RAX);
+        Code.Store8(M(CpuPtr, OffsetPS), RAX);
+        Code.Mov32(RAX, Taken);
+        for (int i = std::size(SavedRegs) - 1; i >= 0; --i)
+            Code.Pop(SavedRegs[i]);
+        Code.Ret();
+    }
+
+    // Loads C/Z/V/N from the status byte in src
+    void UnpackStatus(Reg src) {
+        Code.Mov32(FlagC, src);
+        Code.Alu32(And, FlagC, 1);
+        Code.Mov32(FlagZ, src);
+        Code.Shift32(Shr, FlagZ, 1);
+        Code.Alu32(And, FlagZ, 1);
+        Code.Mov32(FlagV, src);
+        Code.Shift32(Shr, FlagV, 6);
+        Code.Alu32(And, FlagV, 1);
+        Code.Mov32(FlagN, src);
+        Code.Shift32(Shr, FlagN, 7);
+    }
+
+    // Builds the status byte in dst from C/Z/V/N and the other bits of
+    // CPU::PS. Clobbers RCX.
+    void PackStatus(Reg dst) {
+        Code.Movzx8(dst, M(CpuPtr, OffsetPS));
+        Code.Alu32(And, dst, InterruptFlag | DecimalFlag | BreakFlag | UnusedFlag);
+        Code.Alu32(Or, dst, FlagC);
+        for (auto [flag, bit] : { std::pair{ FlagZ, 1 }, std::pair{ FlagV, 6 }, std::pair{ FlagN, 7 } }) {
+            Code.Mov32(RCX, flag);
+            Code.Shift32(Shl, RCX, bit);
+            Code.Alu32(Or, dst, RCX);
+        }
+    }
+
+    // Leaves the block for pc, chaining to its translation if there is one
+    void ExitTo(Word pc) {
+        Code.MovImm32(RCX, pc);
+        Chain();
+    }
+
+    // Blocks are entered only with the decimal flag clear; PLP can set it
+    void ExitIfDecimal(Word next) {
+        if (!UsesDecimal())
+            return;
+        Code.Test8(M(CpuPtr, OffsetPS), DecimalFlag);
+        const u32 binary = Code.Jump(E);
+        ExitTo(next);
+        Code.Bind(binary);
+    }
+
+    bool UsesDecimal() const {
+        for (u32 i = 0; i < Block.Count; ++i) {
+            const std::string_view mnemonic = Opcodes[Block.Instructions[i].Opcode].Mnemonic;
+            if (mnemonic == "ADC" || mnemonic == "SBC")
+                return true;
+        }
+        return false;
+    }
+
+    void SetZN() {
+        Code.Set(E, FlagZ);
+        Code.Set(S, FlagN);
+    }
+
+    void TestZN(Reg reg) {
+        Code.Test8(reg, reg);
+        SetZN();
+    }
+
+    // Emits the effective address of a memory operand, leaving it in RAX
+    // unless it is known at translation time. Reads that cross a page in
+    // the indexed modes take an extra cycle.
+    Operand Address(AddrMode mode, Word operand, bool read) {
+        switch (mode) {
+        case AddrMode::ZeroPage:
+        case AddrMode::Absolute:
+            return M(MemPtr, operand);
+        case AddrMode::ZeroPageX:
+        case AddrMode::ZeroPageY:
+            Code.Mov32(RAX, mode == AddrMode::ZeroPageX ? RegX : RegY);
+            Code.Alu8(Add, R(RAX), operand);
+            return M(MemPtr, RAX, 0, 0);
+        case AddrMode::AbsoluteX:
+        case AddrMode::AbsoluteY: {
+            const Reg index = mode == AddrMode::AbsoluteX ? RegX : RegY;
+            if (read) {
+                Code.MovImm32(RCX, operand & 0xFF);
+                TakeCycleOnCarry(index);
+            }
+            Code.Mov32(RAX, index);
+            Code.Alu32(Add, RAX, operand);
+            Code.Movzx16(RAX, RAX);
+            return M(MemPtr, RAX, 0, 0);
+        }
+        case AddrMode::IndirectX:
+            Code.Mov32(RAX, RegX);
+            Code.Alu8(Add, R(RAX), operand);
+            Code.Movzx8(RCX, M(MemPtr, RAX, 0, 0));
+            Code.Movzx8(RAX, M(MemPtr, RAX, 0, 1));
+            Code.Shift32(Shl, RAX, 8);
+            Code.Alu32(Or, RAX, RCX);
+            return M(MemPtr, RAX, 0, 0);
+        case AddrMode::IndirectY:
+            Code.Movzx8(RAX, M(MemPtr, operand + 1));
+            Code.Shift32(Shl, RAX, 8);
+            Code.Movzx8(RCX, M(MemPtr, operand));
+            Code.Alu32(Or, RAX, RCX);
+            if (read)
+                TakeCycleOnCarry(RegY);
+            Code.Alu32(Add, RAX, RegY);
+            Code.Movzx16(RAX, RAX);
+            return M(MemPtr, RAX, 0, 0);
+        default:
+            return R(RAX);
+        }
+    }
+
+    // Adds a cycle if the low address byte in ECX plus index carries
+    void TakeCycleOnCarry(Reg index) {
+        Code.Alu8(Add, RCX, R(index));
+        Code.Set(B, RCX);
+        Code.Alu32(Add, Taken, RCX);
+    }
+
+    // Bumps the write generation of the page stored to. A store into the
+    // running block ends it, so the rest is re-decoded from memory.
+    void Stored(Operand const& address, Word next) {
+        if (address.IsStatic()) {
+            const Byte page = address.Disp >> 8;
+            Code.Inc32(M(MemPtr, OffsetGenerations + page * 4));
+            if (page == Block.FirstPage || page == Block.LastPage) {
+                ExitTo(next);
+                Ended = true;
+            }
+            return;
+        }
+        Code.Mov32(RCX, RAX);
+        Code.Shift32(Shr, RCX, 8);
+        Code.Inc32(M(MemPtr, RCX, 2, OffsetGenerations));
+        Code.Alu32(Cmp, RCX, Block.FirstPage);
+        const u32 ownFirstPage = Code.Jump(E);
+        Code.Alu32(Cmp, RCX, Block.LastPage);
+        const u32 otherPage = Code.Jump(NE);
+        Code.Bind(ownFirstPage);
+        ExitTo(next);
+        Code.Bind(otherPage);
+    }
+
+    bool Instruction(BlockCache::Instruction const& ins, OpcodeInfo const& info, Word next) {
+        const std::string_view op = info.Mnemonic;
+        const AddrMode mode = info.Mode;
+        const Word operand = ins.Operand;
+        const bool immediate = mode == AddrMode::Immediate;
+
+        if (mode == AddrMode::Indirect)
+            return false;
+        // Leave stack writes over the code of the block to the interpreter
+        const bool pushes = op == "PHA" || op == "PHP" || op == "JSR";
+        if (pushes && Block.FirstPage <= 1 && Block.LastPage >= 1)
+            return false;
+
+        if (op == "LDA" || op == "LDX" || op == "LDY") {
+            const Reg reg = op == "LDA" ? RegA : op == "LDX" ? RegX : RegY;
+            if (immediate)
+                Code.MovImm8(reg, operand);
+            else
+                Code.Load8(reg, Address(mode, operand, true));
+            TestZN(reg);
+        } else if (op == "STA" || op == "STX" || op == "STY") {
+            const Reg reg = op == "STA" ? RegA : op == "STX" ? RegX : RegY;
+            const Operand address = Address(mode, operand, false);
+            Code.Store8(address, reg);
+            Stored(address, next);
+        } else if (op == "AND" || op == "ORA" || op == "EOR" || op == "ADC"
+                   || op == "CMP" || op == "CPX" || op == "CPY") {
+            const AluOp alu = op == "AND" ? And : op == "ORA" ? Or : op == "EOR" ? Xor
+                            : op == "ADC" ? Adc : Cmp;
+            const Reg reg = op == "CPX" ? RegX : op == "CPY" ? RegY : RegA;
+            // The address goes first: taking the page crossing cycle clobbers CF
+            const Operand source = immediate ? R(RAX) : Address(mode, operand, true);
+            if (alu == Adc)
+                Code.Bt32(FlagC, 0);
+            if (immediate)
+                Code.Alu8(alu, R(reg), operand);
+            else
+                Code.Alu8(alu, reg, source);
+            if (alu == Adc) {
+                Code.Set(B, FlagC);
+                Code.Set(O, FlagV);
+            } else if (alu == Cmp) {
+                Code.Set(AE, FlagC);
+            }
+            SetZN();
+        } else if (op == "SBC") {
+            // As CPU::SBC: add the complement
+            if (immediate)
+                Code.MovImm8(RCX, operand);
+            else
+                Code.Load8(RCX, Address(mode, operand, true));
+            Code.Not8(RCX);
+            Code.Bt32(FlagC, 0);
+            Code.Alu8(Adc, RegA, R(RCX));
+            Code.Set(B, FlagC);
+            Code.Set(O, FlagV);
+            SetZN();
+        } else if (op == "BIT") {
+            Code.Load8(RCX, Address(mode, operand, true));
+            Code.Test8(RCX, RegA);
+            Code.Set(E, FlagZ);
+            Code.Bt32(RCX, 7);
+            Code.Set(B, FlagN);
+            Code.Bt32(RCX, 6);
+            Code.Set(B, FlagV);
+        } else if (op == "INC" || op == "DEC") {
+            const Operand address = Address(mode, operand, false);
+            if (op == "INC")
+                Code.Inc8(address);
+            else
+                Code.Dec8(address);
+            SetZN();
+            Stored(address, next);
+        } else if (op == "ASL" || op == "LSR" || op == "ROL" || op == "ROR") {
+            const ShiftOp shift = op == "ASL" ? Shl : op == "LSR" ? Shr : op == "ROL" ? Rcl : Rcr;
+            const bool rotate = shift == Rcl || shift == Rcr;
+            const Operand target = mode == AddrMode::Accumulator ? R(RegA) : Address(mode, operand, false);
+            if (rotate)
+                Code.Bt32(FlagC, 0);
+            Code.Shift8(shift, target);
+            Code.Set(B, FlagC);
+            if (rotate) {
+                // RCL/RCR leave ZF and SF alone
+                Code.Load8(RCX, target);
+                TestZN(RCX);
+            } else {
+                SetZN();
+            }
+            if (mode != AddrMode::Accumulator)
+                Stored(target, next);
+        } else if (op == "TAX" || op == "TAY" || op == "TXA" || op == "TYA" || op == "TSX") {
+            const Reg dst = op[1] == 'A' ? (op[2] == 'X' ? RegX : RegY) : op == "TSX" ? RegX : RegA;
+            const Reg src = op[1] == 'A' ? RegA : op == "TSX" ? RegSP : op[1] == 'X' ? RegX : RegY;
+            Code.Alu32(Xor, dst, dst);
+            Code.Alu8(Or, dst, R(src));
+            SetZN();
+        } else if (op == "TXS") {
+            Code.Mov32(RegSP, RegX);
+        } else if (op == "INX" || op == "INY" || op == "DEX" || op == "DEY") {
+            const Reg reg = op[2] == 'X' ? RegX : RegY;
+            if (op[0] == 'I')
+                Code.Inc8(R(reg));
+            else
+                Code.Dec8(R(reg));
+            SetZN();
+        } else if (op == "CLC") {
+            Code.Alu32(Xor, FlagC, FlagC);
+        } else if (op == "SEC") {
+            Code.MovImm32(FlagC, 1);
+        } else if (op == "CLV") {
+            Code.Alu32(Xor, FlagV, FlagV);
+        } else if (op == "PHA" || op == "PHP") {
+            Reg value = RegA;
+            if (op == "PHP") {
+                // As CPU::PushPSToStack
+                PackStatus(RAX);
+                Code.Alu32(Or, RAX, BreakFlag | UnusedFlag);
+                Code.Mov32(RCX, RAX);
+                value = RCX;
+            }
+            Code.Mov32(RAX, RegSP);
+            Code.Store8(M(MemPtr, RAX, 0, StackBase), value);
+            Code.Dec8(R(RegSP));
+            Code.Inc32(M(MemPtr, OffsetGenerations + (StackBase >> 8) * 4));
+        } else if (op == "PLA") {
+            Code.Inc8(R(RegSP));
+            Code.Mov32(RAX, RegSP);
+            Code.Load8(RegA, M(MemPtr, RAX, 0, StackBase));
+            TestZN(RegA);
+        } else if (op == "PLP") {
+            // As CPU::PopPSFromStack
+            Code.Inc8(R(RegSP));
+            Code.Mov32(RAX, RegSP);
+            Code.Movzx8(RAX, M(MemPtr, RAX, 0, StackBase));
+            Code.Alu32(And, RAX, Byte(~(BreakFlag | UnusedFlag)));
+            Code.Store8(M(CpuPtr, OffsetPS), RAX);
+            UnpackStatus(RAX);
+            ExitIfDecimal(next);
+        } else if (op == "JSR") {
+            // As CPU::PushPCMinusOneToStack, which writes a word at SP - 1
+            const Word returnAddress = next - 1;
+            Code.Dec8(R(RegSP));
+            Code.Mov32(RAX, RegSP);
+            Code.Alu32(Add, RAX, StackBase);
+            Code.Store8(M(MemPtr, RAX, 0, 0), Byte(returnAddress));
+            Code.Store8(M(MemPtr, RAX, 0, 1), Byte(returnAddress >> 8));
+            Code.Dec8(R(RegSP));
+            for (s32 byte = 0; byte < 2; ++byte) {
+                Code.Mov32(RCX, RAX);
+                Code.Alu32(Add, RCX, byte);
+                Code.Shift32(Shr, RCX, 8);
+                Code.Inc32(M(MemPtr, RCX, 2, OffsetGenerations));
+            }
+            ExitTo(operand);
+            Ended = true;
+        } else if (op == "RTS") {
+            Code.Inc8(R(RegSP));
+            Code.Mov32(RAX, RegSP);
+            Code.Movzx8(RCX, M(MemPtr, RAX, 0, StackBase));
+            Code.Movzx8(RAX, M(MemPtr, RAX, 0, StackBase + 1));
+            Code.Shift32(Shl, RAX, 8);
+            Code.Alu32(Or, RCX, RAX);
+            Code.Alu32(Add, RCX, 1);
+            Code.Movzx16(RCX, RCX);
+            Code.Inc8(R(RegSP));
+            Chain();
+            Ended = true;
+        } else if (op == "NOP") {
+        } else if (mode == AddrMode::Relative) {
+            // Jumps to themselves are left to the interpreter, which can stop on them
+            if (Word(next + SByte(operand)) == Word(next - 2))
+                return false;
+            Branch(op, next, Word(next + SByte(operand)));
+        } else if (op == "JMP") {
+            if (operand == Word(next - 3))
+                return false;
+            ExitTo(operand);
+            Ended = true;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    void Branch(std::string_view op, Word next, Word target) {
+        const Reg flag = op == "BEQ" || op == "BNE" ? FlagZ
+                       : op == "BCS" || op == "BCC" ? FlagC
+                       : op == "BVS" || op == "BVC" ? FlagV : FlagN;
+        const bool takenIfSet = op == "BEQ" || op == "BCS" || op == "BVS" || op == "BMI";
+        Code.Test8(flag, flag);
+        const u32 notTaken = Code.Jump(takenIfSet ? E : NE);
+        const bool pageChanged = (target >> 8) != (next >> 8);
+        Code.Alu32(Add, Taken, pageChanged ? 2 : 1);
+        ExitTo(target);
+        Code.Bind(notTaken);
+        ExitTo(next);
+        Ended = true;
+    }
+
+    BlockCache::Block const& Block;
+    std::vector<u32> Exits;     // jumps to the epilogue, with the new PC in ECX
+    std::vector<u32> Bails;     // jumps back to the interpreter at the block start
+    s32 Cycles = 0;             // base cycles of the instructions translated so far, added on exit
+    bool Ended = false;         // no instruction after this one can run
+};
+
+} // namespace
+
+Jit::Jit() : Entries(Mem::MAX_MEM, nullptr) {
+    void* code = mmap(nullptr, CODE_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (code != MAP_FAILED)
+        Code = static_cast<Byte*>(code);
+}
+
+Jit::~Jit() {
+    if (Code)
+        munmap(Code, CODE_SIZE);
+}
+
+void Jit::Flush() {
+    Cache.Flush();
+    std::fill(Entries.begin(), Entries.end(), nullptr);
+    CodeUsed = 0;
+}
+
+bool Jit::Compile(BlockCache::Block& block) {
+    if (!Code)
+        return false;
+    Translator translator(block);
+    if (!translator.Translate())
+        return false;
+
+    std::vector<Byte> const& bytes = translator.Code.Bytes;
+    if (bytes.size() > CODE_SIZE - CodeUsed) {
+        // Start over, dropping every translation
+        for (BlockCache::Block& cached : Cache.Blocks)
+            cached.Native = nullptr;
+        std::fill(Entries.begin(), Entries.end(), nullptr);
+        CodeUsed = 0;
+    }
+    memcpy(Code + CodeUsed, bytes.data(), bytes.size());
+    block.Native = Code + CodeUsed;
+    Entries[block.Start] = Code + CodeUsed + translator.Body;
+    CodeUsed = (CodeUsed + bytes.size() + 15) & ~15u;
+    ++Translations;
+    return true;
+}
+
+template <>
+ExecuteResult CPU::Execute(s32 cycles, Mem& memory, Jit& jit) {
+    const s32 cyclesRequested = cycles;
+    if (jit.Cache.Memory != &memory)
+        jit.Flush();
+    LoadFlags();
+    Idle.Armed = false;
+    Stop = StopReason::Budget;
+    while (cycles > 0) {
+        BlockCache::Block& block = jit.Cache.Lookup(PC, memory);
+        if (block.Count == 0) {
+            SyncFlags();
+            const ExecuteResult step = Execute(1, memory);
+            cycles -= step.Cycles;
+            if (step.Reason != StopReason::Budget)
+                return { cyclesRequested - cycles, step.Reason, PC };
+            LoadFlags();
+            continue;
+        }
+        if (!block.Native && ++block.Executions == Jit::HOT_THRESHOLD)
+            jit.Compile(block);
+        if (block.Native && cycles > block.WorstCaseCycles) {
+            // Translated code keeps the flags in PS
+            SyncFlags();
+            const auto native = reinterpret_cast<Jit::NativeBlock>(block.Native);
+            const s32 taken = native(this, &memory, cycles, jit.Entries.data());
+            LoadFlags();
+            // Translated branches do not track loops
+            Idle.Armed = false;
+            if (taken > 0) {
+                cycles -= taken;
+                continue;
+            }
+        }
+        jit.Cache.Run(block, *this, cycles, memory);
+    }
+    return EndExecute(cyclesRequested, cycles);
+}
+
+} // namespace cp6502
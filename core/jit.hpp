@@ -0,0 +1,54 @@
+#pragma once
+#include <vector>
+
+#include "blockcache.hpp"
+
+// Translation of hot basic blocks to x86-64 code (built with CP6502_JIT).
+//
+// Blocks come from a BlockCache and are interpreted until they have run
+// HOT_THRESHOLD times; then the block is translated into an mmap'd executable
+// buffer if the translator handles every instruction in it (see jit.cpp).
+// Inside translated code A, X, Y, SP and the C/Z/V/N flags live in host
+// registers. A block that ends at the start of another translated block jumps
+// straight into it, and the registers are written back to the CPU only when
+// control returns to Execute.
+//
+// The interpreter still runs a translated block when:
+//  - the remaining budget could run out part way through it, so Execute stops
+//    on the same instruction boundary as the interpreter would,
+//  - it contains ADC/SBC and the decimal flag is set.
+// A translated store into the pages of the running block ends it straight
+// after the store, and the block is re-decoded (and later re-translated) like
+// any other stale block.
+struct cp6502::Jit {
+    static constexpr u32 HOT_THRESHOLD = 16;
+    static constexpr u32 CODE_SIZE = 4 * 1024 * 1024;
+
+    // Runs the block from its first instruction, and any translated blocks
+    // it leads to while they fit in the budget. Returns the cycles taken, or
+    // 0 if the block declined to run.
+    using NativeBlock = s32 (*)(CPU* cpu, Mem* memory, s32 budget, void const* const* entries);
+
+    Jit();
+    ~Jit();
+    Jit(Jit const&) = delete;
+    Jit& operator=(Jit const&) = delete;
+
+    // False if no executable buffer could be mapped; Execute then only interprets
+    bool Available() const {
+        return Code != nullptr;
+    }
+
+    // Translates block, returning false if it holds an instruction the
+    // translator does not handle. Starts the buffer over when it is full.
+    bool Compile(BlockCache::Block& block);
+
+    void Flush();
+
+    BlockCache Cache;
+    std::vector<void const*> Entries;   // PC -> where chained code enters its translation
+    u32 Translations = 0;               // blocks translated since construction
+
+    Byte* Code = nullptr;
+    u32 CodeUsed = 0;
+};
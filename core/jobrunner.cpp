@@ -0,0 +1,127 @@
+#include "jobrunner.hpp"
+
+#include <algorithm>
+
+namespace cp6502 {
+
+JobRunner::JobRunner(u32 numThreads) {
+    if (numThreads == 0)
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (u32 i = 0; i < numThreads; ++i)
+        Workers.push_back(std::make_unique<Worker>());
+    for (u32 i = 0; i < numThreads; ++i)
+        Threads.emplace_back(&JobRunner::Work, this, i);
+}
+
+JobRunner::~JobRunner() {
+    {
+        std::lock_guard<std::mutex> lock(Lock);
+        Stopping = true;
+    }
+    Started.notify_all();
+    for (std::thread& thread : Threads)
+        thread.join();
+}
+
+std::vector<JobRunner::Result> JobRunner::Run(std::vector<Job> const& jobs, Finish const& finish) {
+    std::vector<Result> results(jobs.size());
+    if (jobs.empty())
+        return results;
+
+    std::unique_lock<std::mutex> lock(Lock);
+    Jobs = &jobs;
+    Results = &results;
+    OnFinish = &finish;
+    Error = nullptr;
+    Remaining = jobs.size();
+    for (u32 job = 0; job < jobs.size(); ++job) {
+        Worker& worker = *Workers[job % Workers.size()];
+        std::lock_guard<std::mutex> queueLock(worker.Lock);
+        worker.Queue.push_back(job);
+    }
+    ++Round;
+    Started.notify_all();
+    Finished.wait(lock, [this] { return Remaining == 0; });
+
+    Jobs = nullptr;
+    Results = nullptr;
+    OnFinish = nullptr;
+    if (Error)
+        std::rethrow_exception(Error);
+    return results;
+}
+
+void JobRunner::Work(u32 self) {
+    u32 round = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(Lock);
+            Started.wait(lock, [this, round] { return Stopping || Round != round; });
+            if (Stopping)
+                return;
+            round = Round;
+        }
+        u32 job;
+        while (Take(self, job)) {
+            RunJob(*Workers[self], job);
+            if (Remaining.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(Lock);
+                Finished.notify_one();
+            }
+        }
+    }
+}
+
+bool JobRunner::Take(u32 self, u32& job) {
+    Worker& own = *Workers[self];
+    {
+        std::lock_guard<std::mutex> lock(own.Lock);
+        if (!own.Queue.empty()) {
+            job = own.Queue.back();
+            own.Queue.pop_back();
+            return true;
+        }
+    }
+    for (u32 n = 1; n < Workers.size(); ++n) {
+        Worker& victim = *Workers[(self + n) % Workers.size()];
+        std::lock_guard<std::mutex> lock(victim.Lock);
+        if (!victim.Queue.empty()) {
+            job = victim.Queue.front();
+            victim.Queue.pop_front();
+            ++Steals;
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobRunner::RunJob(Worker& worker, u32 index) {
+    Mem& memory = worker.Memory;
+    memory.Initialise();
+
+    Job const& job = (*Jobs)[index];
+    if (job.Image.size() >= 2) {
+        Word address = job.Image[0] | (job.Image[1] << 8);
+        for (u32 at = 2; at < job.Image.size(); ++at)
+            memory.Write(address++, job.Image[at]);
+    }
+
+    Result& result = (*Results)[index];
+    result.Cpu = job.Cpu;
+    const ExecuteResult ran = result.Cpu.Execute(job.Cycles, memory);
+    result.Cycles = ran.Cycles;
+    result.Stop = ran.Reason;
+    result.Halted = ran.Reason == StopReason::IllegalOpcode || ran.Reason == StopReason::Halt;
+
+    if (*OnFinish) {
+        try {
+            (*OnFinish)(index, result, memory);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(Lock);
+            if (!Error)
+                Error = std::current_exception();
+        }
+    }
+}
+
+} // namespace cp6502
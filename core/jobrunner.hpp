@@ -0,0 +1,85 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "cp6502.hpp"
+
+// Runs independent emulations on a pool of worker threads. Each job is a
+// program image in CPU::LoadProg format, the CPU state to start from and a
+// cycle budget; each runs on a cleared Mem of its own and reports the CPU it
+// ended with.
+//
+// Every worker keeps one Mem for all the jobs it runs. Mem::Initialise
+// zeroes only the pages the previous job wrote, so no job pays for
+// allocating or clearing 64K.
+//
+// Jobs are dealt round-robin to per-worker queues. A worker takes from the
+// back of its own queue and, once that is empty, steals from the front of
+// the others', so workers that draw short jobs help out with long ones.
+struct cp6502::JobRunner {
+    struct Job {
+        std::vector<Byte> Image;    // two-byte load address, then the bytes
+        CPU Cpu;
+        s32 Cycles = 0;
+    };
+
+    struct Result {
+        CPU Cpu;
+        s32 Cycles = 0;         // used, as CPU::Execute returns
+        StopReason Stop = StopReason::Budget;
+        bool Halted = false;    // stopped at an opcode without a handler or one that jams
+    };
+
+    // Called on the worker thread once a job has run, with its index in the
+    // jobs passed to Run; may be called from several threads at once
+    using Finish = std::function<void(u32 job, Result const& result, Mem const& memory)>;
+
+    // numThreads of 0 uses one thread per hardware thread
+    explicit JobRunner(u32 numThreads = 0);
+    ~JobRunner();
+
+    JobRunner(JobRunner const&) = delete;
+    JobRunner& operator=(JobRunner const&) = delete;
+
+    // Runs every job and returns their results in the same order. Exceptions
+    // thrown by finish are rethrown here once the other jobs have run. One
+    // Run at a time.
+    std::vector<Result> Run(std::vector<Job> const& jobs, Finish const& finish = {});
+
+    u32 NumThreads() const {
+        return Workers.size();
+    }
+
+    std::atomic<u32> Steals = 0;    // jobs run by a worker other than the one dealt them
+
+    struct Worker {
+        std::mutex Lock;
+        std::deque<u32> Queue;  // indices into the current jobs
+        Mem Memory;
+    };
+
+    void Work(u32 self);
+    bool Take(u32 self, u32& job);
+    void RunJob(Worker& worker, u32 job);
+
+    std::vector<std::unique_ptr<Worker>> Workers;
+    std::vector<std::thread> Threads;
+
+    std::mutex Lock;
+    std::condition_variable Started;
+    std::condition_variable Finished;
+    u32 Round = 0;          // bumped by Run to start the workers
+    bool Stopping = false;
+    std::atomic<u32> Remaining = 0;     // jobs of the current round not yet run
+    std::vector<Job> const* Jobs = nullptr;
+    std::vector<Result>* Results = nullptr;
+    Finish const* OnFinish = nullptr;
+    std::exception_ptr Error;
+};
@@ -0,0 +1,58 @@
+#include "mapper.hpp"
+
+#include <stdexcept>
+
+namespace cp6502 {
+
+Mapper::Mapper(Bus& bus, u32 windowSize, u32 romSize, u32 ramSize)
+    : Target(bus), WindowSize(windowSize), PagesPerWindow(windowSize / Bus::PAGE_SIZE),
+      NumWindows(Bus::MAX_MEM / windowSize), Rom(romSize), Ram(ramSize) {
+    if (windowSize != 4 * 1024 && windowSize != 8 * 1024 && windowSize != 16 * 1024)
+        throw std::invalid_argument("mapper windows must be 4K, 8K or 16K");
+    if (romSize % windowSize != 0 || ramSize % windowSize != 0)
+        throw std::invalid_argument("mapper ROM and RAM must be whole banks");
+}
+
+void Mapper::SelectRom(u32 window, u32 bank) {
+    if (NumRomBanks() == 0)
+        return;
+    bank %= NumRomBanks();
+    SelectedBank[window] = bank;
+    MapWindow(window, &Rom[bank * WindowSize], false);
+}
+
+void Mapper::SelectRam(u32 window, u32 bank) {
+    if (NumRamBanks() == 0)
+        return;
+    bank %= NumRamBanks();
+    SelectedBank[window] = bank;
+    MapWindow(window, &Ram[bank * WindowSize], true);
+}
+
+void Mapper::MapWindow(u32 window, Byte* data, bool writable) {
+    for (u32 i = 0; i < PagesPerWindow; ++i) {
+        const u32 page = window * PagesPerWindow + i;
+        // Keep the registers reachable, or the bank could never be switched back
+        if (Target.Devices[page] == this)
+            continue;
+        if (writable)
+            Target.MapRam(page, 1, data + i * Bus::PAGE_SIZE);
+        else
+            Target.MapRom(page, 1, data + i * Bus::PAGE_SIZE);
+    }
+}
+
+Byte Mapper::Read(Word address) {
+    const u32 reg = address % Bus::PAGE_SIZE;
+    return reg < 2 * NumWindows ? SelectedBank[reg % NumWindows] : 0;
+}
+
+void Mapper::Write(Word address, Byte value) {
+    const u32 reg = address % Bus::PAGE_SIZE;
+    if (reg < NumWindows)
+        SelectRom(reg, value);
+    else if (reg < 2 * NumWindows)
+        SelectRam(reg - NumWindows, value);
+}
+
+} // namespace cp6502
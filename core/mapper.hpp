@@ -0,0 +1,50 @@
+#pragma once
+#include <vector>
+
+#include "bus.hpp"
+
+// Bank switching for a Bus: backing ROM and RAM of up to several megabytes,
+// shown to the 6502 through fixed-size windows (4K, 8K or 16K) of its 64K
+// address space. Selecting a bank re-points the window's Bus pages at the
+// bank; no bytes are copied.
+//
+// Banks are selected from the host with SelectRom/SelectRam, or by the 6502
+// through the bank registers once the mapper is mapped as a Device:
+//  - offset w selects the ROM bank shown in window w,
+//  - offset NumWindows + w selects the RAM bank shown in window w,
+//  - reading either returns the bank last selected for the window.
+// Bank numbers wrap at the number of banks, as unconnected high address
+// lines would. Windows are only mapped once a bank is selected for them.
+// The pages the mapper itself is mapped at stay its registers: a bank
+// selected for the window holding them fills the rest of the window only.
+struct cp6502::Mapper : Device {
+    static constexpr u32 MAX_WINDOWS = Bus::MAX_MEM / (4 * 1024);
+
+    // windowSize must be 4K, 8K or 16K, and the sizes multiples of it
+    Mapper(Bus& bus, u32 windowSize, u32 romSize, u32 ramSize);
+
+    u32 NumRomBanks() const {
+        return Rom.size() / WindowSize;
+    }
+
+    u32 NumRamBanks() const {
+        return Ram.size() / WindowSize;
+    }
+
+    void SelectRom(u32 window, u32 bank);
+    void SelectRam(u32 window, u32 bank);
+
+    Byte Read(Word address) override;
+    void Write(Word address, Byte value) override;
+
+    // Points the window's pages, bar the mapper's own, at data
+    void MapWindow(u32 window, Byte* data, bool writable);
+
+    Bus& Target;
+    u32 WindowSize;
+    u32 PagesPerWindow;
+    u32 NumWindows;
+    std::vector<Byte> Rom;
+    std::vector<Byte> Ram;
+    u32 SelectedBank[MAX_WINDOWS] = {};
+};
@@ -0,0 +1,119 @@
+#pragma once
+#include <initializer_list>
+#include <string_view>
+
+#include "cp6502.hpp"
+
+// What can be known about an opcode without running it, for every opcode,
+// built at compile time from CP6502_OPCODES. The block cache, the JIT and
+// CPUBatch decode through it; handlers still count their own cycles.
+namespace cp6502 {
+
+struct OpcodeInfo {
+    std::string_view Name;      // CPU::INS_* suffix, e.g. "LDA_ZPX"; empty without a handler
+    std::string_view Mnemonic;  // e.g. "LDA"
+    AddrMode Mode = AddrMode::Implied;
+    Byte Length = 0;            // opcode plus operand bytes
+    Byte Cycles = 0;            // base cycle count: no page crossed, branch not taken
+    Byte PenaltyCycles = 0;     // most cycles taken beyond Cycles
+    Byte FlagsRead = 0;         // PS bits the instruction depends on
+    Byte FlagsWritten = 0;      // PS bits it may change
+    bool Writes = false;        // may store to memory
+    bool EndsBlock = false;     // branch, jump, call, return or BRK
+
+    constexpr bool Implemented() const {
+        return !Name.empty();
+    }
+};
+
+namespace opcodes_detail {
+
+constexpr bool IsOneOf(std::string_view mnemonic, std::initializer_list<std::string_view> mnemonics) {
+    for (std::string_view candidate : mnemonics)
+        if (mnemonic == candidate)
+            return true;
+    return false;
+}
+
+constexpr Byte FlagsRead(std::string_view m) {
+    if (IsOneOf(m, { "ADC", "SBC" }))
+        return CarryFlag | DecimalFlag;
+    if (IsOneOf(m, { "ROL", "ROR", "BCC", "BCS" }))
+        return CarryFlag;
+    if (IsOneOf(m, { "BEQ", "BNE" }))
+        return ZeroFlag;
+    if (IsOneOf(m, { "BMI", "BPL" }))
+        return NegativeFlag;
+    if (IsOneOf(m, { "BVC", "BVS" }))
+        return OverflowFlag;
+    if (IsOneOf(m, { "PHP", "BRK" }))
+        return 0xFF;
+    return 0;
+}
+
+constexpr Byte FlagsWritten(std::string_view m) {
+    if (IsOneOf(m, { "LDA", "LDX", "LDY", "TAX", "TAY", "TXA", "TYA", "TSX", "PLA",
+                     "AND", "EOR", "ORA", "INC", "INX", "INY", "DEC", "DEX", "DEY" }))
+        return ZeroFlag | NegativeFlag;
+    if (IsOneOf(m, { "ADC", "SBC" }))
+        return CarryFlag | ZeroFlag | OverflowFlag | NegativeFlag;
+    if (IsOneOf(m, { "CMP", "CPX", "CPY", "ASL", "LSR", "ROL", "ROR" }))
+        return CarryFlag | ZeroFlag | NegativeFlag;
+    if (m == "BIT")
+        return ZeroFlag | OverflowFlag | NegativeFlag;
+    if (IsOneOf(m, { "CLC", "SEC" }))
+        return CarryFlag;
+    if (IsOneOf(m, { "CLD", "SED" }))
+        return DecimalFlag;
+    if (IsOneOf(m, { "CLI", "SEI" }))
+        return InterruptFlag;
+    if (m == "CLV")
+        return OverflowFlag;
+    if (m == "BRK")
+        return InterruptFlag | BreakFlag;
+    if (IsOneOf(m, { "PLP", "RTI" }))
+        return 0xFF;
+    return 0;
+}
+
+constexpr bool Writes(std::string_view m, AddrMode mode) {
+    if (IsOneOf(m, { "STA", "STX", "STY", "INC", "DEC", "PHA", "PHP", "JSR", "BRK" }))
+        return true;
+    if (IsOneOf(m, { "ASL", "LSR", "ROL", "ROR" }))
+        return mode != AddrMode::Accumulator;
+    return false;
+}
+
+constexpr bool EndsBlock(std::string_view m, AddrMode mode) {
+    return mode == AddrMode::Relative || IsOneOf(m, { "JSR", "RTS", "JMP", "BRK", "RTI" });
+}
+
+constexpr Byte PenaltyCycles(std::string_view m, AddrMode mode) {
+    // A taken branch costs one more, and one more again into another page
+    if (mode == AddrMode::Relative)
+        return 2;
+    // Indexed reads crossing a page; stores and read-modify-writes always
+    // take the extra cycle, so it is in their base count
+    const bool indexed = mode == AddrMode::AbsoluteX || mode == AddrMode::AbsoluteY || mode == AddrMode::IndirectY;
+    return indexed && !Writes(m, mode) ? 1 : 0;
+}
+
+constexpr std::array<OpcodeInfo, 256> MakeOpcodes() {
+    std::array<OpcodeInfo, 256> table{};
+#define CP6502_OPCODE_INFO(name, mode, baseCycles) \
+    { \
+        constexpr std::string_view m = std::string_view(#name).substr(0, 3); \
+        table[CPU::INS_##name] = { #name, m, AddrMode::mode, InstructionLength(AddrMode::mode), baseCycles, \
+                                   PenaltyCycles(m, AddrMode::mode), FlagsRead(m), FlagsWritten(m), \
+                                   Writes(m, AddrMode::mode), EndsBlock(m, AddrMode::mode) }; \
+    }
+    CP6502_OPCODES(CP6502_OPCODE_INFO)
+#undef CP6502_OPCODE_INFO
+    return table;
+}
+
+} // namespace opcodes_detail
+
+constexpr std::array<OpcodeInfo, 256> Opcodes = opcodes_detail::MakeOpcodes();
+
+} // namespace cp6502
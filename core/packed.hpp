@@ -0,0 +1,157 @@
+#pragma once
+#include "cp6502.hpp"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Bytes packed in a vector register, one per CPUBatch lane, and the byte-wise
+// operations its lockstep kernels are written in. A kernel is a generic
+// lambda over one of Avx2 (32 lanes a register, when built with -mavx2),
+// Sse2 (16, any x86-64) or Scalar (1), and ForEachChunk runs it over every
+// lane with the widest that fits, finishing the lanes left over one at a
+// time. Masks are 0xFF or 0x00 in each byte.
+namespace cp6502::packed {
+
+// What every width builds from the operations it provides
+template <typename V>
+struct Ops {
+    template <typename R>
+    static R Not(R a) {
+        return V::Xor(a, V::Splat(0xFF));
+    }
+
+    // a where mask is set, b elsewhere
+    template <typename R>
+    static R Select(R mask, R a, R b) {
+        return V::Or(V::And(mask, a), V::AndNot(mask, b));
+    }
+
+    template <typename R>
+    static R Flag(R mask, Byte flag) {
+        return V::And(mask, V::Splat(flag));
+    }
+
+    template <typename R>
+    static R ZN(R value) {
+        return V::Or(V::And(value, V::Splat(NegativeFlag)), Flag(V::Equal(value, V::Splat(0)), ZeroFlag));
+    }
+
+    // Mask of the bytes where a + b does not fit in a byte: b > ~a
+    template <typename R>
+    static R Carries(R a, R b) {
+        return Not(V::AtLeast(Not(a), b));
+    }
+
+    // As AddArithmetic: a + operand + carry (0 or 1 in each byte), and its
+    // C/Z/V/N in flags
+    template <typename R>
+    static R AddWithCarry(R a, R operand, R carry, R& flags) {
+        const R partial = V::Add(a, operand);
+        const R result = V::Add(partial, carry);
+        const R carryOut = V::Or(Carries(a, operand), Carries(partial, carry));
+        // overflow: bit 7 of (a ^ result) & (operand ^ result), moved to bit 6
+        const R overflow = V::And(V::HalfRight(V::And(V::Xor(a, result), V::Xor(operand, result))),
+                                  V::Splat(OverflowFlag));
+        flags = V::Or(V::Or(ZN(result), overflow), Flag(carryOut, CarryFlag));
+        return result;
+    }
+
+    // As CompareArithmetic: C/Z/N of reg - operand
+    template <typename R>
+    static R CompareFlags(R reg, R operand) {
+        return V::Or(V::Or(V::And(V::Sub(reg, operand), V::Splat(NegativeFlag)),
+                           Flag(V::Equal(reg, operand), ZeroFlag)),
+                     Flag(V::AtLeast(reg, operand), CarryFlag));
+    }
+};
+
+struct Scalar : Ops<Scalar> {
+    using Reg = Byte;
+    static constexpr u32 WIDTH = 1;
+
+    static Reg Load(Byte const* bytes) { return *bytes; }
+    static void Store(Byte* bytes, Reg a) { *bytes = a; }
+    static Reg Splat(Byte b) { return b; }
+    static Reg And(Reg a, Reg b) { return a & b; }
+    static Reg Or(Reg a, Reg b) { return a | b; }
+    static Reg Xor(Reg a, Reg b) { return a ^ b; }
+    static Reg AndNot(Reg a, Reg b) { return ~a & b; }
+    static Reg Add(Reg a, Reg b) { return a + b; }
+    static Reg Sub(Reg a, Reg b) { return a - b; }
+    static Reg Equal(Reg a, Reg b) { return a == b ? 0xFF : 0x00; }
+    static Reg AtLeast(Reg a, Reg b) { return a >= b ? 0xFF : 0x00; }
+    static Reg Negative(Reg a) { return (a & 0x80) ? 0xFF : 0x00; }
+    static Reg HalfRight(Reg a) { return a >> 1; }
+};
+
+#if defined(__SSE2__)
+struct Sse2 : Ops<Sse2> {
+    using Reg = __m128i;
+    static constexpr u32 WIDTH = 16;
+
+    static Reg Load(Byte const* bytes) { return _mm_loadu_si128(reinterpret_cast<__m128i const*>(bytes)); }
+    static void Store(Byte* bytes, Reg a) { _mm_storeu_si128(reinterpret_cast<__m128i*>(bytes), a); }
+    static Reg Splat(Byte b) { return _mm_set1_epi8(static_cast<char>(b)); }
+    static Reg And(Reg a, Reg b) { return _mm_and_si128(a, b); }
+    static Reg Or(Reg a, Reg b) { return _mm_or_si128(a, b); }
+    static Reg Xor(Reg a, Reg b) { return _mm_xor_si128(a, b); }
+    static Reg AndNot(Reg a, Reg b) { return _mm_andnot_si128(a, b); }
+    static Reg Add(Reg a, Reg b) { return _mm_add_epi8(a, b); }
+    static Reg Sub(Reg a, Reg b) { return _mm_sub_epi8(a, b); }
+    static Reg Equal(Reg a, Reg b) { return _mm_cmpeq_epi8(a, b); }
+    static Reg AtLeast(Reg a, Reg b) { return _mm_cmpeq_epi8(_mm_max_epu8(a, b), a); }
+    static Reg Negative(Reg a) { return _mm_cmpgt_epi8(_mm_setzero_si128(), a); }
+    // No byte shifts: shift the words and drop the bit each byte took from its neighbour
+    static Reg HalfRight(Reg a) { return _mm_and_si128(_mm_srli_epi16(a, 1), _mm_set1_epi8(0x7F)); }
+};
+#endif
+
+#if defined(__AVX2__)
+struct Avx2 : Ops<Avx2> {
+    using Reg = __m256i;
+    static constexpr u32 WIDTH = 32;
+
+    static Reg Load(Byte const* bytes) { return _mm256_loadu_si256(reinterpret_cast<__m256i const*>(bytes)); }
+    static void Store(Byte* bytes, Reg a) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(bytes), a); }
+    static Reg Splat(Byte b) { return _mm256_set1_epi8(static_cast<char>(b)); }
+    static Reg And(Reg a, Reg b) { return _mm256_and_si256(a, b); }
+    static Reg Or(Reg a, Reg b) { return _mm256_or_si256(a, b); }
+    static Reg Xor(Reg a, Reg b) { return _mm256_xor_si256(a, b); }
+    static Reg AndNot(Reg a, Reg b) { return _mm256_andnot_si256(a, b); }
+    static Reg Add(Reg a, Reg b) { return _mm256_add_epi8(a, b); }
+    static Reg Sub(Reg a, Reg b) { return _mm256_sub_epi8(a, b); }
+    static Reg Equal(Reg a, Reg b) { return _mm256_cmpeq_epi8(a, b); }
+    static Reg AtLeast(Reg a, Reg b) { return _mm256_cmpeq_epi8(_mm256_max_epu8(a, b), a); }
+    static Reg Negative(Reg a) { return _mm256_cmpgt_epi8(_mm256_setzero_si256(), a); }
+    static Reg HalfRight(Reg a) { return _mm256_and_si256(_mm256_srli_epi16(a, 1), _mm256_set1_epi8(0x7F)); }
+};
+#endif
+
+// The widest Reg built for
+#if defined(__AVX2__)
+using Widest = Avx2;
+#elif defined(__SSE2__)
+using Widest = Sse2;
+#else
+using Widest = Scalar;
+#endif
+
+// Calls kernel(V{}, i) for the lanes i to i + V::WIDTH - 1, covering lanes
+// 0 to N - 1
+template <u32 N, typename Kernel>
+void ForEachChunk(Kernel&& kernel) {
+    u32 i = 0;
+#if defined(__AVX2__)
+    for (; i + Avx2::WIDTH <= N; i += Avx2::WIDTH)
+        kernel(Avx2{}, i);
+#endif
+#if defined(__SSE2__)
+    for (; i + Sse2::WIDTH <= N; i += Sse2::WIDTH)
+        kernel(Sse2{}, i);
+#endif
+    for (; i < N; ++i)
+        kernel(Scalar{}, i);
+}
+
+} // namespace cp6502::packed
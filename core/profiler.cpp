@@ -0,0 +1,124 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <string>
+
+#include "symbols.hpp"
+
+namespace cp6502 {
+
+namespace {
+
+double Percent(u64 part, u64 whole) {
+    return whole ? 100.0 * part / whole : 0.0;
+}
+
+// "$0300", or its label given symbols, or "top-level" for Profiler::TopLevel
+std::string Name(u32 address, Symbols const* symbols) {
+    if (address == Profiler::TopLevel)
+        return "top-level";
+    if (symbols)
+        return symbols->Format(Word(address));
+    char text[8];
+    snprintf(text, sizeof(text), "$%04X", address);
+    return text;
+}
+
+} // namespace
+
+Profiler::Profiler() : Instructions(0x10000, 0), Cycles(0x10000, 0), Active(0x10000, 0) {
+}
+
+u64 Profiler::TotalInstructions() const {
+    u64 total = 0;
+    for (u64 count : Instructions)
+        total += count;
+    return total;
+}
+
+std::vector<Profiler::Function> Profiler::Functions() const {
+    std::vector<Function> functions;
+    functions.push_back(Outside);
+    functions.back().Inclusive = TotalCycles;
+    for (auto const& [address, function] : Entries) {
+        Function running = function;
+        // Calls still running, counted once however deep they recurse
+        for (Frame const& frame : Frames) {
+            if (frame.Callee == &function) {
+                running.Inclusive += TotalCycles - frame.Start;
+                break;
+            }
+        }
+        functions.push_back(running);
+    }
+    std::sort(functions.begin(), functions.end(), [](Function const& a, Function const& b) {
+        return a.Inclusive != b.Inclusive ? a.Inclusive > b.Inclusive : a.Address < b.Address;
+    });
+    return functions;
+}
+
+std::vector<Profiler::Call> Profiler::Calls() const {
+    std::vector<Call> calls;
+    for (auto const& [pair, edge] : Edges) {
+        Call call{ pair.first, pair.second, edge.Calls, edge.Inclusive };
+        for (Frame const& frame : Frames) {
+            if (frame.Via == &edge) {
+                call.Inclusive += TotalCycles - frame.Start;
+                break;
+            }
+        }
+        calls.push_back(call);
+    }
+    std::sort(calls.begin(), calls.end(), [](Call const& a, Call const& b) {
+        return a.Inclusive > b.Inclusive;
+    });
+    return calls;
+}
+
+void Profiler::WriteFlat(FILE* out, u32 top, Symbols const* symbols) const {
+    std::vector<u32> pcs;
+    for (u32 pc = 0; pc < 0x10000; ++pc)
+        if (Instructions[pc])
+            pcs.push_back(pc);
+    const size_t count = std::min<size_t>(top, pcs.size());
+    std::partial_sort(pcs.begin(), pcs.begin() + count, pcs.end(), [this](u32 a, u32 b) {
+        return Cycles[a] != Cycles[b] ? Cycles[a] > Cycles[b] : a < b;
+    });
+    fprintf(out, "%-9s %14s %14s %7s\n", "pc", "instructions", "cycles", "%");
+    for (size_t i = 0; i < count; ++i) {
+        const u32 pc = pcs[i];
+        fprintf(out, "%-9s %14llu %14llu %7.2f\n", Name(pc, symbols).c_str(), Instructions[pc], Cycles[pc],
+                Percent(Cycles[pc], TotalCycles));
+    }
+}
+
+void Profiler::WriteCallGraph(FILE* out, Symbols const* symbols) const {
+    const std::vector<Call> calls = Calls();
+    fprintf(out, "%-12s %10s %14s %7s %14s %7s\n", "function", "calls", "inclusive", "%", "exclusive", "%");
+    for (Function const& function : Functions()) {
+        fprintf(out, "%-12s %10llu %14llu %7.2f %14llu %7.2f\n", Name(function.Address, symbols).c_str(),
+                function.Calls, function.Inclusive, Percent(function.Inclusive, TotalCycles), function.Exclusive,
+                Percent(function.Exclusive, TotalCycles));
+        for (Call const& call : calls) {
+            if (call.Caller == function.Address)
+                fprintf(out, "  -> %-7s %10llu %14llu %7.2f\n", Name(call.Callee, symbols).c_str(), call.Calls,
+                        call.Inclusive, Percent(call.Inclusive, TotalCycles));
+        }
+    }
+}
+
+void Profiler::Clear() {
+    std::fill(Instructions.begin(), Instructions.end(), 0);
+    std::fill(Cycles.begin(), Cycles.end(), 0);
+    std::fill(Active.begin(), Active.end(), 0);
+    TotalCycles = 0;
+    Last = 0;
+    Outside = {};
+    Entries.clear();
+    Edges.clear();
+    Frames.clear();
+    Current = &Outside;
+    Pending = PendingOp::None;
+}
+
+} // namespace cp6502
@@ -0,0 +1,195 @@
+#pragma once
+#include <stdio.h>
+
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "cp6502.hpp"
+
+// Where the cycles go, kept by CPU::Execute(cycles, memory, profiler): for
+// every PC the instructions run there and the cycles they took, and for
+// every subroutine entered by JSR its calls and the cycles spent in it,
+// itself (exclusive) or with everything it called (inclusive), plus the
+// same for each caller-callee pair.
+//
+// Like a trace, the profiler is a policy of the interpreter loop, so it
+// costs nothing unless Execute is given one. An instruction's cycles are
+// those Execute used from its start to the next instruction's, so they
+// include page-cross and branch penalties, and the trips of an idle loop
+// charged in bulk go to the jump that closed the loop.
+//
+// A subroutine returns at the RTS that brings the stack back to where it
+// was at its JSR, or above: code that drops a return address and returns
+// to its caller's caller ends both calls there. A JSR leaves the caller
+// once it has run, and an RTS leaves the callee once it has, so each
+// counts to the side that executes it. Code run outside any call counts to
+// TopLevel.
+struct cp6502::Profiler {
+    static constexpr u32 TopLevel = 0x10000;
+
+    struct Function {
+        u32 Address = TopLevel;     // the JSR target, or TopLevel
+        u64 Calls = 0;
+        u64 Inclusive = 0;          // of the outermost calls, if it recurses
+        u64 Exclusive = 0;
+    };
+
+    struct Call {
+        u32 Caller = TopLevel;
+        u32 Callee = TopLevel;
+        u64 Calls = 0;
+        u64 Inclusive = 0;          // of the outermost calls, if it recurses
+    };
+
+    Profiler();
+
+    Profiler(Profiler const&) = delete;
+    Profiler& operator=(Profiler const&) = delete;
+
+    // The trace policy Execute runs with: holds the per-instruction state
+    // as locals of Execute, and leaves calls and returns to the Profiler
+    struct Recorder {
+        explicit Recorder(Profiler& profiler)
+            : Owner(profiler), Instructions(profiler.Instructions.data()), Cycles(profiler.Cycles.data()),
+              Base(profiler.TotalCycles), Last(profiler.Last), Current(profiler.Current) {
+        }
+
+        template <typename CPUT, typename BusT>
+        void Record(CPUT const& cpu, BusT const& memory, Byte opcode, s32 cyclesUsed) {
+            Charge(Base + cyclesUsed);
+            if (Owner.Pending != PendingOp::None)
+                Current = Owner.Settle(Current, cpu.SP, Base + cyclesUsed);
+            const Word pc = cpu.PC - 1;
+            ++Instructions[pc];
+            Last = pc;
+            if (opcode == CPUT::INS_JSR) {
+                Owner.Pending = PendingOp::Call;
+                Owner.Target = memory.Read(cpu.PC) | (memory.Read(Word(cpu.PC + 1)) << 8);
+                Owner.Stack = cpu.SP;
+            } else if (opcode == CPUT::INS_RTS) {
+                Owner.Pending = PendingOp::Return;
+            }
+        }
+
+        // Called by Execute as it returns
+        void Advance(s32 cyclesUsed) {
+            Charge(Base + cyclesUsed);
+            Owner.TotalCycles = Base + cyclesUsed;
+            Owner.Last = Last;
+            Owner.Current = Current;
+        }
+
+    private:
+        // Charges the cycles since the last instruction started to it
+        void Charge(u64 now) {
+            const u64 spent = now - Charged;
+            Cycles[Last] += spent;
+            Current->Exclusive += spent;
+            Charged = now;
+        }
+
+        Profiler& Owner;
+        u64* Instructions;
+        u64* Cycles;
+        u64 Base;
+        u64 Charged = Base;
+        Word Last;
+        Function* Current;
+    };
+
+    u64 InstructionsAt(Word pc) const {
+        return Instructions[pc];
+    }
+
+    u64 CyclesAt(Word pc) const {
+        return Cycles[pc];
+    }
+
+    u64 TotalInstructions() const;
+
+    u64 CyclesUsed() const {
+        return TotalCycles;
+    }
+
+    // Every function run, by inclusive cycles, most first. Calls still
+    // running count up to the last Execute.
+    std::vector<Function> Functions() const;
+
+    // Every caller-callee pair, by inclusive cycles, most first
+    std::vector<Call> Calls() const;
+
+    // Writes the top PCs by cycles, one a line: PC, instructions, cycles
+    // and percentage of all cycles. Given symbols, PCs and functions read
+    // as labels (see Symbols::Format), in both.
+    void WriteFlat(FILE* out, u32 top = 20, Symbols const* symbols = nullptr) const;
+
+    // Writes each function by inclusive cycles with its calls, cycles and
+    // percentages, followed by the functions it called
+    void WriteCallGraph(FILE* out, Symbols const* symbols = nullptr) const;
+
+    // Forgets everything recorded. Only while no Execute is recording.
+    void Clear();
+
+private:
+    enum class PendingOp : Byte { None, Call, Return };
+
+    struct Edge {
+        u64 Calls = 0;
+        u64 Inclusive = 0;
+        u32 Active = 0;
+    };
+
+    struct Frame {
+        Function* Callee;
+        Edge* Via;
+        Byte Stack;     // SP before the JSR, and again after the RTS
+        u64 Start;      // cycle the callee started at
+    };
+
+    // Enters or leaves the call the last instruction, run in current, made
+    // or ended, now that it has run; returns the function now running
+    Function* Settle(Function* current, Byte sp, u64 now) {
+        if (Pending == PendingOp::Call) {
+            Function& callee = Entries[Target];
+            callee.Address = Target;
+            ++callee.Calls;
+            Edge& edge = Edges[{ current->Address, Target }];
+            ++edge.Calls;
+            ++Active[Target];
+            ++edge.Active;
+            Frames.push_back({ &callee, &edge, Stack, now });
+            current = &callee;
+        } else {
+            // The stack grows down, so calls made further in have lower Stack
+            while (!Frames.empty() && Frames.back().Stack <= sp) {
+                Frame const& frame = Frames.back();
+                if (--Active[frame.Callee->Address] == 0)
+                    frame.Callee->Inclusive += now - frame.Start;
+                if (--frame.Via->Active == 0)
+                    frame.Via->Inclusive += now - frame.Start;
+                Frames.pop_back();
+            }
+            current = Frames.empty() ? &Outside : Frames.back().Callee;
+        }
+        Pending = PendingOp::None;
+        return current;
+    }
+
+    std::vector<u64> Instructions;
+    std::vector<u64> Cycles;
+    u64 TotalCycles = 0;
+    Word Last = 0;
+
+    Function Outside;
+    std::unordered_map<u32, Function> Entries;
+    std::map<std::pair<u32, u32>, Edge> Edges;
+    std::vector<u32> Active;    // calls running, per function
+    std::vector<Frame> Frames;
+    Function* Current = &Outside;    // as of the last Execute
+
+    PendingOp Pending = PendingOp::None;
+    Word Target = 0;            // of the JSR pending
+    Byte Stack = 0;             // SP before the JSR pending
+};
@@ -0,0 +1,97 @@
+#include "scheduler.hpp"
+#include "bus.hpp"
+
+#include <algorithm>
+
+namespace cp6502 {
+
+u32 Scheduler::At(u64 due, Event event) {
+    const u32 id = NextId++;
+    Push({ due, 0, 0, id, std::move(event) });
+    return id;
+}
+
+u32 Scheduler::Every(u64 period, Event event) {
+    const u32 id = NextId++;
+    Push({ Now + period, period, 0, id, std::move(event) });
+    return id;
+}
+
+bool Scheduler::Cancel(u32 id) {
+    if (id != 0 && id == Firing) {
+        const bool wasPending = !FiringCancelled;
+        FiringCancelled = true;
+        return wasPending;
+    }
+    auto it = std::find_if(Events.begin(), Events.end(), [id](Entry const& entry) { return entry.Id == id; });
+    if (it == Events.end())
+        return false;
+    // Few devices, so a linear search and rebuild is cheaper than an index
+    Events.erase(it);
+    std::make_heap(Events.begin(), Events.end());
+    return true;
+}
+
+void Scheduler::Push(Entry entry) {
+    entry.Order = NextOrder++;
+    Events.push_back(std::move(entry));
+    std::push_heap(Events.begin(), Events.end());
+}
+
+void Scheduler::RunDue() {
+    while (!Events.empty() && Events.front().Due <= Now) {
+        std::pop_heap(Events.begin(), Events.end());
+        Entry entry = std::move(Events.back());
+        Events.pop_back();
+
+        Firing = entry.Id;
+        FiringCancelled = false;
+        entry.Callback(entry.Due);
+        Firing = 0;
+
+        if (entry.Period && !FiringCancelled) {
+            entry.Due += entry.Period;
+            Push(std::move(entry));
+        }
+    }
+}
+
+template <typename BusT, Timing T>
+template <Dispatch D>
+ExecuteResult BasicCPU<BusT, T>::Execute(s32 cycles, BusT& memory, Scheduler& scheduler) {
+    const s32 cyclesRequested = cycles;
+    StopReason reason = StopReason::Budget;
+    while (cycles > 0 && reason == StopReason::Budget) {
+        scheduler.RunDue();
+        s32 budget = cycles;
+        if (!TakeInterrupt(budget, memory)) {
+            // An IRQ held while I is set is taken as soon as an instruction clears I
+            const u64 slice = (IRQ && I) ? 1 : std::min<u64>(cycles, scheduler.UntilNext());
+            const ExecuteResult ran = Execute<D>(slice, memory);
+            budget -= ran.Cycles;
+            reason = ran.Reason;
+        }
+        scheduler.Now += cycles - budget;
+        cycles = budget;
+    }
+    return { cyclesRequested - cycles, reason, PC };
+}
+
+#define CP6502_INSTANTIATE(BusT, T) \
+    template ExecuteResult BasicCPU<BusT, T>::Execute<Dispatch::Switch>(s32 cycles, BusT& memory, Scheduler& scheduler); \
+    template ExecuteResult BasicCPU<BusT, T>::Execute<Dispatch::Table>(s32 cycles, BusT& memory, Scheduler& scheduler); \
+    CP6502_INSTANTIATE_THREADED(BusT, T)
+#if CP6502_HAS_COMPUTED_GOTO
+#define CP6502_INSTANTIATE_THREADED(BusT, T) \
+    template ExecuteResult BasicCPU<BusT, T>::Execute<Dispatch::Threaded>(s32 cycles, BusT& memory, Scheduler& scheduler);
+#else
+#define CP6502_INSTANTIATE_THREADED(BusT, T)
+#endif
+CP6502_INSTANTIATE(Mem, Timing::PerAccess)
+CP6502_INSTANTIATE(Mem, Timing::PerInstruction)
+CP6502_INSTANTIATE(Bus, Timing::PerAccess)
+CP6502_INSTANTIATE(Bus, Timing::PerInstruction)
+#undef CP6502_INSTANTIATE_THREADED
+#undef CP6502_INSTANTIATE
+
+} // namespace cp6502
@@ -0,0 +1,68 @@
+#pragma once
+#include <functional>
+#include <vector>
+
+#include "cp6502.hpp"
+
+// Device events keyed on the CPU's cycle count, for timers, serial ports and
+// anything else that raises IRQ or NMI at a known time.
+//
+// CPU::Execute(cycles, memory, scheduler) runs the plain interpreter loop up
+// to the next event, so nothing is checked per instruction: events fire and
+// interrupts are taken only between those slices. An event fires at the
+// first instruction boundary at or after the cycle it was due, so at most an
+// instruction late. The one exception is an IRQ held while I is set, which
+// steps an instruction at a time until I clears or the IRQ is released.
+//
+// Lines changed by the host, or by a bus handler part way through a slice,
+// are seen at the next slice.
+struct cp6502::Scheduler {
+    // Called with the cycle the event was due; may add and cancel events
+    using Event = std::function<void(u64 due)>;
+
+    u64 Now = 0;    // cycles run through Execute(cycles, memory, scheduler)
+
+    // Returns an id for Cancel, never 0
+    u32 At(u64 due, Event event);
+    u32 After(u64 delay, Event event) {
+        return At(Now + delay, std::move(event));
+    }
+    // Fires every period cycles, the first period cycles from now, until cancelled
+    u32 Every(u64 period, Event event);
+    // False if id has already fired, or was cancelled
+    bool Cancel(u32 id);
+
+    // Fires, in order of due cycle then of adding, every event due by Now
+    void RunDue();
+
+    // Cycles from Now to the next event, or to UINT64_MAX if there is none
+    u64 UntilNext() const {
+        return Events.empty() ? ~0ull - Now : Events.front().Due - Now;
+    }
+
+    u32 Pending() const {
+        return Events.size();
+    }
+
+private:
+    struct Entry {
+        u64 Due;
+        u64 Period;     // 0 for a one-off
+        u64 Order;      // ties on Due go to the one added first
+        u32 Id;
+        Event Callback;
+
+        // Orders the heap earliest first
+        bool operator<(Entry const& other) const {
+            return Due != other.Due ? Due > other.Due : Order > other.Order;
+        }
+    };
+
+    void Push(Entry entry);
+
+    std::vector<Entry> Events;  // binary min-heap on (Due, Order)
+    u64 NextOrder = 0;
+    u32 NextId = 1;
+    u32 Firing = 0;             // id of the event being called back
+    bool FiringCancelled = false;
+};
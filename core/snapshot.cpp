@@ -0,0 +1,78 @@
+#include "snapshot.hpp"
+
+#include <string.h>
+
+namespace cp6502 {
+
+namespace {
+
+std::shared_ptr<Snapshot::Page const> CopyPage(Mem const& memory, u32 page) {
+    auto copy = std::make_shared<Snapshot::Page>();
+    memcpy(copy->data(), &memory.Data[page * Mem::PAGE_SIZE], Mem::PAGE_SIZE);
+    return copy;
+}
+
+} // namespace
+
+void Snapshotter::Track(Mem const& memory) {
+    if (Memory == &memory)
+        return;
+    Memory = &memory;
+    Pages.reset();
+    Dirty.emplace(memory);
+}
+
+Snapshot Snapshotter::Take(CPU const& cpu, Mem const& memory) {
+    Track(memory);
+    if (!Pages) {
+        auto table = std::make_shared<Snapshot::PageTable>();
+        for (u32 page = 0; page < Mem::NUM_PAGES; ++page)
+            (*table)[page] = CopyPage(memory, page);
+        PagesCopied += Mem::NUM_PAGES;
+        Pages = std::move(table);
+    } else {
+        // Copy on write: a new table only if a page has been written since
+        std::shared_ptr<Snapshot::PageTable> table;
+        Dirty->ForEachDirtyRange([&](u32 address, u32 size) {
+            if (!table)
+                table = std::make_shared<Snapshot::PageTable>(*Pages);
+            for (u32 page = address / Mem::PAGE_SIZE; page < (address + size) / Mem::PAGE_SIZE; ++page) {
+                (*table)[page] = CopyPage(memory, page);
+                ++PagesCopied;
+            }
+        });
+        if (table)
+            Pages = std::move(table);
+    }
+    Dirty->Clear();
+    return Snapshot{ cpu, Pages };
+}
+
+void Snapshotter::RestorePage(Snapshot::PageTable const& pages, u32 page, Mem& memory) {
+    memcpy(&memory.Data[page * Mem::PAGE_SIZE], pages[page]->data(), Mem::PAGE_SIZE);
+    // Decoded or translated code from this page is stale now
+    ++memory.WriteGeneration[page];
+    ++PagesCopied;
+}
+
+void Snapshotter::Restore(Snapshot const& snapshot, CPU& cpu, Mem& memory) {
+    Track(memory);
+    Snapshot::PageTable const& target = *snapshot.Pages;
+    if (Pages == snapshot.Pages) {
+        // Only what has been written since differs
+        Dirty->ForEachDirtyRange([&](u32 address, u32 size) {
+            for (u32 page = address / Mem::PAGE_SIZE; page < (address + size) / Mem::PAGE_SIZE; ++page)
+                RestorePage(target, page, memory);
+        });
+    } else {
+        for (u32 page = 0; page < Mem::NUM_PAGES; ++page) {
+            if (!Pages || Dirty->IsDirty(page) || (*Pages)[page] != target[page])
+                RestorePage(target, page, memory);
+        }
+    }
+    Pages = snapshot.Pages;
+    Dirty->Clear();
+    cpu = snapshot.Cpu;
+}
+
+} // namespace cp6502
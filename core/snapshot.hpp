@@ -0,0 +1,45 @@
+#pragma once
+#include <array>
+#include <memory>
+#include <optional>
+
+#include "cp6502.hpp"
+#include "dirtypages.hpp"
+
+// CPU and memory state that can be restored any number of times. A snapshot
+// holds one immutable table of 256-byte pages, and snapshots share both the
+// table and the pages they have in common: a snapshot taken with no page
+// written since the last take or restore shares the table outright, and
+// otherwise gets a copy of it with only the written pages replaced.
+struct cp6502::Snapshot {
+    using Page = std::array<Byte, Mem::PAGE_SIZE>;
+    using PageTable = std::array<std::shared_ptr<Page const>, Mem::NUM_PAGES>;
+
+    CPU Cpu;
+    std::shared_ptr<PageTable const> Pages;
+};
+
+// Takes and restores snapshots of one Mem, keeping the page table its
+// memory matches outside the pages DirtyPages has seen written. Taking a
+// snapshot copies only those pages, and a restore only those and the pages
+// where the two tables differ.
+struct cp6502::Snapshotter {
+    Snapshot Take(CPU const& cpu, Mem const& memory);
+    void Restore(Snapshot const& snapshot, CPU& cpu, Mem& memory);
+
+    bool IsCurrent(u32 page, Mem const& memory) const {
+        return Memory == &memory && Pages && !Dirty->IsDirty(page);
+    }
+
+    u32 PagesCopied = 0;    // pages copied by Take and Restore since construction
+
+    // The table Memory held when Dirty was last cleared, or null before the
+    // first Take or Restore of it
+    std::shared_ptr<Snapshot::PageTable const> Pages;
+    std::optional<DirtyPages> Dirty;
+    Mem const* Memory = nullptr;
+
+private:
+    void Track(Mem const& memory);
+    void RestorePage(Snapshot::PageTable const& pages, u32 page, Mem& memory);
+};
@@ -0,0 +1,145 @@
+#include "symbols.hpp"
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace cp6502 {
+
+namespace {
+
+// Where the label column starts in an AS65 listing: after "0400 : " and
+// the bytes the line assembled to
+constexpr size_t LabelColumn = 24;
+
+int HexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool StartsLabel(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == '.' || c == '@';
+}
+
+bool InLabel(char c) {
+    return StartsLabel(c) || (c >= '0' && c <= '9');
+}
+
+} // namespace
+
+Symbols::Symbols() : Index(0x10000, None) {
+}
+
+bool Symbols::LoadListing(char const* path) {
+#if defined(__unix__) || defined(__APPLE__)
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return false;
+    }
+    if (info.st_size > 0) {
+        void* text = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (text == MAP_FAILED) {
+            close(fd);
+            return false;
+        }
+        AddListing(std::string_view(static_cast<char const*>(text), info.st_size));
+        munmap(text, info.st_size);
+    }
+    close(fd);
+    return true;
+#else
+    FILE* file = fopen(path, "rb");
+    if (!file)
+        return false;
+    std::string text;
+    char buffer[64 * 1024];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        text.append(buffer, read);
+    fclose(file);
+    AddListing(text);
+    return true;
+#endif
+}
+
+void Symbols::AddListing(std::string_view text) {
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find('\n', start);
+        if (end == std::string_view::npos)
+            end = text.size();
+        const std::string_view line = text.substr(start, end - start);
+        start = end + 1;
+
+        // "0400 : d8               start   cld"
+        if (line.size() <= LabelColumn || line[4] != ' ' || line[5] != ':' || !StartsLabel(line[LabelColumn]))
+            continue;
+        u32 address = 0;
+        bool isAddress = true;
+        for (size_t i = 0; i < 4; ++i) {
+            const int digit = HexDigit(line[i]);
+            isAddress &= digit >= 0;
+            address = address << 4 | (digit & 0xF);
+        }
+        if (!isAddress)
+            continue;
+        size_t length = 1;
+        while (LabelColumn + length < line.size() && InLabel(line[LabelColumn + length]))
+            ++length;
+        Entries.push_back({ u32(Names.size()), u32(length), Word(address) });
+        Names.append(line.substr(LabelColumn, length));
+    }
+    Reindex();
+}
+
+void Symbols::Add(std::string_view name, Word address) {
+    const u32 index = u32(Entries.size());
+    Entries.push_back({ u32(Names.size()), u32(name.size()), address });
+    Names.append(name);
+    // Takes over the addresses up to the next label
+    u32 covered = address;
+    do {
+        Index[covered++] = index;
+    } while (covered < 0x10000 && (Index[covered] == None || Entries[Index[covered]].Address != covered));
+}
+
+void Symbols::Reindex() {
+    std::vector<u32> at(0x10000, None);
+    for (u32 index = 0; index < Entries.size(); ++index)
+        at[Entries[index].Address] = index;
+    u32 nearest = None;
+    for (u32 address = 0; address < 0x10000; ++address) {
+        if (at[address] != None)
+            nearest = at[address];
+        Index[address] = nearest;
+    }
+}
+
+std::string Symbols::Format(Word address) const {
+    char text[16];
+    const Symbol symbol = Find(address);
+    if (symbol.Name.empty()) {
+        snprintf(text, sizeof(text), "$%04X", address);
+        return text;
+    }
+    std::string formatted(symbol.Name);
+    if (address != symbol.Address) {
+        snprintf(text, sizeof(text), "+%u", address - symbol.Address);
+        formatted += text;
+    }
+    return formatted;
+}
+
+} // namespace cp6502
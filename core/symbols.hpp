@@ -0,0 +1,70 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "cp6502.hpp"
+
+// Labels and their addresses, read from an AS65 listing such as
+// stest/6502_functional_test.lst, so that the profiler, traces and the
+// disassembler can show "label+offset" instead of a bare address.
+//
+// A label is the name in the label column of a listing line that starts
+// with an address and ':'; equates ('=' lines) are values, not places, and
+// are left out. Where several labels share an address the last wins, as it
+// is the one nearest the code or data that follows.
+//
+// The listing is mapped rather than read and parsed in one pass, and every
+// address keeps the index of the nearest label at or below it, so Find is a
+// single array lookup.
+struct cp6502::Symbols {
+    struct Symbol {
+        std::string_view Name;      // empty if no label is at or below the address
+        Word Address = 0;
+    };
+
+    Symbols();
+
+    // Adds the labels in the listing at path to any already loaded; returns
+    // false if it cannot be read
+    bool LoadListing(char const* path);
+
+    // Adds the labels in a listing already in memory
+    void AddListing(std::string_view text);
+
+    void Add(std::string_view name, Word address);
+
+    // The nearest label at or below address
+    Symbol Find(Word address) const {
+        const u32 index = Index[address];
+        if (index == None)
+            return {};
+        return { Name(index), Entries[index].Address };
+    }
+
+    // "label", "label+3", or "$1234" with no label at or below it
+    std::string Format(Word address) const;
+
+    u32 Count() const {
+        return u32(Entries.size());
+    }
+
+private:
+    static constexpr u32 None = ~0u;
+
+    struct Entry {
+        u32 Offset;     // of the name in Names
+        u32 Length;
+        Word Address;
+    };
+
+    std::string_view Name(u32 index) const {
+        return std::string_view(Names).substr(Entries[index].Offset, Entries[index].Length);
+    }
+
+    void Reindex();
+
+    std::string Names;              // every name, end to end
+    std::vector<Entry> Entries;
+    std::vector<u32> Index;         // per address, into Entries
+};
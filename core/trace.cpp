@@ -0,0 +1,50 @@
+#include "trace.hpp"
+
+#include <algorithm>
+
+#include "disassembler.hpp"
+
+namespace cp6502 {
+
+TraceRing::TraceRing(u32 capacityLog2)
+    : Entries(size_t(1) << capacityLog2), Mask((u64(1) << capacityLog2) - 1),
+      PublishEvery(std::max<u64>(1, std::min<u64>(MaxPublishEvery, (Mask + 1) / 4))),
+      Next(Entries.data()), PublishAt(Entries.data() + PublishEvery), Published(Entries.data()) {
+}
+
+std::vector<TraceEntry> TraceRing::Last(u32 n) const {
+    const u64 head = Head.load(std::memory_order_acquire);
+    const u64 count = std::min<u64>({ n, head, Capacity() });
+    std::vector<TraceEntry> entries(count);
+    for (u64 i = 0; i < count; ++i)
+        entries[i] = Entries[(head - count + i) & Mask].Entry();
+    // The writer may have lapped the oldest entries while they were copied,
+    // and be part way through the PublishEvery entries after the last it
+    // published
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const u64 written = Head.load(std::memory_order_relaxed) - head;
+    const u64 overwritten = std::min(count, written + count > Capacity() ? written + count - Capacity() : 0);
+    entries.erase(entries.begin(), entries.begin() + overwritten);
+    return entries;
+}
+
+size_t TraceRing::Write(FILE* out) const {
+    const std::vector<TraceEntry> entries = Last(Capacity());
+    return fwrite(entries.data(), sizeof(TraceEntry), entries.size(), out);
+}
+
+size_t TraceRing::WriteText(FILE* out, Symbols const* symbols) const {
+    const std::vector<TraceEntry> entries = Last(Capacity());
+    for (TraceEntry const& entry : entries)
+        fprintf(out, "%s\n", FormatTrace(entry, symbols).c_str());
+    return entries.size();
+}
+
+void TraceRing::Clear() {
+    Head.store(0, std::memory_order_release);
+    Cycles = 0;
+    Next = Published = Entries.data();
+    PublishAt = Entries.data() + PublishEvery;
+}
+
+} // namespace cp6502
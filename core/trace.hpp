@@ -0,0 +1,217 @@
+#pragma once
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <array>
+#include <atomic>
+#include <type_traits>
+#include <vector>
+
+#include "cp6502.hpp"
+#include "opcodes.hpp"
+
+// A record of the last instructions run, for post-mortems, kept by
+// CPU::Execute(cycles, memory, trace). Execute takes its trace as a policy:
+// the plain Execute(cycles, memory) runs with NoTrace, whose Record is empty,
+// so untraced runs compile to the same loop as before.
+//
+// Each instruction is one raw 16-byte TraceSlot, written into a ring of a
+// power-of-two size as its opcode is fetched, and read back as a TraceEntry.
+// The ring has a single writer, the thread running Execute, and takes no
+// lock: a reader on another thread gets, from Last, only entries the writer
+// has published and cannot have overwritten while they were copied. The
+// trips of an idle loop charged in bulk (see CPU::Idle) are not recorded.
+namespace cp6502 {
+
+struct TraceEntry {
+    u32 Cycle;          // cycles run through the trace before this instruction, mod 2^32
+    Word PC;
+    Byte Opcode;
+    Byte Operand[2];    // the bytes after the opcode it takes, the rest zero
+    Byte A, X, Y, SP;
+    Byte PS;            // with C/Z/V/N as instructions see them
+    Byte Length;        // opcode plus operand bytes; 1 for an opcode without a handler
+    Byte Reserved;
+};
+static_assert(sizeof(TraceEntry) == 16);
+
+// Opcodes[].Length, with 1 for opcodes without a handler
+constexpr std::array<Byte, 256> TraceLengths = [] {
+    std::array<Byte, 256> lengths{};
+    for (u32 opcode = 0; opcode < 256; ++opcode)
+        lengths[opcode] = Opcodes[opcode].Implemented() ? Opcodes[opcode].Length : 1;
+    return lengths;
+}();
+
+// An instruction as Execute records it: the code bytes as they lie in
+// memory and the registers as they lie in the CPU, with the operand masking
+// and flag packing left to Entry
+struct TraceSlot {
+    u32 Cycle;
+    Byte Code[4];       // the opcode and the bytes after it, whether it takes them or not
+    Word PC;
+    // In TraceEntry's order rather than the CPU's, so that the compiler does
+    // not turn the copy into one wide load of bytes stored one at a time
+    Byte A, X, Y, SP;
+    Byte PS;
+#if defined(CP6502_LAZY_FLAGS)
+    Byte LazyC, LazyV;
+    Byte LazyZ, LazyN;
+    Byte Spare;
+#else
+    Byte Spare;
+#endif
+
+    TraceEntry Entry() const {
+        const Byte length = TraceLengths[Code[0]];
+        TraceEntry entry;
+        entry.Cycle = Cycle;
+        entry.PC = PC;
+        entry.Opcode = Code[0];
+        entry.Operand[0] = length >= 2 ? Code[1] : 0;
+        entry.Operand[1] = length == 3 ? Code[2] : 0;
+        entry.A = A;
+        entry.X = X;
+        entry.Y = Y;
+        entry.SP = SP;
+#if defined(CP6502_LAZY_FLAGS)
+        // as CPU::Status
+        entry.PS = (PS & ~(CarryFlag | ZeroFlag | OverflowFlag | NegativeFlag)) |
+                   LazyC | ((LazyZ == 0) << 1) | (LazyV << 6) | (LazyN & NegativeFlag);
+#else
+        entry.PS = PS;
+#endif
+        entry.Length = length;
+        entry.Reserved = 0;
+        return entry;
+    }
+};
+static_assert(sizeof(TraceSlot) % 4 == 0);
+
+// Fills slot with the instruction cpu is about to run, whose opcode Execute
+// has just fetched: PC is one past it. The registers are read a field at a
+// time, as the handler before stored them, and all before the first store
+// to the slot, which may alias them
+template <typename CPUT, typename BusT>
+void CaptureTrace(TraceSlot& slot, CPUT const& cpu, BusT const& memory, Byte opcode, u32 cycle) {
+    const Word pc = Word(cpu.PC - 1);
+    const Byte sp = cpu.SP, a = cpu.A, x = cpu.X, y = cpu.Y, ps = cpu.PS;
+#if defined(CP6502_LAZY_FLAGS)
+    const Byte lazyC = cpu.LazyC, lazyV = cpu.LazyV, lazyZ = cpu.LazyZ, lazyN = cpu.LazyN;
+#endif
+    Byte code[sizeof(slot.Code)] = { opcode };
+    if constexpr (std::is_same_v<BusT, Mem>) {
+        // Reads have no side effects: take four bytes at once, unless they
+        // would run off the end
+        if (pc <= Mem::MAX_MEM - sizeof(code)) {
+            memcpy(code, &memory.Data[pc], sizeof(code));
+        } else {
+            code[1] = memory.Read(Word(pc + 1));
+            code[2] = memory.Read(Word(pc + 2));
+        }
+    } else {
+        const Byte length = TraceLengths[opcode];
+        code[1] = length >= 2 ? memory.Read(Word(pc + 1)) : 0;
+        code[2] = length == 3 ? memory.Read(Word(pc + 2)) : 0;
+    }
+    slot.Cycle = cycle;
+    memcpy(slot.Code, code, sizeof(code));
+    slot.PC = pc;
+    slot.A = a;
+    slot.X = x;
+    slot.Y = y;
+    slot.SP = sp;
+    slot.PS = ps;
+#if defined(CP6502_LAZY_FLAGS)
+    slot.LazyC = lazyC;
+    slot.LazyV = lazyV;
+    slot.LazyZ = lazyZ;
+    slot.LazyN = lazyN;
+#endif
+}
+
+}
+
+struct cp6502::TraceRing {
+    // Holds the last Capacity() instructions of 2^capacityLog2 slots. The
+    // rest are for the entries being written while Last copies the others:
+    // Execute publishes what it has recorded only every PublishEvery
+    // entries (64, or a quarter of a smaller ring) and as it returns.
+    explicit TraceRing(u32 capacityLog2 = 16);
+
+    static constexpr u64 MaxPublishEvery = 64;
+
+    // The trace policy Execute runs with. It keeps nothing but the ring in a
+    // register: the write position lives in the ring, next to the slots, so
+    // the interpreter's own registers are not spilled around every handler
+    // call to make room for it
+    struct Recorder {
+        explicit Recorder(TraceRing& ring) : Ring(ring) {
+        }
+
+        template <typename CPUT, typename BusT>
+        void Record(CPUT const& cpu, BusT const& memory, Byte opcode, s32 cyclesUsed) {
+            TraceSlot* slot = Ring.Next;
+            CaptureTrace(*slot, cpu, memory, opcode, u32(Ring.Cycles) + u32(cyclesUsed));
+            Ring.Next = ++slot;
+            if (slot == Ring.PublishAt)
+                Ring.Publish();
+        }
+
+        // Called by Execute as it returns
+        void Advance(s32 cyclesUsed) {
+            Ring.Publish();
+            Ring.Cycles += cyclesUsed;
+        }
+
+    private:
+        TraceRing& Ring;
+    };
+
+    // Instructions recorded since construction or Clear, including those
+    // since overwritten; while Execute runs, up to those it has published
+    u64 Count() const {
+        return Head.load(std::memory_order_acquire);
+    }
+
+    u32 Capacity() const {
+        return u32(Mask + 1 - PublishEvery);
+    }
+
+    // Up to the last n instructions, oldest first
+    std::vector<TraceEntry> Last(u32 n) const;
+
+    // Writes Last(Capacity()) as raw TraceEntry records; returns how many
+    size_t Write(FILE* out) const;
+
+    // Writes Last(Capacity()) as text, one FormatTrace line each, with
+    // addresses as labels given symbols; returns how many
+    size_t WriteText(FILE* out, Symbols const* symbols = nullptr) const;
+
+    // Only while no Execute is recording
+    void Clear();
+
+private:
+    // Stores Head for the slots written since it was last called, wrapping
+    // Next round at the end of the ring
+    void Publish() {
+        const u64 head = Head.load(std::memory_order_relaxed) + u64(Next - Published);
+        if (Next == Entries.data() + Entries.size())
+            Next = Entries.data();
+        Published = Next;
+        PublishAt = Entries.data() + ((Next - Entries.data()) / PublishEvery + 1) * PublishEvery;
+        Head.store(head, std::memory_order_release);
+    }
+
+    std::vector<TraceSlot> Entries;
+    u64 Mask;
+    u64 PublishEvery;   // a power of two
+    std::atomic<u64> Head = 0;
+    u64 Cycles = 0;     // run by Executes that have returned
+    // Written only by Execute: where the next slot goes, and the slot at
+    // which Record next publishes, every PublishEvery slots and at the end
+    TraceSlot* Next;
+    TraceSlot* PublishAt;
+    TraceSlot* Published;   // Next when Head was last stored
+};
@@ -0,0 +1,186 @@
+#include "tracefile.hpp"
+
+#include <string.h>
+
+#include <chrono>
+
+namespace cp6502 {
+
+namespace {
+
+constexpr size_t BufferSize = 64 * 1024;
+
+// The bytes of an instruction as kept per PC, with a bit so that no
+// instruction matches a PC not yet seen
+u32 PackCode(TraceEntry const& entry) {
+    return entry.Opcode | (entry.Operand[0] << 8) | (entry.Operand[1] << 16) | (1u << 24);
+}
+
+void PutVarint(std::vector<Byte>& buffer, u64 value) {
+    while (value >= 0x80) {
+        buffer.push_back(Byte(value | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back(Byte(value));
+}
+
+// Where the instruction after entry starts if it does not branch or jump
+Word NextPC(TraceEntry const& entry) {
+    return Word(entry.PC + entry.Length);
+}
+
+} // namespace
+
+TraceWriter::TraceWriter(FILE* out, u32 queueLog2)
+    : Out(out), Entries(size_t(1) << queueLog2), Mask((u64(1) << queueLog2) - 1) {
+    Encoder = std::thread([this] { Encode(); });
+}
+
+TraceWriter::~TraceWriter() {
+    Close();
+}
+
+bool TraceWriter::Close() {
+    if (Encoder.joinable()) {
+        Closing.store(true, std::memory_order_release);
+        Encoder.join();
+    }
+    return !Failed;
+}
+
+void TraceWriter::Flush(std::vector<Byte>& buffer) {
+    if (!Failed && fwrite(buffer.data(), 1, buffer.size(), Out) != buffer.size())
+        Failed = true;
+    Written.fetch_add(buffer.size(), std::memory_order_release);
+    buffer.clear();
+}
+
+void TraceWriter::Encode() {
+    std::vector<Byte> buffer(TraceFormat::Magic, TraceFormat::Magic + sizeof(TraceFormat::Magic));
+    buffer.reserve(BufferSize + 64);
+    std::vector<u32> code(0x10000, 0);
+    TraceEntry previous = {};
+    u64 tail = Tail.load(std::memory_order_relaxed);
+
+    while (true) {
+        // Closing is set only once the last Execute has published its
+        // entries, so Head read after it is final
+        const bool closing = Closing.load(std::memory_order_acquire);
+        const u64 head = Head.load(std::memory_order_acquire);
+        if (tail == head) {
+            if (closing)
+                break;
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            continue;
+        }
+        for (; tail != head; ++tail) {
+            const TraceEntry entry = Entries[tail & Mask].Entry();
+            const u32 packed = PackCode(entry);
+            Byte flags = 0;
+            if (entry.PC != NextPC(previous)) flags |= TraceFormat::Jumped;
+            if (entry.A != previous.A) flags |= TraceFormat::NewA;
+            if (entry.X != previous.X) flags |= TraceFormat::NewX;
+            if (entry.Y != previous.Y) flags |= TraceFormat::NewY;
+            if (entry.SP != previous.SP) flags |= TraceFormat::NewSP;
+            if (entry.PS != previous.PS) flags |= TraceFormat::NewPS;
+            if (code[entry.PC] != packed) flags |= TraceFormat::NewCode;
+
+            buffer.push_back(flags);
+            if (flags & TraceFormat::Jumped) {
+                // zigzag, so that short branches back take one byte too
+                const s32 offset = int16_t(Word(entry.PC - NextPC(previous)));
+                PutVarint(buffer, (u32(offset) << 1) ^ u32(offset >> 31));
+            }
+            PutVarint(buffer, u32(entry.Cycle - previous.Cycle));
+            if (flags & TraceFormat::NewA) buffer.push_back(entry.A);
+            if (flags & TraceFormat::NewX) buffer.push_back(entry.X);
+            if (flags & TraceFormat::NewY) buffer.push_back(entry.Y);
+            if (flags & TraceFormat::NewSP) buffer.push_back(entry.SP);
+            if (flags & TraceFormat::NewPS) buffer.push_back(entry.PS);
+            if (flags & TraceFormat::NewCode) {
+                buffer.insert(buffer.end(), { entry.Opcode, entry.Operand[0], entry.Operand[1] });
+                code[entry.PC] = packed;
+            }
+            previous = entry;
+
+            if (buffer.size() >= BufferSize) {
+                Tail.store(tail + 1, std::memory_order_release);
+                Flush(buffer);
+            }
+        }
+        Tail.store(tail, std::memory_order_release);
+    }
+    Flush(buffer);
+    if (fflush(Out) != 0)
+        Failed = true;
+}
+
+TraceReader::TraceReader(FILE* in) : In(in), Code(0x10000, 0) {
+    char magic[sizeof(TraceFormat::Magic)];
+    IsTrace = fread(magic, 1, sizeof(magic), In) == sizeof(magic) &&
+              memcmp(magic, TraceFormat::Magic, sizeof(magic)) == 0;
+}
+
+bool TraceReader::ReadByte(Byte& value) {
+    if (Position == Buffer.size()) {
+        Buffer.resize(BufferSize);
+        Buffer.resize(fread(Buffer.data(), 1, BufferSize, In));
+        Position = 0;
+        if (Buffer.empty())
+            return false;
+    }
+    value = Buffer[Position++];
+    return true;
+}
+
+bool TraceReader::ReadVarint(u64& value) {
+    value = 0;
+    Byte byte;
+    for (u32 shift = 0; shift < 64; shift += 7) {
+        if (!ReadByte(byte))
+            return false;
+        value |= u64(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+bool TraceReader::Next(TraceEntry& entry) {
+    Byte flags;
+    u64 value;
+    if (!IsTrace || !ReadByte(flags))
+        return false;
+    entry = Previous;
+    entry.PC = NextPC(Previous);
+    if (flags & TraceFormat::Jumped) {
+        if (!ReadVarint(value))
+            return false;
+        entry.PC = Word(entry.PC + Word((value >> 1) ^ -(value & 1)));
+    }
+    if (!ReadVarint(value))
+        return false;
+    entry.Cycle = u32(Previous.Cycle + value);
+    if ((flags & TraceFormat::NewA) && !ReadByte(entry.A)) return false;
+    if ((flags & TraceFormat::NewX) && !ReadByte(entry.X)) return false;
+    if ((flags & TraceFormat::NewY) && !ReadByte(entry.Y)) return false;
+    if ((flags & TraceFormat::NewSP) && !ReadByte(entry.SP)) return false;
+    if ((flags & TraceFormat::NewPS) && !ReadByte(entry.PS)) return false;
+    if (flags & TraceFormat::NewCode) {
+        Byte bytes[3];
+        for (Byte& byte : bytes)
+            if (!ReadByte(byte))
+                return false;
+        Code[entry.PC] = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16);
+    }
+    const u32 packed = Code[entry.PC];
+    entry.Opcode = Byte(packed);
+    entry.Operand[0] = Byte(packed >> 8);
+    entry.Operand[1] = Byte(packed >> 16);
+    entry.Length = TraceLengths[entry.Opcode];
+    entry.Reserved = 0;
+    Previous = entry;
+    return true;
+}
+
+} // namespace cp6502
@@ -0,0 +1,163 @@
+#pragma once
+#include <stdio.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "trace.hpp"
+
+// Trace files for runs far longer than a TraceRing holds, written by
+// CPU::Execute(cycles, memory, writer) and read back by TraceReader.
+//
+// Execute only copies each instruction's TraceSlot into a single-producer,
+// single-consumer queue; a background thread encodes the queue and writes
+// it out, so the emulation never waits on the disk. It waits on the queue
+// only if the encoder falls a whole queue behind, and counts those waits.
+//
+// The file is Magic, then one record per instruction, each encoded against
+// the one before:
+//
+//     flags                 a byte of the Changed bits below
+//     PC                    if Jumped: zigzag varint of PC less the PC
+//                           straight after the previous instruction
+//     cycles                varint of Cycle less the previous Cycle
+//     A, X, Y, SP, PS       a byte each, only those flagged
+//     opcode, operands[2]   if NewCode: the instruction bytes at PC
+//
+// The instruction bytes are sent the first time each PC runs and again only
+// if they change there, so a loop costs about two bytes an instruction
+// plus the registers it changes.
+namespace cp6502 {
+
+struct TraceFormat {
+    static constexpr char Magic[8] = { 'c', 'p', '6', '5', '0', '2', 't', 1 };
+
+    enum Changed : Byte {
+        Jumped  = 1 << 0,
+        NewA    = 1 << 1,
+        NewX    = 1 << 2,
+        NewY    = 1 << 3,
+        NewSP   = 1 << 4,
+        NewPS   = 1 << 5,
+        NewCode = 1 << 6,
+    };
+};
+
+}
+
+struct cp6502::TraceWriter {
+    // Writes to out, which must stay open until Close; the queue holds
+    // 2^queueLog2 instructions
+    explicit TraceWriter(FILE* out, u32 queueLog2 = 16);
+    ~TraceWriter();
+
+    TraceWriter(TraceWriter const&) = delete;
+    TraceWriter& operator=(TraceWriter const&) = delete;
+
+    // The trace policy Execute runs with. Entries are published to the
+    // encoder a batch at a time and when Execute returns, so the encoder's
+    // reads of the queue position do not bounce its cache line every
+    // instruction.
+    struct Recorder {
+        static constexpr u64 PublishEvery = 256;
+
+        explicit Recorder(TraceWriter& writer)
+            : Writer(writer), Entries(writer.Entries.data()), Mask(writer.Mask),
+              Head(writer.Head.load(std::memory_order_relaxed)),
+              Limit(writer.Tail.load(std::memory_order_acquire) + Mask + 1), Cycles(writer.Cycles) {
+        }
+
+        template <typename CPUT, typename BusT>
+        void Record(CPUT const& cpu, BusT const& memory, Byte opcode, s32 cyclesUsed) {
+            if (Head == Limit)
+                WaitForRoom();
+            CaptureTrace(Entries[Head & Mask], cpu, memory, opcode, u32(Cycles + cyclesUsed));
+            if (++Head % PublishEvery == 0)
+                Writer.Head.store(Head, std::memory_order_release);
+        }
+
+        // Called by Execute as it returns
+        void Advance(s32 cyclesUsed) {
+            Writer.Head.store(Head, std::memory_order_release);
+            Writer.Cycles = Cycles + cyclesUsed;
+        }
+
+    private:
+        void WaitForRoom() {
+            Writer.Head.store(Head, std::memory_order_release);
+            while ((Limit = Writer.Tail.load(std::memory_order_acquire) + Mask + 1) == Head) {
+                Writer.Waits.fetch_add(1, std::memory_order_relaxed);
+                std::this_thread::yield();
+            }
+        }
+
+        TraceWriter& Writer;
+        TraceSlot* Entries;
+        u64 Mask;
+        u64 Head;
+        u64 Limit;      // Head may not reach this until the encoder moves on
+        u64 Cycles;
+    };
+
+    // Encodes and writes everything recorded, and stops the background
+    // thread; returns false if a write failed. Only while no Execute is
+    // recording. The destructor closes the writer if need be.
+    bool Close();
+
+    // Instructions recorded
+    u64 Count() const {
+        return Head.load(std::memory_order_acquire);
+    }
+
+    // Bytes written to the file so far, including Magic
+    u64 BytesWritten() const {
+        return Written.load(std::memory_order_acquire);
+    }
+
+    // Times Execute found the queue full and had to wait for the encoder
+    u64 QueueWaits() const {
+        return Waits.load(std::memory_order_relaxed);
+    }
+
+private:
+    void Encode();
+    void Flush(std::vector<Byte>& buffer);
+
+    FILE* Out;
+    std::vector<TraceSlot> Entries;
+    u64 Mask;
+    alignas(64) std::atomic<u64> Head = 0;  // written by Execute
+    u64 Cycles = 0;
+    alignas(64) std::atomic<u64> Tail = 0;  // written by the encoder
+    std::atomic<u64> Written = 0;
+    std::atomic<u64> Waits = 0;
+    std::atomic<bool> Closing = false;
+    bool Failed = false;
+    std::thread Encoder;
+};
+
+struct cp6502::TraceReader {
+    // Reads from in, which must be positioned at the start of a trace file
+    explicit TraceReader(FILE* in);
+
+    // Whether the file started with TraceFormat::Magic
+    bool Valid() const {
+        return IsTrace;
+    }
+
+    // Decodes the next instruction; false at the end of the file, or if it
+    // ends part way through a record
+    bool Next(TraceEntry& entry);
+
+private:
+    bool ReadByte(Byte& value);
+    bool ReadVarint(u64& value);
+
+    FILE* In;
+    bool IsTrace = false;
+    TraceEntry Previous = {};
+    std::vector<u32> Code;      // instruction bytes last seen at each PC
+    std::vector<Byte> Buffer;
+    size_t Position = 0;
+};
@@ -459,4 +459,20 @@ TEST_F(AddWithCarryTests, ADCIndYAdd_20_n23_Carry_1) {
 }
 TEST_F(AddWithCarryTests, ADCIndYAdd_n20_23_Carry_1) {
     TestIndY(data_add_n20_23_carry_1);
-}
\ No newline at end of file
+}
+TEST_F(AddWithCarryTests, ADCImAddDecimal_58_46_Carry_1) {
+    cpu.D = 1;
+    // N and V come from the sum before the high digit is adjusted, Z from the binary sum
+    ADCTestData test = {
+        .Carry = 1,
+        .A = 0x58,
+        .Operand = 0x46,
+
+        .Answer = 0x05,
+        .ExpectC = true,
+        .ExpectZ = false,
+        .ExpectV = true,
+        .ExpectN = true,
+    };
+    TestIm(test);
+}
@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+
+#include "../core/alu.hpp"
+
+using namespace cp6502;
+
+TEST(AluTests, AddSetsCarryZeroOverflowAndNegative) {
+    // when:
+    const AluResult positiveOverflow = AddArithmetic(0x7F, 0x01, 0);
+    const AluResult carryToZero = AddArithmetic(0xFF, 0x00, 1);
+    // then:
+    EXPECT_EQ(positiveOverflow.Result, 0x80);
+    EXPECT_EQ(positiveOverflow.Flags, OverflowFlag | NegativeFlag);
+    EXPECT_EQ(carryToZero.Result, 0x00);
+    EXPECT_EQ(carryToZero.Flags, CarryFlag | ZeroFlag);
+}
+
+TEST(AluTests, CompareSetsCarryZeroAndNegative) {
+    EXPECT_EQ(CompareArithmetic(0x40, 0x40), CarryFlag | ZeroFlag);
+    EXPECT_EQ(CompareArithmetic(0x40, 0x41), NegativeFlag);
+    EXPECT_EQ(CompareArithmetic(0x41, 0x40), CarryFlag);
+}
+
+TEST(AluTests, AddTableMatchesArithmetic) {
+    for (u32 carry = 0; carry < 2; ++carry)
+        for (u32 a = 0; a < 256; ++a)
+            for (u32 operand = 0; operand < 256; ++operand) {
+                const AluResult expected = Add<Alu::Arithmetic>(a, operand, carry);
+                const AluResult actual = Add<Alu::Table>(a, operand, carry);
+                ASSERT_EQ(actual.Result, expected.Result) << a << " + " << operand << " + " << carry;
+                ASSERT_EQ(actual.Flags, expected.Flags) << a << " + " << operand << " + " << carry;
+            }
+}
+
+TEST(AluTests, CompareTableMatchesArithmetic) {
+    for (u32 reg = 0; reg < 256; ++reg)
+        for (u32 operand = 0; operand < 256; ++operand)
+            ASSERT_EQ(Compare<Alu::Table>(reg, operand), Compare<Alu::Arithmetic>(reg, operand)) << reg << " - " << operand;
+}
+
+// Packs 0-99 as two BCD digits
+static Byte Bcd(u32 value) {
+    return (value / 10) << 4 | value % 10;
+}
+
+TEST(AluTests, AddDecimalAddsBcd) {
+    for (u32 carry = 0; carry < 2; ++carry)
+        for (u32 a = 0; a < 100; ++a)
+            for (u32 operand = 0; operand < 100; ++operand) {
+                const u32 sum = a + operand + carry;
+                const AluResult actual = AddDecimalArithmetic(Bcd(a), Bcd(operand), carry);
+                ASSERT_EQ(actual.Result, Bcd(sum % 100)) << a << " + " << operand << " + " << carry;
+                ASSERT_EQ(actual.Flags & CarryFlag, sum >= 100 ? CarryFlag : 0) << a << " + " << operand << " + " << carry;
+            }
+}
+
+TEST(AluTests, SubtractDecimalSubtractsBcd) {
+    for (u32 carry = 0; carry < 2; ++carry)
+        for (u32 a = 0; a < 100; ++a)
+            for (u32 operand = 0; operand < 100; ++operand) {
+                const s32 difference = s32(a) - s32(operand) - (1 - s32(carry));
+                const AluResult actual = SubtractDecimalArithmetic(Bcd(a), Bcd(operand), carry);
+                ASSERT_EQ(actual.Result, Bcd((difference + 100) % 100)) << a << " - " << operand << " - " << 1 - carry;
+                ASSERT_EQ(actual.Flags & CarryFlag, difference >= 0 ? CarryFlag : 0) << a << " - " << operand << " - " << 1 - carry;
+            }
+}
+
+TEST(AluTests, DecimalFlagsFollowTheNmos6502) {
+    // Z from the binary sum ($9A), N from the sum before the high digit is adjusted ($A0)
+    const AluResult wrapToZero = AddDecimalArithmetic(0x99, 0x01, 0);
+    EXPECT_EQ(wrapToZero.Result, 0x00);
+    EXPECT_EQ(wrapToZero.Flags, CarryFlag | NegativeFlag);
+    // V as if $70 + $10 were signed binary
+    const AluResult overflow = AddDecimalArithmetic(0x79, 0x00, 1);
+    EXPECT_EQ(overflow.Result, 0x80);
+    EXPECT_EQ(overflow.Flags, OverflowFlag | NegativeFlag);
+    // SBC sets every flag as binary $00 - $01 does
+    const AluResult borrow = SubtractDecimalArithmetic(0x00, 0x01, 1);
+    EXPECT_EQ(borrow.Result, 0x99);
+    EXPECT_EQ(borrow.Flags, NegativeFlag);
+    // Non-BCD digits are adjusted as the NMOS part does
+    EXPECT_EQ(AddDecimalArithmetic(0x0F, 0x01, 0).Result, 0x16);
+    EXPECT_EQ(SubtractDecimalArithmetic(0x10, 0x0F, 1).Result, 0x0B);
+}
+
+TEST(AluTests, DecimalTablesMatchArithmetic) {
+    for (u32 carry = 0; carry < 2; ++carry)
+        for (u32 a = 0; a < 256; ++a)
+            for (u32 operand = 0; operand < 256; ++operand) {
+                const AluResult add = AddDecimal<Alu::Table>(a, operand, carry);
+                const AluResult subtract = SubtractDecimal<Alu::Table>(a, operand, carry);
+                ASSERT_EQ(add.Result, AddDecimalArithmetic(a, operand, carry).Result);
+                ASSERT_EQ(add.Flags, AddDecimalArithmetic(a, operand, carry).Flags);
+                ASSERT_EQ(subtract.Result, SubtractDecimalArithmetic(a, operand, carry).Result);
+                ASSERT_EQ(subtract.Flags, SubtractDecimalArithmetic(a, operand, carry).Flags);
+            }
+}
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+
+#include "../core/cp6502.hpp"
+#include "../core/blockcache.hpp"
+
+using namespace cp6502;
+
+struct BlockCacheTests : public testing::Test {
+    Mem mem;
+    CPU cpu;
+    BlockCache cache;
+
+    // stest/test_code.ms
+    constexpr static s32 NumByteTestProg = 13;
+    Byte TestProg[NumByteTestProg] = { 0x00,0x10,0xA9,0x00,0x18,0x69,0x08,0xC9,0x18,0xD0,0xFA,0xA2,0x14 };
+
+    virtual void SetUp() {
+        cpu.Reset(0xFF00, mem);
+    }
+
+    virtual void TearDown() {
+    }
+};
+
+TEST_F(BlockCacheTests, RunsTestProgramLikeTheInterpreter) {
+    // given:
+    cpu.PC = cpu.LoadProg(TestProg, NumByteTestProg, mem);
+    constexpr s32 EXPECTED_CYCLES = 26;
+    // when:
+    const s32 actualCycles = cpu.Execute(EXPECTED_CYCLES, mem, cache);
+    // then:
+    EXPECT_EQ(actualCycles, EXPECTED_CYCLES);
+    EXPECT_EQ(cpu.PC, 0x100B);
+    EXPECT_EQ(cpu.A, 24);
+    EXPECT_EQ(cpu.X, 20);
+    EXPECT_TRUE(cpu.C);
+    EXPECT_FALSE(cpu.Z);
+    EXPECT_FALSE(cpu.N);
+}
+
+TEST_F(BlockCacheTests, LoopBodyIsDecodedOnce) {
+    // given:
+    cpu.PC = cpu.LoadProg(TestProg, NumByteTestProg, mem);
+    // when:
+    cpu.Execute(26, mem, cache);
+    // then:
+    EXPECT_EQ(cache.Decodes, 3);    // $1000, the loop at $1003, $1009
+    EXPECT_EQ(cache.NumBlocks(), 3);
+}
+
+TEST_F(BlockCacheTests, CanStopPartWayThroughABlock) {
+    // given:
+    cpu.PC = cpu.LoadProg(TestProg, NumByteTestProg, mem);
+    // when:
+    const s32 actualCycles = cpu.Execute(3, mem, cache);
+    // then:
+    EXPECT_EQ(actualCycles, 4);
+    EXPECT_EQ(cpu.PC, 0x1003);
+}
+
+TEST_F(BlockCacheTests, WriteToAnotherPageKeepsBlocks) {
+    // given:
+    cpu.PC = cpu.LoadProg(TestProg, NumByteTestProg, mem);
+    cpu.Execute(26, mem, cache);
+    const u32 decodes = cache.Decodes;
+    // when:
+    mem[0x2000] = 0x42;
+    cpu.PC = 0x1000;
+    cpu.Execute(26, mem, cache);
+    // then:
+    EXPECT_EQ(cache.Decodes, decodes);
+}
+
+TEST_F(BlockCacheTests, WriteToCodePageRedecodesBlocks) {
+    // given:
+    cpu.PC = cpu.LoadProg(TestProg, NumByteTestProg, mem);
+    cpu.Execute(26, mem, cache);
+    const u32 decodes = cache.Decodes;
+    // when:
+    mem[0x100A] = 0x42;     // ldx #$42
+    cpu.PC = 0x1000;
+    cpu.Execute(26, mem, cache);
+    // then:
+    EXPECT_GT(cache.Decodes, decodes);
+    EXPECT_EQ(cpu.X, 0x42);
+}
+
+TEST_F(BlockCacheTests, StoreIntoTheRunningBlockTakesEffect) {
+    // given:
+    cpu.PC = 0x1000;
+    mem[0x1000] = CPU::INS_LDA_IM;
+    mem[0x1001] = 0x05;
+    mem[0x1002] = CPU::INS_STA_ABS;     // patch the operand of the ldx below
+    mem[0x1003] = 0x06;
+    mem[0x1004] = 0x10;
+    mem[0x1005] = CPU::INS_LDX_IM;
+    mem[0x1006] = 0x00;
+    constexpr s32 EXPECTED_CYCLES = 2 + 4 + 2;
+    // when:
+    const s32 actualCycles = cpu.Execute(EXPECTED_CYCLES, mem, cache);
+    // then:
+    EXPECT_EQ(actualCycles, EXPECTED_CYCLES);
+    EXPECT_EQ(cpu.X, 0x05);
+    EXPECT_EQ(cpu.PC, 0x1007);
+}
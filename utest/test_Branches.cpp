@@ -274,3 +274,17 @@ TEST_F(BranchesTests, BEQInProgram) {
     EXPECT_EQ(actualCycles, EXPECTED_CYCLES);
     EXPECT_EQ(cpu.PC, 0xFF00);
 }
+
+TEST_F(BranchesTests, BranchToItselfStopsExecuteWhenItIsATrap) {
+    // given:
+    cpu.StopOnTrap = true;
+    cpu.Z = false;
+    mem[0xFF00] = CPU::INS_BNE;
+    mem[0xFF01] = Byte(-2);
+    // when:
+    const ExecuteResult result = cpu.Execute(100, mem);
+    // then:
+    EXPECT_EQ(result.Reason, StopReason::Trap);
+    EXPECT_EQ(result.Cycles, 3);
+    EXPECT_EQ(result.PC, 0xFF00);
+}
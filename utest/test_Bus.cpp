@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include <stdio.h>
+
+#include "../core/cp6502.hpp"
+#include "../core/bus.hpp"
+
+using namespace cp6502;
+
+namespace {
+
+// Remembers the last write and answers every read with the next value of a counter
+struct CountingDevice : Device {
+    Word LastAddress = 0;
+    Byte LastValue = 0;
+    u32 Writes = 0;
+    Byte Counter = 0;
+
+    Byte Read(Word address) override {
+        LastAddress = address;
+        return Counter++;
+    }
+
+    void Write(Word address, Byte value) override {
+        LastAddress = address;
+        LastValue = value;
+        ++Writes;
+    }
+};
+
+} // namespace
+
+struct BusTests : public testing::Test {
+    static constexpr u32 RAM_PAGES = 0x80;
+    Byte ram[RAM_PAGES * Bus::PAGE_SIZE];
+    Byte rom[Bus::PAGE_SIZE * 2];
+    Bus bus;
+    CountingDevice device;
+    BasicCPU<Bus> cpu;
+
+    virtual void SetUp() {
+        bus.MapRam(0x00, RAM_PAGES, ram);
+        bus.MapDevice(0xD0, 1, device);
+        for (u32 i = 0; i < sizeof(rom); ++i)
+            rom[i] = i;
+        bus.MapRom(0xFE, 2, rom);
+        cpu.Reset(0x1000, bus);
+    }
+
+    virtual void TearDown() {
+    }
+};
+
+TEST_F(BusTests, ResetClearsRamButNotRom) {
+    // given:
+    ram[0x1234] = 0x42;
+    // when:
+    cpu.Reset(0x1000, bus);
+    // then:
+    EXPECT_EQ(bus.Read(0x1234), 0);
+    EXPECT_EQ(bus.Read(0xFF10), 0x10);
+}
+
+TEST_F(BusTests, RomIgnoresWrites) {
+    // given:
+    Byte prog[] = {
+        0x00, 0x10,
+        0xA9, 0x55,         // $1000 LDA #$55
+        0x8D, 0x20, 0xFE,   // $1002 STA $FE20
+        0xAD, 0x20, 0xFE,   // $1005 LDA $FE20
+    };
+    cpu.LoadProg(prog, sizeof(prog), bus);
+    // when:
+    const s32 cyclesUsed = cpu.Execute(2 + 4 + 4, bus);
+    // then:
+    EXPECT_EQ(cyclesUsed, 10);
+    EXPECT_EQ(cpu.A, 0x20);
+    EXPECT_EQ(rom[0x20], 0x20);
+}
+
+TEST_F(BusTests, UnmappedPagesReadZeroAndDropWrites) {
+    // when:
+    bus.Write(0x9000, 0x77);
+    // then:
+    EXPECT_EQ(bus.Read(0x9000), 0);
+}
+
+TEST_F(BusTests, DevicePagesGoToTheDevice) {
+    // given:
+    Byte prog[] = {
+        0x00, 0x10,
+        0xA9, 0x99,         // $1000 LDA #$99
+        0x8D, 0x12, 0xD0,   // $1002 STA $D012
+        0xAE, 0x34, 0xD0,   // $1005 LDX $D034
+        0xAC, 0x34, 0xD0,   // $1008 LDY $D034
+    };
+    cpu.LoadProg(prog, sizeof(prog), bus);
+    // when:
+    cpu.Execute(2 + 4 + 4 + 4, bus);
+    // then:
+    EXPECT_EQ(device.Writes, 1);
+    EXPECT_EQ(device.LastValue, 0x99);
+    EXPECT_EQ(device.LastAddress, 0xD034);
+    EXPECT_EQ(cpu.X, 0);
+    EXPECT_EQ(cpu.Y, 1);
+    EXPECT_EQ(bus.Read(0x1000), 0xA9);
+}
+
+TEST_F(BusTests, PassesFunctionalTestOnRam) {
+    // given:
+    static Mem mem;
+    bus.MapRam(0x00, Bus::NUM_PAGES, mem.Data);
+    cpu.Reset(0x0400, bus);
+    FILE* fp = fopen(CP6502_STEST_DIR "/6502_functional_test.bin", "rb");
+    ASSERT_NE(fp, nullptr);
+    const size_t size = Mem::MAX_MEM - 0x000A;
+    ASSERT_EQ(fread(&mem.Data[0x000A], 1, size, fp), size);
+    fclose(fp);
+    constexpr s32 EXPECTED_CYCLES = 84032391;
+    // when:
+    const s32 cyclesUsed = cpu.Execute(EXPECTED_CYCLES, bus);
+    // then:
+    EXPECT_EQ(cyclesUsed, EXPECTED_CYCLES);
+    EXPECT_EQ(cpu.PC, 0x3699);
+}
@@ -0,0 +1,348 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "../core/cp6502.hpp"
+#include "../core/alu.hpp"
+#include "../core/batch.hpp"
+#include "../core/opcodes.hpp"
+
+using namespace cp6502;
+
+struct CPUBatchTests : public testing::Test {
+    static constexpr u32 LANES = 4;
+    Mem mem[LANES];
+    CPUBatch<LANES> batch;
+
+    // stest/test_code.ms
+    Byte AddLoop[13] = { 0x00,0x10,0xA9,0x00,0x18,0x69,0x08,0xC9,0x18,0xD0,0xFA,0xA2,0x14 };
+    Byte CountLoop[10] = {
+        0x00, 0x20,
+        0xA0, 0x10,         // $2000 LDY #16
+        0xC8,               // $2002 INY
+        0x84, 0x40,         // $2003 STY $40
+        0x4C, 0x02, 0x20,   // $2005 JMP $2002
+    };
+    Byte Illegal[5] = {
+        0x00, 0x30,
+        0xA9, 0x07,         // $3000 LDA #7
+        0x02,               // $3002 no handler
+    };
+
+    virtual void SetUp() {
+    }
+
+    virtual void TearDown() {
+    }
+
+    void Load(u32 lane, Byte* prog, u32 numBytes) {
+        CPU cpu;
+        cpu.Reset(0xFF00, mem[lane]);
+        cpu.PC = cpu.LoadProg(prog, numBytes, mem[lane]);
+        batch.Load(lane, cpu, mem[lane]);
+    }
+};
+
+TEST_F(CPUBatchTests, LanesRunLikeSeparateCpus) {
+    // given:
+    Load(0, AddLoop, sizeof(AddLoop));
+    Load(1, CountLoop, sizeof(CountLoop));
+    Load(2, CountLoop, sizeof(CountLoop));
+    Load(3, AddLoop, sizeof(AddLoop));
+    Mem refMem[LANES];
+    CPU refCpu[LANES];
+    for (u32 lane = 0; lane < LANES; ++lane) {
+        refMem[lane] = mem[lane];
+        refCpu[lane] = batch.Lane(lane);
+    }
+    constexpr s32 CYCLES = 26;
+    // when:
+    batch.Execute(CYCLES);
+    // then:
+    for (u32 lane = 0; lane < LANES; ++lane) {
+        const s32 expectedCycles = refCpu[lane].Execute(CYCLES, refMem[lane]);
+        EXPECT_EQ(CYCLES - batch.Cycles[lane], expectedCycles);
+        EXPECT_EQ(batch.PC[lane], refCpu[lane].PC);
+        EXPECT_EQ(batch.SP[lane], refCpu[lane].SP);
+        EXPECT_EQ(batch.A[lane], refCpu[lane].A);
+        EXPECT_EQ(batch.X[lane], refCpu[lane].X);
+        EXPECT_EQ(batch.Y[lane], refCpu[lane].Y);
+        EXPECT_EQ(batch.PS[lane], refCpu[lane].PS);
+        EXPECT_EQ(memcmp(mem[lane].Data, refMem[lane].Data, Mem::MAX_MEM), 0);
+    }
+    EXPECT_EQ(batch.A[0], 24);
+    EXPECT_EQ(batch.X[0], 20);
+}
+
+TEST_F(CPUBatchTests, IllegalOpcodeHaltsOnlyItsLane) {
+    // given:
+    Load(0, Illegal, sizeof(Illegal));
+    Load(1, CountLoop, sizeof(CountLoop));
+    // when:
+    batch.Execute(100);
+    // then:
+    EXPECT_TRUE(batch.Halted[0]);
+    EXPECT_EQ(batch.PC[0], 0x3003);
+    EXPECT_EQ(batch.A[0], 7);
+    EXPECT_FALSE(batch.Halted[1]);
+    EXPECT_LE(batch.Cycles[1], 0);
+    EXPECT_GT(batch.Y[1], 16);
+}
+
+TEST_F(CPUBatchTests, LanesWithoutMemoryDoNotRun) {
+    // given:
+    Load(1, CountLoop, sizeof(CountLoop));
+    // when:
+    batch.Execute(10);
+    // then:
+    EXPECT_EQ(batch.Cycles[0], 0);
+    EXPECT_EQ(batch.Memory[0], nullptr);
+    EXPECT_EQ(batch.PC[1], 0x2002);
+    EXPECT_EQ(mem[1][0x40], 17);
+}
+
+TEST_F(CPUBatchTests, LanesAtTheSamePcRunTogether) {
+    // given:
+    for (u32 lane = 0; lane < LANES; ++lane)
+        Load(lane, AddLoop, sizeof(AddLoop));
+    // when:
+    batch.Execute(26);
+    // then:
+    // one block before the loop, then ADC/CMP/BNE three times
+    EXPECT_EQ(batch.VectorSteps, 4);
+    for (u32 lane = 0; lane < LANES; ++lane) {
+        EXPECT_EQ(batch.Cycles[lane], 0);
+        EXPECT_EQ(batch.PC[lane], 0x100B);
+        EXPECT_EQ(batch.A[lane], 24);
+        EXPECT_EQ(batch.X[lane], 20);
+    }
+}
+
+TEST_F(CPUBatchTests, LockstepFormsAreKnownWithoutRunningThem) {
+    static_assert(CPUBatch<LANES>::HasLockstepForm[CPU::INS_ADC_IM]);
+    static_assert(!CPUBatch<LANES>::HasLockstepForm[CPU::INS_LDA_ABSX]);
+    static_assert(!CPUBatch<LANES>::HasLockstepForm[CPU::INS_JSR]);
+    // then: the table names exactly the opcodes Apply runs; with no lanes
+    // selected it changes nothing
+    const CPUBatch<LANES> before = batch;
+    for (u32 opcode = 0; opcode < 256; ++opcode)
+        EXPECT_EQ(batch.Apply(Byte(opcode), 0, 0, CPUBatch<LANES>::Lanes{}), CPUBatch<LANES>::HasLockstepForm[opcode])
+            << Opcodes[opcode].Name;
+    EXPECT_EQ(batch.PC, before.PC);
+    EXPECT_EQ(batch.PS, before.PS);
+    EXPECT_EQ(batch.Cycles, before.Cycles);
+}
+
+TEST_F(CPUBatchTests, StoresIntoTheBlockAreSeenByTheNextInstruction) {
+    // given: code that patches the operand of the instruction after the store
+    Byte prog[] = {
+        0x00, 0x10,
+        0xA9, 0x2A,         // $1000 LDA #$2A
+        0x8D, 0x06, 0x10,   // $1002 STA $1006
+        0xA2, 0x00,         // $1005 LDX #0, becomes LDX #$2A
+        0x4C, 0x05, 0x10,   // $1007 JMP $1005
+    };
+    for (u32 lane = 0; lane < LANES; ++lane)
+        Load(lane, prog, sizeof(prog));
+    // when:
+    batch.Execute(2 + 4 + 2);
+    // then:
+    for (u32 lane = 0; lane < LANES; ++lane) {
+        EXPECT_EQ(batch.X[lane], 0x2A);
+        EXPECT_EQ(batch.PC[lane], 0x1007);
+    }
+    EXPECT_GT(batch.VectorSteps, 0);
+}
+
+TEST_F(CPUBatchTests, LanesThatDivergeOntoABackwardBranchMatchSeparateCpus) {
+    // given: lane 0 falls into a loop polling $31, lane 1 into one counting X
+    Byte prog[] = {
+        0x00, 0x40,
+        0xA5, 0x30,         // $4000 LDA $30
+        0xD0, 0x04,         // $4002 BNE $4008
+        0xA5, 0x31,         // $4004 LDA $31
+        0xF0, 0xFC,         // $4006 BEQ $4004
+        0xE8,               // $4008 INX
+        0x4C, 0x08, 0x40,   // $4009 JMP $4008
+    };
+    Load(0, prog, sizeof(prog));
+    Load(1, prog, sizeof(prog));
+    mem[1][0x30] = 1;
+    Mem refMem[2];
+    CPU refCpu[2];
+    for (u32 lane = 0; lane < 2; ++lane) {
+        refMem[lane] = mem[lane];
+        refCpu[lane] = batch.Lane(lane);
+    }
+    constexpr s32 CYCLES = 200;
+    // when:
+    batch.Execute(CYCLES);
+    // then:
+    for (u32 lane = 0; lane < 2; ++lane) {
+        const s32 expectedCycles = refCpu[lane].Execute(CYCLES, refMem[lane]);
+        EXPECT_EQ(CYCLES - batch.Cycles[lane], expectedCycles) << lane;
+        EXPECT_EQ(batch.PC[lane], refCpu[lane].PC) << lane;
+        EXPECT_EQ(batch.A[lane], refCpu[lane].A) << lane;
+        EXPECT_EQ(batch.X[lane], refCpu[lane].X) << lane;
+        EXPECT_EQ(batch.PS[lane], refCpu[lane].PS) << lane;
+    }
+    EXPECT_EQ(batch.PC[0] & 0xFFFC, 0x4004);
+    EXPECT_GT(batch.X[1], 0);
+}
+
+// Runs random programs on a CPUBatch<Lanes> and on separate CPUs, and
+// expects every lane to end up as its CPU does
+template <u32 Lanes>
+static void ExpectRandomProgramsMatchSeparateCpus(u32 numPrograms) {
+    // Lockstep forms of every addressing mode they have, plus a few
+    // instructions that always go through the interpreter
+    const Byte opcodes[] = {
+        0xA9, 0xA2, 0xA0, 0xA5, 0xA6, 0xA4, 0xAD, 0xAE, 0xAC,   // loads
+        0x85, 0x86, 0x84, 0x8D, 0x8E, 0x8C,                     // stores
+        0x29, 0x25, 0x2D, 0x49, 0x45, 0x4D, 0x09, 0x05, 0x0D,   // AND EOR ORA
+        0x24, 0x2C, 0x69, 0x65, 0x6D, 0xE9, 0xE5, 0xED,         // BIT ADC SBC
+        0xC9, 0xC5, 0xCD, 0xE0, 0xE4, 0xEC, 0xC0, 0xC4, 0xCC,   // compares
+        0xAA, 0xA8, 0x8A, 0x98, 0xBA, 0x9A, 0xE8, 0xC8, 0xCA, 0x88,
+        0xE6, 0xEE, 0xC6, 0xCE,                                 // INC DEC
+        0x0A, 0x4A, 0x2A, 0x6A, 0x06, 0x0E, 0x46, 0x4E, 0x26, 0x2E, 0x66, 0x6E,
+        0x18, 0x38, 0xB8, 0xEA,
+        0x10, 0x30, 0x50, 0x70, 0x90, 0xB0, 0xD0, 0xF0,         // branches
+        0xB5, 0x95, 0x48, 0x68, 0x08, 0x28,                     // interpreter only
+    };
+    constexpr s32 CYCLES = 300;
+    std::vector<Mem> mem(Lanes), refMem(Lanes);
+    std::vector<CPU> refCpu(Lanes);
+    auto batch = std::make_unique<CPUBatch<Lanes>>();
+    u32 seed = 6502;
+    auto random = [&seed]() {
+        seed = seed * 1103515245 + 12345;
+        return Byte(seed >> 16);
+    };
+    for (u32 program = 0; program < numPrograms; ++program) {
+        // given: one program at $1000, ending in a jump back to its start;
+        // each lane with its own zero page and registers
+        Byte prog[2 + 64 * 3 + 3] = { 0x00, 0x10 };
+        u32 at = 2;
+        while (at < 2 + 63 * 3) {
+            const Byte opcode = opcodes[random() % sizeof(opcodes)];
+            prog[at++] = opcode;
+            const Byte length = Opcodes[opcode].Length;
+            if (length > 1)
+                prog[at++] = (opcode & 0x1F) == 0x10 ? random() % 8 : random() & 0x3F;
+            if (length > 2)
+                prog[at++] = 0x00;      // absolute operands stay in the zero page
+        }
+        prog[at++] = 0x4C;
+        prog[at++] = 0x00;
+        prog[at++] = 0x10;
+        for (u32 lane = 0; lane < Lanes; ++lane) {
+            CPU cpu;
+            cpu.Reset(0xFF00, mem[lane]);
+            cpu.PC = cpu.LoadProg(prog, at, mem[lane]);
+            for (Word addr = 0; addr < 0x40; ++addr)
+                mem[lane][addr] = random();
+            cpu.A = random();
+            cpu.X = random() & 0x0F;
+            cpu.PS = random() & ~DecimalFlag;
+            batch->Load(lane, cpu, mem[lane]);
+            refMem[lane] = mem[lane];
+            refCpu[lane] = cpu;
+        }
+        // when:
+        batch->Execute(CYCLES);
+        // then:
+        for (u32 lane = 0; lane < Lanes; ++lane) {
+            const ExecuteResult expected = refCpu[lane].Execute(CYCLES, refMem[lane]);
+            if (expected.Reason != StopReason::Budget) {
+                EXPECT_TRUE(batch->Halted[lane]);
+                continue;
+            }
+            const s32 expectedCycles = expected.Cycles;
+            ASSERT_EQ(CYCLES - batch->Cycles[lane], expectedCycles) << "program " << program << " lane " << lane;
+            ASSERT_EQ(batch->PC[lane], refCpu[lane].PC) << "program " << program << " lane " << lane;
+            ASSERT_EQ(batch->SP[lane], refCpu[lane].SP);
+            ASSERT_EQ(batch->A[lane], refCpu[lane].A);
+            ASSERT_EQ(batch->X[lane], refCpu[lane].X);
+            ASSERT_EQ(batch->Y[lane], refCpu[lane].Y);
+            ASSERT_EQ(batch->PS[lane], refCpu[lane].PS) << "program " << program << " lane " << lane;
+            ASSERT_EQ(memcmp(mem[lane].Data, refMem[lane].Data, Mem::MAX_MEM), 0);
+        }
+    }
+    EXPECT_GT(batch->VectorSteps, 0);
+}
+
+TEST_F(CPUBatchTests, RandomProgramsMatchSeparateCpus) {
+    ExpectRandomProgramsMatchSeparateCpus<LANES>(200);
+}
+
+TEST_F(CPUBatchTests, RandomProgramsMatchSeparateCpusInPackedRegisters) {
+    // 32 lanes an AVX2 register or 16 an SSE2 one, and the rest one at a time
+    ExpectRandomProgramsMatchSeparateCpus<packed::Widest::WIDTH + 3>(50);
+}
+
+template <typename V>
+static void ExpectPackedAluMatchesAlu() {
+    for (u32 carry = 0; carry < 2; ++carry) {
+        for (u32 a = 0; a < 256; ++a) {
+            for (u32 base = 0; base < 256; base += V::WIDTH) {
+                // given: a against V::WIDTH operands at once
+                Byte operands[V::WIDTH], sums[V::WIDTH], addFlags[V::WIDTH], compareFlags[V::WIDTH];
+                for (u32 i = 0; i < V::WIDTH; ++i)
+                    operands[i] = Byte(base + i);
+                // when:
+                typename V::Reg flags;
+                V::Store(sums, V::AddWithCarry(V::Splat(a), V::Load(operands), V::Splat(carry), flags));
+                V::Store(addFlags, flags);
+                V::Store(compareFlags, V::CompareFlags(V::Splat(a), V::Load(operands)));
+                // then:
+                for (u32 i = 0; i < V::WIDTH; ++i) {
+                    const AluResult expected = AddArithmetic(a, operands[i], carry);
+                    ASSERT_EQ(sums[i], expected.Result) << a << " + " << +operands[i] << " + " << carry;
+                    ASSERT_EQ(addFlags[i], expected.Flags) << a << " + " << +operands[i] << " + " << carry;
+                    ASSERT_EQ(compareFlags[i], CompareArithmetic(a, operands[i])) << a << " - " << +operands[i];
+                }
+            }
+        }
+    }
+}
+
+TEST_F(CPUBatchTests, PackedAddAndCompareMatchTheAlu) {
+    ExpectPackedAluMatchesAlu<packed::Scalar>();
+#if defined(__SSE2__)
+    ExpectPackedAluMatchesAlu<packed::Sse2>();
+#endif
+#if defined(__AVX2__)
+    ExpectPackedAluMatchesAlu<packed::Avx2>();
+#endif
+}
+
+TEST_F(CPUBatchTests, DecimalAddsLeaveTheGroup) {
+    // given: the same ADC on two lanes with D set and two without
+    Byte prog[] = {
+        0x00, 0x10,
+        0x69, 0x19,         // $1000 ADC #$19
+        0x4C, 0x00, 0x10,   // $1002 JMP $1000
+    };
+    Mem refMem[LANES];
+    CPU refCpu[LANES];
+    for (u32 lane = 0; lane < LANES; ++lane) {
+        Load(lane, prog, sizeof(prog));
+        CPU cpu = batch.Lane(lane);
+        cpu.A = 0x28;
+        cpu.PS = lane < 2 ? DecimalFlag : 0;
+        batch.Load(lane, cpu, mem[lane]);
+        refMem[lane] = mem[lane];
+        refCpu[lane] = cpu;
+    }
+    // when:
+    batch.Execute(2);
+    // then:
+    for (u32 lane = 0; lane < LANES; ++lane) {
+        refCpu[lane].Execute(2, refMem[lane]);
+        EXPECT_EQ(batch.A[lane], refCpu[lane].A) << lane;
+        EXPECT_EQ(batch.PS[lane], refCpu[lane].PS) << lane;
+    }
+    EXPECT_EQ(batch.A[0], 0x47);
+    EXPECT_EQ(batch.A[2], 0x41);
+}
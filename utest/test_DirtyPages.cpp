@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+
+#include <utility>
+#include <vector>
+
+#include "../core/cp6502.hpp"
+#include "../core/dirtypages.hpp"
+#if defined(CP6502_JIT)
+#include "../core/jit.hpp"
+#endif
+
+using namespace cp6502;
+
+struct DirtyPagesTests : public testing::Test {
+    Mem mem;
+    CPU cpu;
+
+    virtual void SetUp() {
+        cpu.Reset(0xFF00, mem);
+    }
+
+    virtual void TearDown() {
+    }
+
+    std::vector<std::pair<u32, u32>> Ranges(DirtyPages const& dirty) {
+        std::vector<std::pair<u32, u32>> ranges;
+        dirty.ForEachDirtyRange([&](u32 address, u32 size) {
+            ranges.emplace_back(address, size);
+        });
+        return ranges;
+    }
+};
+
+TEST_F(DirtyPagesTests, NothingIsDirtyAfterClear) {
+    // given:
+    DirtyPages dirty(mem);
+    // then:
+    EXPECT_TRUE(dirty.Dirty().none());
+    EXPECT_TRUE(Ranges(dirty).empty());
+}
+
+TEST_F(DirtyPagesTests, StoresAndStackWritesMarkTheirPages) {
+    // given:
+    Byte prog[] = {
+        0x00, 0x10,
+        0xA9, 0x42,         // $1000 LDA #$42
+        0x8D, 0x00, 0x30,   // $1002 STA $3000
+        0x8D, 0xFF, 0x30,   // $1005 STA $30FF
+        0x48,               // $1008 PHA
+        0xEE, 0x00, 0x80,   // $1009 INC $8000
+    };
+    cpu.PC = cpu.LoadProg(prog, sizeof(prog), mem);
+    DirtyPages dirty(mem);
+    // when:
+    cpu.Execute(2 + 4 + 4 + 3 + 6, mem);
+    // then:
+    DirtyPages::Bitmap expected;
+    expected[0x01] = expected[0x30] = expected[0x80] = true;
+    EXPECT_EQ(dirty.Dirty(), expected);
+}
+
+TEST_F(DirtyPagesTests, ConsecutivePagesFormOneRange) {
+    // given:
+    DirtyPages dirty(mem);
+    // when:
+    mem[0x2000] = 1;
+    mem[0x21FF] = 1;
+    mem[0xFF00] = 1;
+    // then:
+    const std::vector<std::pair<u32, u32>> expected = { { 0x2000, 0x200 }, { 0xFF00, 0x100 } };
+    EXPECT_EQ(Ranges(dirty), expected);
+}
+
+TEST_F(DirtyPagesTests, ClearingOnePageKeepsTheOthersDirty) {
+    // given:
+    DirtyPages dirty(mem);
+    mem[0x2000] = 1;
+    mem[0x4000] = 1;
+    // when:
+    dirty.Clear(0x20);
+    // then:
+    EXPECT_FALSE(dirty.IsDirty(0x20));
+    EXPECT_TRUE(dirty.IsDirty(0x40));
+    // when:
+    dirty.Clear();
+    // then:
+    EXPECT_TRUE(dirty.Dirty().none());
+}
+
+#if defined(CP6502_JIT)
+TEST_F(DirtyPagesTests, TranslatedStoresMarkTheirPages) {
+    // given:
+    Byte prog[] = {
+        0x00, 0x10,
+        0xA2, 0xC8,         // $1000 LDX #200
+        0x8A,               // $1002 TXA
+        0x9D, 0xFF, 0x20,   // $1003 STA $20FF,X
+        0xCA,               // $1006 DEX
+        0xD0, 0xF9,         // $1007 BNE $1002
+    };
+    cpu.PC = cpu.LoadProg(prog, sizeof(prog), mem);
+    Jit jit;
+    DirtyPages dirty(mem);
+    // when:
+    cpu.Execute(2 + 200 * 12 - 1, mem, jit);
+    // then:
+    DirtyPages::Bitmap expected;
+    expected[0x21] = true;
+    EXPECT_EQ(dirty.Dirty(), expected);
+    EXPECT_GT(jit.Translations, 0);
+}
+#endif
@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+
+#include "../core/cp6502.hpp"
+
+using namespace cp6502;
+
+struct DispatchTests : public testing::Test {
+    Mem mem;
+    CPU cpu;
+
+    // stest/test_code.ms
+    constexpr static s32 NumByteTestProg = 13;
+    Byte TestProg[NumByteTestProg] = { 0x00,0x10,0xA9,0x00,0x18,0x69,0x08,0xC9,0x18,0xD0,0xFA,0xA2,0x14 };
+
+    virtual void SetUp() {
+        cpu.Reset(0xFF00, mem);
+    }
+
+    virtual void TearDown() {
+    }
+
+    template <Dispatch D>
+    void RunsTestProgram() {
+        // given:
+        cpu.PC = cpu.LoadProg(TestProg, NumByteTestProg, mem);
+        constexpr s32 EXPECTED_CYCLES = 26;
+        // when:
+        const s32 actualCycles = cpu.Execute<D>(EXPECTED_CYCLES, mem);
+        // then:
+        EXPECT_EQ(actualCycles, EXPECTED_CYCLES);
+        EXPECT_EQ(cpu.PC, 0x100B);
+        EXPECT_EQ(cpu.A, 24);
+        EXPECT_EQ(cpu.X, 20);
+        EXPECT_TRUE(cpu.C);
+        EXPECT_FALSE(cpu.Z);
+        EXPECT_FALSE(cpu.N);
+    }
+
+    template <Dispatch D>
+    void StopsOnIllegalOpcode() {
+        // given:
+        mem[0xFF00] = 0x03;
+        mem[0xFF01] = 0x02;
+        // when:
+        const ExecuteResult illegal = cpu.Execute<D>(100, mem);
+        const ExecuteResult halt = cpu.Execute<D>(100, mem);
+        // then:
+        EXPECT_EQ(illegal.Reason, StopReason::IllegalOpcode);
+        EXPECT_EQ(illegal.PC, 0xFF01);
+        EXPECT_LE(illegal.Cycles, 1);
+        EXPECT_EQ(halt.Reason, StopReason::Halt);
+        EXPECT_EQ(halt.PC, 0xFF02);
+        EXPECT_EQ(cpu.PC, 0xFF02);
+    }
+};
+
+TEST_F(DispatchTests, SwitchRunsTestProgram) {
+    RunsTestProgram<Dispatch::Switch>();
+}
+
+TEST_F(DispatchTests, TableRunsTestProgram) {
+    RunsTestProgram<Dispatch::Table>();
+}
+
+#if CP6502_HAS_COMPUTED_GOTO
+TEST_F(DispatchTests, ThreadedRunsTestProgram) {
+    RunsTestProgram<Dispatch::Threaded>();
+}
+#endif
+
+TEST_F(DispatchTests, SwitchStopsOnIllegalOpcode) {
+    StopsOnIllegalOpcode<Dispatch::Switch>();
+}
+
+TEST_F(DispatchTests, TableStopsOnIllegalOpcode) {
+    StopsOnIllegalOpcode<Dispatch::Table>();
+}
+
+#if CP6502_HAS_COMPUTED_GOTO
+TEST_F(DispatchTests, ThreadedStopsOnIllegalOpcode) {
+    StopsOnIllegalOpcode<Dispatch::Threaded>();
+}
+#endif
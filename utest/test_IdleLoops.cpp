@@ -0,0 +1,203 @@
+#include <gtest/gtest.h>
+
+#include <new>
+#include <vector>
+
+#include "../core/cp6502.hpp"
+#include "../core/blockcache.hpp"
+#include "../core/bus.hpp"
+#include "../core/scheduler.hpp"
+
+using namespace cp6502;
+
+namespace {
+
+// Answers every read with zero and counts them
+struct StatusDevice : Device {
+    u32 Reads = 0;
+
+    Byte Read(Word address) override {
+        ++Reads;
+        return 0;
+    }
+
+    void Write(Word address, Byte value) override {
+    }
+};
+
+} // namespace
+
+struct IdleLoopsTests : public testing::Test {
+    Mem mem;
+    CPU cpu;
+
+    static constexpr Word Start = 0x0200;
+
+    virtual void SetUp() {
+        cpu.Reset(Start, mem);
+    }
+
+    virtual void TearDown() {
+    }
+
+    void Load(std::vector<Byte> const& code) {
+        Word address = Start;
+        for (Byte value : code)
+            mem[address++] = value;
+    }
+
+    // Runs the program one instruction per Execute, which never skips, on a
+    // copy of mem; returns the cycles used
+    s32 StepCopy(s32 cycles, CPU& stepped, Mem& steppedMem) {
+        stepped = cpu;
+        steppedMem = mem;
+        s32 used = 0;
+        while (used < cycles)
+            used += stepped.Execute(1, steppedMem);
+        return used;
+    }
+
+    void ExpectSameAsStepping(s32 cycles) {
+        static Mem steppedMem;
+        CPU stepped;
+        // when:
+        const s32 expected = StepCopy(cycles, stepped, steppedMem);
+        const s32 actual = cpu.Execute(cycles, mem);
+        // then:
+        EXPECT_EQ(actual, expected);
+        EXPECT_EQ(cpu.PC, stepped.PC);
+        EXPECT_EQ(cpu.A, stepped.A);
+        EXPECT_EQ(cpu.X, stepped.X);
+        EXPECT_EQ(cpu.PS, stepped.PS);
+        EXPECT_EQ(memcmp(mem.Data, steppedMem.Data, Mem::MAX_MEM), 0);
+    }
+};
+
+TEST_F(IdleLoopsTests, JumpToSelfSkipsToTheEndOfTheBudget) {
+    // given:
+    Load({ CPU::INS_JMP_ABS, Start & 0xFF, Start >> 8 });
+    // when/then:
+    ExpectSameAsStepping(100000);
+    EXPECT_GT(cpu.IdleCyclesSkipped, 99000u);
+}
+
+TEST_F(IdleLoopsTests, PollingLoopSkipsToTheEndOfTheBudget) {
+    // given:
+    Load({ CPU::INS_LDA_ZP, 0x10, CPU::INS_BEQ, Byte(-4) });
+    // when/then:
+    ExpectSameAsStepping(100001);
+    EXPECT_GT(cpu.IdleCyclesSkipped, 99000u);
+}
+
+TEST_F(IdleLoopsTests, CountingLoopRunsEveryTrip) {
+    // given:
+    Load({ CPU::INS_LDX_IM, 0x00, CPU::INS_DEX, CPU::INS_BNE, Byte(-3), CPU::INS_INC_ZP, 0x10,
+           CPU::INS_JMP_ABS, Start & 0xFF, Start >> 8 });
+    // when/then:
+    ExpectSameAsStepping(50000);
+    EXPECT_EQ(cpu.IdleCyclesSkipped, 0u);
+}
+
+TEST_F(IdleLoopsTests, LoopThatWritesRunsEveryTrip) {
+    // given:
+    Load({ CPU::INS_STA_ZP, 0x10, CPU::INS_JMP_ABS, Start & 0xFF, Start >> 8 });
+    // when/then:
+    ExpectSameAsStepping(10000);
+    EXPECT_EQ(cpu.IdleCyclesSkipped, 0u);
+}
+
+TEST_F(IdleLoopsTests, PollingLoopWakesForAScheduledWrite) {
+    // given:
+    Load({ CPU::INS_LDA_ZP, 0x10, CPU::INS_BEQ, Byte(-4),
+           CPU::INS_INC_ZP, 0x11, CPU::INS_LDA_IM, 0x00, CPU::INS_STA_ZP, 0x10,
+           CPU::INS_JMP_ABS, Start & 0xFF, Start >> 8 });
+    Scheduler scheduler;
+    scheduler.Every(1000, [&](u64) { mem[0x10] = 1; });
+    // when:
+    cpu.Execute(100000, mem, scheduler);
+    // then:
+    EXPECT_EQ(mem[0x11], 99);
+    EXPECT_GT(cpu.IdleCyclesSkipped, 90000u);
+}
+
+TEST_F(IdleLoopsTests, ACPUNeverResetStartsWithNoLoopSeen) {
+    // given: a CPU built over leftover bytes, as in a JobRunner job
+    alignas(CPU) Byte storage[sizeof(CPU)];
+    memset(storage, 0xFF, sizeof(storage));
+    CPU* fresh = new (storage) CPU;
+    // then:
+    EXPECT_EQ(fresh->IdleCyclesSkipped, 0u);
+    EXPECT_FALSE(fresh->Idle.Candidate);
+    EXPECT_FALSE(fresh->Idle.Armed);
+    EXPECT_EQ(fresh->Idle.Start, 0);
+    EXPECT_EQ(fresh->Idle.End, 0);
+}
+
+TEST_F(IdleLoopsTests, BlockCacheSkipsTooLikeTheInterpreter) {
+    // given:
+    Load({ CPU::INS_LDA_ZP, 0x10, CPU::INS_BEQ, Byte(-4) });
+    BlockCache cache;
+    CPU stepped = cpu;
+    // when:
+    const s32 cyclesUsed = cpu.Execute(100001, mem, cache);
+    // then:
+    EXPECT_EQ(cyclesUsed, stepped.Execute(100001, mem));
+    EXPECT_EQ(cpu.PC, stepped.PC);
+    EXPECT_GT(cpu.IdleCyclesSkipped, 99000u);
+}
+
+TEST_F(IdleLoopsTests, LoopReadingADeviceRunsEveryTrip) {
+    // given:
+    Byte ram[Bus::PAGE_SIZE * 4] = {};
+    Bus bus;
+    bus.MapRam(0x00, 4, ram);
+    StatusDevice device;
+    bus.MapDevice(0xD0, 1, device);
+    BasicCPU<Bus> busCpu;
+    busCpu.Reset(Start);
+    const Byte code[] = { CPU::INS_LDA_ABS, 0x00, 0xD0, CPU::INS_BEQ, Byte(-5) };
+    memcpy(&ram[Start], code, sizeof(code));
+    // when:
+    const s32 cyclesUsed = busCpu.Execute(7000, bus);
+    // then:
+    EXPECT_EQ(cyclesUsed, 7000);
+    EXPECT_EQ(device.Reads, 1000u);
+    EXPECT_EQ(busCpu.IdleCyclesSkipped, 0u);
+}
+
+TEST_F(IdleLoopsTests, LoopReadingBusRamIsSkipped) {
+    // given: a loop polling RAM on a bus that also has a device
+    Byte ram[Bus::PAGE_SIZE * 4] = {};
+    Bus bus;
+    bus.MapRam(0x00, 4, ram);
+    StatusDevice device;
+    bus.MapDevice(0xD0, 1, device);
+    BasicCPU<Bus> busCpu;
+    busCpu.Reset(Start);
+    const Byte code[] = { CPU::INS_LDA_ABS, 0x00, 0x03, CPU::INS_LDX_ZP, 0x10, CPU::INS_BEQ, Byte(-7) };
+    memcpy(&ram[Start], code, sizeof(code));
+    // when:
+    const s32 cyclesUsed = busCpu.Execute(9000, bus);
+    // then:
+    EXPECT_EQ(cyclesUsed, 9000);
+    EXPECT_EQ(busCpu.PC, Start);
+    EXPECT_GT(busCpu.IdleCyclesSkipped, 8000u);
+    EXPECT_EQ(device.Reads, 0u);
+}
+
+TEST_F(IdleLoopsTests, LoopIndexingIntoADevicePageRunsEveryTrip) {
+    // given: $CFF0,X can reach the device page at $D000
+    Byte ram[Bus::PAGE_SIZE * 4] = {};
+    Bus bus;
+    bus.MapRam(0x00, 4, ram);
+    StatusDevice device;
+    bus.MapDevice(0xD0, 1, device);
+    BasicCPU<Bus> busCpu;
+    busCpu.Reset(Start);
+    const Byte code[] = { CPU::INS_LDA_ABSX, 0xF0, 0xCF, CPU::INS_BEQ, Byte(-5) };
+    memcpy(&ram[Start], code, sizeof(code));
+    // when:
+    busCpu.Execute(7000, bus);
+    // then:
+    EXPECT_EQ(busCpu.IdleCyclesSkipped, 0u);
+}
@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+
+#include "../core/cp6502.hpp"
+#include "../core/jit.hpp"
+
+using namespace cp6502;
+
+struct JitTests : public testing::Test {
+    Mem mem;
+    CPU cpu;
+    Jit jit;
+
+    Mem refMem;
+    CPU refCpu;
+
+    virtual void SetUp() {
+        cpu.Reset(0xFF00, mem);
+    }
+
+    virtual void TearDown() {
+    }
+
+    void Load(Byte* prog, u32 numBytes) {
+        cpu.PC = cpu.LoadProg(prog, numBytes, mem);
+        refMem = mem;
+        refCpu = cpu;
+    }
+
+    // Runs the same budget through the interpreter and expects the same state
+    void ExpectSameAsInterpreter(s32 cycles) {
+        const s32 actualCycles = cpu.Execute(cycles, mem, jit);
+        const s32 expectedCycles = refCpu.Execute(cycles, refMem);
+        EXPECT_EQ(actualCycles, expectedCycles);
+        EXPECT_EQ(cpu.PC, refCpu.PC);
+        EXPECT_EQ(cpu.SP, refCpu.SP);
+        EXPECT_EQ(cpu.A, refCpu.A);
+        EXPECT_EQ(cpu.X, refCpu.X);
+        EXPECT_EQ(cpu.Y, refCpu.Y);
+        EXPECT_EQ(cpu.PS, refCpu.PS);
+        EXPECT_EQ(memcmp(mem.Data, refMem.Data, Mem::MAX_MEM), 0);
+    }
+};
+
+TEST_F(JitTests, HotLoopRunsLikeTheInterpreter) {
+    // given:
+    Byte prog[] = {
+        0x00, 0x10,
+        0xA9, 0x00,         // $1000 LDA #0
+        0xA2, 0xC8,         // $1002 LDX #200
+        0x18,               // $1004 CLC
+        0x69, 0x03,         // $1005 ADC #3
+        0x9D, 0xFF, 0x20,   // $1007 STA $20FF,X
+        0xCA,               // $100A DEX
+        0xD0, 0xF7,         // $100B BNE $1004
+        0xA0, 0x07,         // $100D LDY #7
+    };
+    Load(prog, sizeof(prog));
+    // when/then:
+    ExpectSameAsInterpreter(2805);
+    EXPECT_EQ(cpu.PC, 0x100F);
+    EXPECT_EQ(cpu.Y, 7);
+    EXPECT_GT(jit.Translations, 0);
+}
+
+TEST_F(JitTests, StopsOnTheSameInstructionAsTheInterpreter) {
+    // given:
+    Byte prog[] = {
+        0x00, 0x10,
+        0xA2, 0x00,         // $1000 LDX #0
+        0xE8,               // $1002 INX
+        0xBD, 0xF0, 0x20,   // $1003 LDA $20F0,X
+        0x4A,               // $1006 LSR
+        0x26, 0x80,         // $1007 ROL $80
+        0x4C, 0x02, 0x10,   // $1009 JMP $1002
+    };
+    for (s32 cycles = 1; cycles < 600; cycles += 7) {
+        SetUp();
+        mem.Initialise();
+        jit.Flush();
+        Load(prog, sizeof(prog));
+        // when/then:
+        ExpectSameAsInterpreter(cycles);
+    }
+}
+
+TEST_F(JitTests, StoreIntoTheCodePageEndsTheBlock) {
+    // given:
+    Byte prog[] = {
+        0x00, 0x10,
+        0xA2, 0x00,         // $1000 LDX #0
+        0xE8,               // $1002 INX
+        0x8A,               // $1003 TXA
+        0x9D, 0xE0, 0x0F,   // $1004 STA $0FE0,X
+        0xE0, 0x21,         // $1007 CPX #$21
+        0xD0, 0xF7,         // $1009 BNE $1002
+        0xA0, 0x07,         // $100B LDY #7
+    };
+    Load(prog, sizeof(prog));
+    // when/then:
+    ExpectSameAsInterpreter(465);
+    EXPECT_EQ(cpu.PC, 0x100D);
+    EXPECT_EQ(mem[0x1000], 0x20);
+    EXPECT_EQ(mem[0x1001], 0x21);
+    EXPECT_GT(jit.Translations, 0);
+}
+
+TEST_F(JitTests, PatchedCodeIsTranslatedAgain) {
+    // given:
+    Byte prog[] = {
+        0x00, 0x10,
+        0x69, 0x01,         // $1000 ADC #1
+        0x4C, 0x00, 0x10,   // $1002 JMP $1000
+    };
+    Load(prog, sizeof(prog));
+    ExpectSameAsInterpreter(500);
+    EXPECT_EQ(jit.Translations, 1);
+    // when:
+    mem[0x1001] = refMem[0x1001] = 0x10;
+    // then:
+    ExpectSameAsInterpreter(500);
+    EXPECT_EQ(jit.Translations, 2);
+}
+
+TEST_F(JitTests, TranslatedBlockDeclinesInDecimalMode) {
+    // given:
+    Byte prog[] = {
+        0x00, 0x10,
+        0x69, 0x01,         // $1000 ADC #1
+        0x4C, 0x00, 0x10,   // $1002 JMP $1000
+    };
+    Load(prog, sizeof(prog));
+    cpu.Execute(Jit::HOT_THRESHOLD * 5, mem, jit);
+    BlockCache::Block const& block = jit.Cache.Lookup(0x1000, mem);
+    ASSERT_NE(block.Native, nullptr);
+    const auto native = reinterpret_cast<Jit::NativeBlock>(block.Native);
+    cpu.PC = 0x1000;
+    cpu.D = 1;
+    CPU cpuCopy = cpu;
+    // when:
+    const s32 actualCycles = native(&cpu, &mem, 1000, jit.Entries.data());
+    // then:
+    EXPECT_EQ(actualCycles, 0);
+    EXPECT_EQ(cpu.A, cpuCopy.A);
+    EXPECT_EQ(cpu.PS, cpuCopy.PS);
+    EXPECT_EQ(cpu.PC, 0x1000);
+}
+
+TEST_F(JitTests, TranslatesPushesOutsideTheStackPage) {
+    // given: a block on page 2, just past the stack
+    Byte prog[] = {
+        0x00, 0x02,
+        0xE8,               // $0200 INX
+        0x8A,               // $0201 TXA
+        0x48,               // $0202 PHA
+        0x68,               // $0203 PLA
+        0x4C, 0x00, 0x02,   // $0204 JMP $0200
+    };
+    Load(prog, sizeof(prog));
+    // when/then:
+    ExpectSameAsInterpreter(2000);
+    EXPECT_GT(jit.Translations, 0);
+}
+
+TEST_F(JitTests, PassesFunctionalTest) {
+    // given:
+    cpu.Reset(0x0400, mem);
+    FILE* fp = fopen(CP6502_STEST_DIR "/6502_functional_test.bin", "rb");
+    ASSERT_NE(fp, nullptr);
+    const size_t size = Mem::MAX_MEM - 0x000A;
+    ASSERT_EQ(fread(&mem[0x000A], 1, size, fp), size);
+    fclose(fp);
+    constexpr s32 EXPECTED_CYCLES = 84032391;    // to the success trap, as the interpreter counts
+    // when:
+    cpu.Execute(EXPECTED_CYCLES, mem, jit);
+    // then:
+    EXPECT_EQ(cpu.PC, 0x3699);
+    EXPECT_GT(jit.Translations, 0);
+}
@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+
+#include "../core/cp6502.hpp"
+#include "../core/jobrunner.hpp"
+
+using namespace cp6502;
+
+struct JobRunnerTests : public testing::Test {
+    virtual void SetUp() {
+    }
+
+    virtual void TearDown() {
+    }
+
+    // Adds a and b into $12, then counts X up from the sum
+    JobRunner::Job SumJob(Byte a, Byte b, s32 cycles) {
+        JobRunner::Job job;
+        job.Image = {
+            0x00, 0x10,
+            0xA9, a,            // $1000 LDA #a
+            0x18,               // $1002 CLC
+            0x69, b,            // $1003 ADC #b
+            0x85, 0x12,         // $1005 STA $12
+            0xAA,               // $1007 TAX
+            0xE8,               // $1008 INX
+            0x4C, 0x08, 0x10,   // $1009 JMP $1008
+        };
+        job.Cpu.PC = 0x1000;
+        job.Cpu.SP = 0xFF;
+        job.Cycles = cycles;
+        return job;
+    }
+};
+
+TEST_F(JobRunnerTests, JobsMatchSeparateCpus) {
+    // given:
+    std::vector<JobRunner::Job> jobs;
+    for (u32 i = 0; i < 200; ++i)
+        jobs.push_back(SumJob(i, i * 7, 15 + i * 3));
+    std::vector<Byte> sums(jobs.size());
+    JobRunner runner(4);
+    // when:
+    std::vector<JobRunner::Result> results = runner.Run(jobs, [&sums](u32 job, JobRunner::Result const&, Mem const& memory) {
+        sums[job] = memory[0x12];
+    });
+    // then:
+    ASSERT_EQ(results.size(), jobs.size());
+    for (u32 i = 0; i < jobs.size(); ++i) {
+        Mem mem;
+        mem.Initialise();
+        CPU cpu = jobs[i].Cpu;
+        cpu.LoadProg(jobs[i].Image.data(), jobs[i].Image.size(), mem);
+        const s32 expectedCycles = cpu.Execute(jobs[i].Cycles, mem);
+        EXPECT_EQ(results[i].Cycles, expectedCycles);
+        EXPECT_EQ(results[i].Cpu.PC, cpu.PC);
+        EXPECT_EQ(results[i].Cpu.A, cpu.A);
+        EXPECT_EQ(results[i].Cpu.X, cpu.X);
+        EXPECT_EQ(results[i].Cpu.PS, cpu.PS);
+        EXPECT_FALSE(results[i].Halted);
+        EXPECT_EQ(sums[i], Byte(i + i * 7));
+    }
+    EXPECT_EQ(runner.NumThreads(), 4);
+}
+
+TEST_F(JobRunnerTests, JobsStartFromClearedMemory) {
+    // given: one worker, so the second job reuses the first one's Mem
+    JobRunner::Job store;
+    store.Image = {
+        0x00, 0x20,
+        0xA9, 0x55,         // $2000 LDA #$55
+        0x8D, 0x00, 0x30,   // $2002 STA $3000
+    };
+    store.Cpu.PC = 0x2000;
+    store.Cycles = 2 + 4;
+    JobRunner::Job load;
+    load.Image = {
+        0x00, 0x10,
+        0xA9, 0x01,         // $1000 LDA #1
+        0xAD, 0x00, 0x30,   // $1002 LDA $3000
+        0xAE, 0x01, 0x20,   // $1005 LDX $2001
+    };
+    load.Cpu.PC = 0x1000;
+    load.Cycles = 2 + 4 + 4;
+    JobRunner runner(1);
+    // when:
+    std::vector<JobRunner::Result> results = runner.Run({ store, load });
+    // then:
+    EXPECT_EQ(results[1].Cpu.A, 0);
+    EXPECT_EQ(results[1].Cpu.X, 0);
+    EXPECT_TRUE(results[1].Cpu.PS & ZeroFlag);
+}
+
+TEST_F(JobRunnerTests, OpcodeWithoutHandlerHaltsOnlyItsJob) {
+    // given:
+    JobRunner::Job illegal;
+    illegal.Image = {
+        0x00, 0x30,
+        0xA9, 0x07,         // $3000 LDA #7
+        0x02,               // $3002 no handler
+    };
+    illegal.Cpu.PC = 0x3000;
+    illegal.Cycles = 100;
+    JobRunner runner(2);
+    // when:
+    std::vector<JobRunner::Result> results = runner.Run({ illegal, SumJob(1, 2, 100) });
+    // then:
+    EXPECT_TRUE(results[0].Halted);
+    EXPECT_EQ(results[0].Cpu.A, 7);
+    EXPECT_EQ(results[0].Cpu.PC, 0x3003);
+    EXPECT_FALSE(results[1].Halted);
+    EXPECT_GE(results[1].Cycles, 100);
+}
+
+TEST_F(JobRunnerTests, IdleWorkersStealQueuedJobs) {
+    // given: the first job to finish holds its worker until every other job
+    // has run, so the other worker must take jobs dealt to the held one
+    constexpr u32 NUM_JOBS = 16;
+    std::vector<JobRunner::Job> jobs;
+    for (u32 i = 0; i < NUM_JOBS; ++i)
+        jobs.push_back(SumJob(i, 1, 50));
+    std::mutex lock;
+    std::condition_variable othersDone;
+    u32 finished = 0;
+    bool holding = false;
+    JobRunner runner(2);
+    // when:
+    std::vector<JobRunner::Result> results = runner.Run(jobs, [&](u32, JobRunner::Result const&, Mem const&) {
+        std::unique_lock<std::mutex> guard(lock);
+        ++finished;
+        if (!holding) {
+            holding = true;
+            othersDone.wait(guard, [&] { return finished == NUM_JOBS; });
+        } else if (finished == NUM_JOBS) {
+            othersDone.notify_one();
+        }
+    });
+    // then:
+    EXPECT_EQ(finished, NUM_JOBS);
+    EXPECT_GE(runner.Steals, NUM_JOBS / 2 - 1);
+    for (u32 i = 0; i < NUM_JOBS; ++i)
+        EXPECT_GE(results[i].Cycles, 50);
+}
+
+TEST_F(JobRunnerTests, FinishExceptionsReachTheCaller) {
+    // given:
+    std::vector<JobRunner::Job> jobs = { SumJob(1, 2, 10), SumJob(3, 4, 10) };
+    JobRunner runner(2);
+    // when/then:
+    EXPECT_THROW(runner.Run(jobs, [](u32 job, JobRunner::Result const&, Mem const&) {
+        if (job == 1)
+            throw std::runtime_error("finish failed");
+    }), std::runtime_error);
+    // and the runner can be used again
+    EXPECT_EQ(runner.Run(jobs).size(), 2);
+}
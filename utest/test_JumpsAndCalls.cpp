@@ -100,3 +100,17 @@ TEST_F(JumpsAndCallsTests, JumpIndirectCanJumpToNewLocation) {
     EXPECT_EQ(cpu.PS, cpuCopy.PS);
     EXPECT_EQ(cpu.SP, cpuCopy.SP);
 }
+
+TEST_F(JumpsAndCallsTests, JumpToItselfStopsExecuteWhenItIsATrap) {
+    // given:
+    cpu.StopOnTrap = true;
+    mem[0xFF00] = CPU::INS_JMP_ABS;
+    mem[0xFF01] = 0x00;
+    mem[0xFF02] = 0xFF;
+    // when:
+    const ExecuteResult result = cpu.Execute(100, mem);
+    // then:
+    EXPECT_EQ(result.Reason, StopReason::Trap);
+    EXPECT_EQ(result.Cycles, 3);
+    EXPECT_EQ(result.PC, 0xFF00);
+}
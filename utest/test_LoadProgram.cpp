@@ -47,22 +47,19 @@ TEST_F(LoadProgramTests, TestLoadProgramAndExecute) {
     EXPECT_EQ(cpu.A, 0xFF);
 }
 
-/*
-TEST_F(LoadProgramTests, LoadFunctionalTest65) {
-    FILE *fp = fopen("/home/zhjun/Work/cp6502/stest/6502_functional_test.bin", "r");
-    fread(&mem[0x000A], 1, 65526, fp);
+TEST_F(LoadProgramTests, FunctionalTestStopsAtItsSuccessTrap) {
+    // given:
+    FILE* fp = fopen(CP6502_STEST_DIR "/6502_functional_test.bin", "rb");
+    ASSERT_NE(fp, nullptr);
+    const size_t size = Mem::MAX_MEM - 0x000A;
+    ASSERT_EQ(fread(&mem[0x000A], 1, size, fp), size);
     fclose(fp);
-    // Word StartAddress = 
     cpu.PC = 0x400;
-    //then:
-    try {
-        while (true) {
-            cpu.Execute(1, mem);
-            // printf("0x%x ", cpu.PC);
-        }
-    }
-    catch (...) {
-        printf("Unknown exception in functional test\n");
-    }
+    cpu.StopOnTrap = true;
+    // when:
+    const ExecuteResult result = cpu.Execute(100000000, mem);
+    // then:
+    EXPECT_EQ(result.Reason, StopReason::Trap);
+    EXPECT_EQ(result.PC, 0x3699);
+    EXPECT_LT(result.Cycles, 100000000);
 }
-*/
@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+
+#include "../core/cp6502.hpp"
+#include "../core/mapper.hpp"
+
+using namespace cp6502;
+
+struct MapperTests : public testing::Test {
+    static constexpr u32 WINDOW = 16 * 1024;
+    static constexpr u32 ROM_BANKS = 64;    // 1 MB
+    static constexpr u32 RAM_BANKS = 4;
+    Bus bus;
+    Byte ram[WINDOW];
+    Mapper mapper{ bus, WINDOW, ROM_BANKS * WINDOW, RAM_BANKS * WINDOW };
+    BasicCPU<Bus> cpu;
+
+    virtual void SetUp() {
+        // $0000-$3FFF fixed RAM, $8000-$BFFF banked RAM, $C000-$FFFF banked ROM,
+        // bank registers at $4000
+        bus.MapRam(0x00, WINDOW / Bus::PAGE_SIZE, ram);
+        bus.MapDevice(0x40, 1, mapper);
+        for (u32 bank = 0; bank < ROM_BANKS; ++bank)
+            mapper.Rom[bank * WINDOW] = bank;
+        mapper.SelectRam(2, 0);
+        mapper.SelectRom(3, 0);
+        cpu.Reset(0x1000, bus);
+    }
+
+    virtual void TearDown() {
+    }
+};
+
+TEST_F(MapperTests, RejectsOtherWindowSizes) {
+    EXPECT_THROW(Mapper(bus, 2 * 1024, 0, 0), std::invalid_argument);
+    EXPECT_THROW(Mapper(bus, 8 * 1024, 3 * 1024, 0), std::invalid_argument);
+}
+
+TEST_F(MapperTests, SelectingARomBankShowsItInTheWindow) {
+    // when:
+    mapper.SelectRom(3, 42);
+    // then:
+    EXPECT_EQ(bus.Read(0xC000), 42);
+    EXPECT_EQ(bus.ReadPages[0xFF], &mapper.Rom[42 * WINDOW + WINDOW - Bus::PAGE_SIZE]);
+}
+
+TEST_F(MapperTests, RamBanksKeepTheirContents) {
+    // given:
+    bus.Write(0x8010, 0x11);
+    mapper.SelectRam(2, 1);
+    bus.Write(0x8010, 0x22);
+    // when:
+    mapper.SelectRam(2, 0);
+    // then:
+    EXPECT_EQ(bus.Read(0x8010), 0x11);
+    EXPECT_EQ(mapper.Ram[WINDOW + 0x10], 0x22);
+}
+
+TEST_F(MapperTests, BankNumbersWrap) {
+    // when:
+    mapper.SelectRom(3, ROM_BANKS + 5);
+    // then:
+    EXPECT_EQ(bus.Read(0xC000), 5);
+    EXPECT_EQ(mapper.Read(0x4003), 5);
+}
+
+TEST_F(MapperTests, ProgramSwitchesBanksThroughTheRegisters) {
+    // given:
+    Byte prog[] = {
+        0x00, 0x10,
+        0xA9, 0x07,         // $1000 LDA #7
+        0x8D, 0x03, 0x40,   // $1002 STA $4003  ROM bank 7 at $C000
+        0xAE, 0x00, 0xC0,   // $1005 LDX $C000
+        0xA9, 0x02,         // $1008 LDA #2
+        0x8D, 0x06, 0x40,   // $100A STA $4006  RAM bank 2 at $8000
+        0x8E, 0x00, 0x80,   // $100D STX $8000
+    };
+    cpu.PC = cpu.LoadProg(prog, sizeof(prog), bus);
+    // when:
+    cpu.Execute(2 + 4 + 4 + 2 + 4 + 4, bus);
+    // then:
+    EXPECT_EQ(cpu.X, 7);
+    EXPECT_EQ(mapper.Ram[2 * WINDOW], 7);
+    EXPECT_EQ(mapper.Read(0x4006), 2);
+}
+
+TEST_F(MapperTests, BankingTheRegisterWindowKeepsTheRegisters) {
+    // given: the registers at $4000 are in window 1
+    mapper.Rom[5 * WINDOW + Bus::PAGE_SIZE] = 0x55;
+    // when:
+    bus.Write(0x4001, 5);
+    // then: the rest of the window shows the bank, and it can be switched back
+    EXPECT_EQ(bus.Read(0x4100), 0x55);
+    EXPECT_EQ(bus.Read(0x4001), 5);
+    bus.Write(0x4005, 1);
+    EXPECT_EQ(bus.Read(0x4001), 1);
+    EXPECT_EQ(bus.WritePages[0x41], &mapper.Ram[WINDOW + Bus::PAGE_SIZE]);
+}
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+
+#include <string.h>
+
+#include "../core/cp6502.hpp"
+
+using namespace cp6502;
+
+struct MemTests : public testing::Test {
+    Mem mem;
+    CPU cpu;
+
+    virtual void SetUp() {
+        cpu.Reset(0xFF00, mem);
+    }
+
+    virtual void TearDown() {
+    }
+};
+
+TEST_F(MemTests, InitialiseZeroesEveryByte) {
+    // given:
+    Mem fresh;
+    for (u32 i = 0; i < Mem::MAX_MEM; ++i)
+        fresh.Data[i] = 0xA5;      // as if left over in the allocation
+    // when:
+    fresh.Initialise();
+    // then:
+    for (u32 i = 0; i < Mem::MAX_MEM; ++i)
+        ASSERT_EQ(fresh[i], 0) << i;
+}
+
+TEST_F(MemTests, InitialiseClearsOnlyWrittenPages) {
+    // given:
+    mem[0x1234] = 0x42;
+    mem.Write(0x80FF, 0x43);
+    u32 generations[Mem::NUM_PAGES];
+    for (u32 page = 0; page < Mem::NUM_PAGES; ++page)
+        generations[page] = mem.WriteGeneration[page];
+    // when:
+    mem.Initialise();
+    // then:
+    EXPECT_EQ(mem.Read(0x1234), 0);
+    EXPECT_EQ(mem.Read(0x80FF), 0);
+    for (u32 page = 0; page < Mem::NUM_PAGES; ++page) {
+        if (page == 0x12 || page == 0x80)
+            EXPECT_NE(mem.WriteGeneration[page], generations[page]);
+        else
+            EXPECT_EQ(mem.WriteGeneration[page], generations[page]) << page;
+        EXPECT_TRUE(mem.IsZeroed(page));
+    }
+}
+
+TEST_F(MemTests, InitialiseClearsWritesThatBypassedWriteGeneration) {
+    // given: written through Data and through a pointer, as fread and
+    // Bus::MapRam do
+    memset(mem.Data, 0x5A, Mem::MAX_MEM / 2);
+    Byte* raw = &mem[0x8000];
+    memset(raw, 0xA5, Mem::MAX_MEM / 2);
+    // when:
+    mem.Initialise();
+    // then:
+    for (u32 i = 0; i < Mem::MAX_MEM; ++i)
+        ASSERT_EQ(mem[i], 0) << i;
+}
+
+TEST_F(MemTests, CopiesAreNotTakenAsZeroed) {
+    // given:
+    Mem other;
+    other.Initialise();
+    other[0x2000] = 0x99;
+    // when:
+    mem = other;
+    mem.Initialise();
+    // then:
+    EXPECT_EQ(mem[0x2000], 0);
+}
+
+TEST_F(MemTests, ResetWithoutMemoryKeepsIt) {
+    // given:
+    mem[0x3000] = 0x77;
+    cpu.A = 5;
+    cpu.SP = 0x80;
+    // when:
+    cpu.Reset(0x4000);
+    // then:
+    EXPECT_EQ(mem[0x3000], 0x77);
+    EXPECT_EQ(cpu.PC, 0x4000);
+    EXPECT_EQ(cpu.SP, 0xFF);
+    EXPECT_EQ(cpu.A, 0);
+}
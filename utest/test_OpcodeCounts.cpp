@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "../core/cp6502.hpp"
+#include "../core/blockcache.hpp"
+#include "../core/opcodes.hpp"
+
+using namespace cp6502;
+
+struct OpcodeCountsTests : public testing::Test {
+    Mem mem;
+    CPU cpu;
+
+    static constexpr Word Start = 0x0200;
+
+    virtual void SetUp() {
+        cpu.Reset(Start, mem);
+    }
+
+    virtual void TearDown() {
+    }
+
+    void Load(Word address, std::vector<Byte> const& code) {
+        for (Byte value : code)
+            mem[address++] = value;
+    }
+
+    // LDX #5; loop: DEX; BNE loop: 1 LDX, 5 DEX, 4 branches taken and 1 not
+    void LoadCountdown() {
+        Load(Start, { CPU::INS_LDX_IM, 0x05, CPU::INS_DEX, CPU::INS_BNE, Byte(-3) });
+    }
+    static constexpr s32 CountdownCycles = 2 + 5 * 2 + 4 * 3 + 2;
+};
+
+TEST_F(OpcodeCountsTests, SumsInstructionsByAddressingMode) {
+    // given:
+    OpcodeCounts counts;
+    counts.Executed[CPU::INS_LDA_IM] = 3;
+    counts.Executed[CPU::INS_LDX_IM] = 2;
+    counts.Executed[CPU::INS_LDA_ABS] = 5;
+    counts.Executed[0xFF] = 7;
+    // then:
+    EXPECT_EQ(counts.Instructions(), 17u);
+    EXPECT_EQ(counts.InMode(AddrMode::Immediate), 5u);
+    EXPECT_EQ(counts.InMode(AddrMode::Absolute), 5u);
+    EXPECT_EQ(counts.InMode(AddrMode::Relative), 0u);
+}
+
+#if defined(CP6502_OPCODE_COUNTS)
+TEST_F(OpcodeCountsTests, CountsEachOpcodeRun) {
+    // given:
+    LoadCountdown();
+    // when:
+    cpu.Execute(CountdownCycles, mem);
+    // then:
+    EXPECT_EQ(cpu.Counts.Executed[CPU::INS_LDX_IM], 1u);
+    EXPECT_EQ(cpu.Counts.Executed[CPU::INS_DEX], 5u);
+    EXPECT_EQ(cpu.Counts.Executed[CPU::INS_BNE], 5u);
+    EXPECT_EQ(cpu.Counts.Instructions(), 11u);
+    EXPECT_EQ(cpu.Counts.InMode(AddrMode::Implied), 5u);
+    EXPECT_EQ(cpu.Counts.BranchesTaken, 4u);
+    EXPECT_EQ(cpu.Counts.BranchesNotTaken, 1u);
+    EXPECT_EQ(cpu.Counts.BranchPageCrosses, 0u);
+}
+
+TEST_F(OpcodeCountsTests, CountsTheSameThroughEveryDispatch) {
+    // given:
+    LoadCountdown();
+    cpu.Execute<Dispatch::Switch>(CountdownCycles, mem);
+    const OpcodeCounts bySwitch = cpu.Counts;
+    // when:
+    cpu.Reset(Start);
+    cpu.Execute<Dispatch::Table>(CountdownCycles, mem);
+    // then:
+    EXPECT_EQ(cpu.Counts.Executed, bySwitch.Executed);
+#if CP6502_HAS_COMPUTED_GOTO
+    cpu.Reset(Start);
+    cpu.Execute<Dispatch::Threaded>(CountdownCycles, mem);
+    EXPECT_EQ(cpu.Counts.Executed, bySwitch.Executed);
+#endif
+    cpu.Reset(Start);
+    BlockCache cache;
+    cpu.Execute(CountdownCycles, mem, cache);
+    EXPECT_EQ(cpu.Counts.Executed, bySwitch.Executed);
+    EXPECT_EQ(cpu.Counts.BranchesTaken, 4u);
+}
+
+TEST_F(OpcodeCountsTests, CountsPageCrosses) {
+    // given: LDA $02FF,X with X = 1, then LDA ($10),Y from $0300 with Y = 1
+    mem[0x0010] = 0x00;
+    mem[0x0011] = 0x03;
+    Load(Start, { CPU::INS_LDX_IM, 0x01, CPU::INS_LDA_ABSX, 0xFF, 0x02, CPU::INS_LDY_IM, 0x01,
+                  CPU::INS_LDA_INDY, 0x10 });
+    // when:
+    cpu.Execute(2 + 5 + 2 + 5, mem);
+    // then: only the first crosses
+    EXPECT_EQ(cpu.Counts.PageCrosses, 1u);
+}
+
+TEST_F(OpcodeCountsTests, CountsBranchesToAnotherPage) {
+    // given: BEQ at $02F0 to $0302
+    cpu.Reset(0x02F0);
+    Load(0x02F0, { CPU::INS_BEQ, 0x10 });
+    cpu.Z = 1;
+    // when:
+    cpu.Execute(4, mem);
+    // then:
+    EXPECT_EQ(cpu.PC, 0x0302);
+    EXPECT_EQ(cpu.Counts.BranchesTaken, 1u);
+    EXPECT_EQ(cpu.Counts.BranchPageCrosses, 1u);
+}
+
+TEST_F(OpcodeCountsTests, ClearCountsAndResetStartOver) {
+    // given:
+    LoadCountdown();
+    cpu.Execute(CountdownCycles, mem);
+    // when:
+    cpu.ClearCounts();
+    // then:
+    EXPECT_EQ(cpu.Counts.Instructions(), 0u);
+    EXPECT_EQ(cpu.Counts.BranchesTaken, 0u);
+
+    cpu.Execute(2, mem);
+    EXPECT_EQ(cpu.Counts.Instructions(), 1u);
+    cpu.Reset(Start);
+    EXPECT_EQ(cpu.Counts.Instructions(), 0u);
+}
+#endif
@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include "../core/cp6502.hpp"
+#include "../core/opcodes.hpp"
+
+using namespace cp6502;
+
+struct OpcodesTests : public testing::Test {
+    Mem mem;
+    CPU cpu;
+
+    virtual void SetUp() {
+    }
+
+    virtual void TearDown() {
+    }
+
+    // Cycles the interpreter takes for one instruction at $1000, with zero
+    // operands and index registers so that no page is crossed
+    s32 CyclesFor(Byte opcode, Byte ps) {
+        cpu.Reset(0x1000, mem);
+        cpu.PS = ps;
+        mem[0x1000] = opcode;
+        return cpu.Execute(1, mem);
+    }
+};
+
+TEST_F(OpcodesTests, TableCoversEveryHandler) {
+    u32 implemented = 0;
+    for (OpcodeInfo const& info : Opcodes)
+        implemented += info.Implemented();
+#define CP6502_COUNT(name, mode, baseCycles) + 1
+    EXPECT_EQ(implemented, 0 CP6502_OPCODES(CP6502_COUNT));
+#undef CP6502_COUNT
+    EXPECT_FALSE(Opcodes[0x02].Implemented());
+}
+
+TEST_F(OpcodesTests, EntriesDescribeTheirOpcode) {
+    OpcodeInfo const& lda = Opcodes[CPU::INS_LDA_ABSX];
+    EXPECT_EQ(lda.Name, "LDA_ABSX");
+    EXPECT_EQ(lda.Mnemonic, "LDA");
+    EXPECT_EQ(lda.Mode, AddrMode::AbsoluteX);
+    EXPECT_EQ(lda.Length, 3);
+    EXPECT_EQ(lda.Cycles, 4);
+    EXPECT_EQ(lda.PenaltyCycles, 1);
+    EXPECT_EQ(lda.FlagsWritten, ZeroFlag | NegativeFlag);
+    EXPECT_FALSE(lda.Writes);
+
+    OpcodeInfo const& sta = Opcodes[CPU::INS_STA_ABSX];
+    EXPECT_EQ(sta.PenaltyCycles, 0);
+    EXPECT_TRUE(sta.Writes);
+
+    OpcodeInfo const& rol = Opcodes[CPU::INS_ROL_ACC];
+    EXPECT_EQ(rol.FlagsRead, CarryFlag);
+    EXPECT_FALSE(rol.Writes);
+
+    OpcodeInfo const& bne = Opcodes[CPU::INS_BNE];
+    EXPECT_EQ(bne.FlagsRead, ZeroFlag);
+    EXPECT_TRUE(bne.EndsBlock);
+}
+
+TEST_F(OpcodesTests, CyclesMatchTheInterpreter) {
+    for (u32 opcode = 0; opcode < 256; ++opcode) {
+        OpcodeInfo const& info = Opcodes[opcode];
+        if (!info.Implemented())
+            continue;
+        // Between them, all clear and all set leave every branch untaken once
+        const s32 clear = CyclesFor(opcode, 0x00);
+        const s32 set = CyclesFor(opcode, 0xFF & ~DecimalFlag);
+        EXPECT_EQ(std::min(clear, set), info.Cycles) << info.Name;
+        EXPECT_LE(std::max(clear, set), info.Cycles + info.PenaltyCycles) << info.Name;
+    }
+}
@@ -0,0 +1,212 @@
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "../core/cp6502.hpp"
+#include "../core/profiler.hpp"
+
+using namespace cp6502;
+
+struct ProfilerTests : public testing::Test {
+    Mem mem;
+    CPU cpu;
+    Profiler profiler;
+
+    static constexpr Word Start = 0x0200;
+
+    virtual void SetUp() {
+        cpu.Reset(Start, mem);
+    }
+
+    virtual void TearDown() {
+    }
+
+    void Load(Word address, std::vector<Byte> const& code) {
+        for (Byte value : code)
+            mem[address++] = value;
+    }
+
+    static Profiler::Function Find(std::vector<Profiler::Function> const& functions, u32 address) {
+        for (Profiler::Function const& function : functions)
+            if (function.Address == address)
+                return function;
+        ADD_FAILURE() << "no function at " << address;
+        return {};
+    }
+
+    static Profiler::Call Find(std::vector<Profiler::Call> const& calls, u32 caller, u32 callee) {
+        for (Profiler::Call const& call : calls)
+            if (call.Caller == caller && call.Callee == callee)
+                return call;
+        ADD_FAILURE() << "no call from " << caller << " to " << callee;
+        return {};
+    }
+
+    // Subroutines at $0300, which calls $0400, which runs a NOP
+    void LoadNestedCalls() {
+        Load(Start, { CPU::INS_JSR, 0x00, 0x03, CPU::INS_NOP });
+        Load(0x0300, { CPU::INS_JSR, 0x00, 0x04, CPU::INS_RTS });
+        Load(0x0400, { CPU::INS_NOP, CPU::INS_RTS });
+    }
+    static constexpr s32 NestedCallsCycles = 6 + 6 + 2 + 6 + 6 + 2;
+
+    // What write(file) writes
+    template <typename WriteFn>
+    static std::string Written(WriteFn write) {
+        FILE* file = tmpfile();
+        write(file);
+        std::string text(ftell(file), '\0');
+        rewind(file);
+        fread(text.data(), 1, text.size(), file);
+        fclose(file);
+        return text;
+    }
+};
+
+TEST_F(ProfilerTests, CountsInstructionsAndCyclesPerPC) {
+    // given:
+    Load(Start, { CPU::INS_LDA_IM, 0x01, CPU::INS_STA_ZP, 0x10, CPU::INS_NOP });
+    // when:
+    cpu.Execute(2 + 3 + 2, mem, profiler);
+    // then:
+    EXPECT_EQ(profiler.InstructionsAt(Start), 1u);
+    EXPECT_EQ(profiler.CyclesAt(Start), 2u);
+    EXPECT_EQ(profiler.CyclesAt(Start + 2), 3u);
+    EXPECT_EQ(profiler.CyclesAt(Start + 4), 2u);
+    EXPECT_EQ(profiler.InstructionsAt(Start + 5), 0u);
+    EXPECT_EQ(profiler.TotalInstructions(), 3u);
+    EXPECT_EQ(profiler.CyclesUsed(), 7u);
+}
+
+TEST_F(ProfilerTests, ChargesBranchPenaltiesToTheBranch) {
+    // given:
+    Load(Start, { CPU::INS_LDX_IM, 0x05, CPU::INS_DEX, CPU::INS_BNE, Byte(-3) });
+    // when:
+    cpu.Execute(2 + 5 * 2 + 4 * 3 + 2, mem, profiler);
+    // then:
+    EXPECT_EQ(profiler.InstructionsAt(Start + 2), 5u);
+    EXPECT_EQ(profiler.InstructionsAt(Start + 3), 5u);
+    EXPECT_EQ(profiler.CyclesAt(Start + 2), 10u);
+    EXPECT_EQ(profiler.CyclesAt(Start + 3), 4 * 3 + 2u);
+}
+
+TEST_F(ProfilerTests, CostsSubroutinesInclusiveAndExclusive) {
+    // given:
+    LoadNestedCalls();
+    // when:
+    cpu.Execute(NestedCallsCycles, mem, profiler);
+    // then:
+    const std::vector<Profiler::Function> functions = profiler.Functions();
+    ASSERT_EQ(functions.size(), 3u);
+    EXPECT_EQ(functions[0].Address, Profiler::TopLevel);
+    EXPECT_EQ(functions[0].Inclusive, u64(NestedCallsCycles));
+    EXPECT_EQ(functions[0].Exclusive, 6 + 2u);
+    EXPECT_EQ(functions[1].Address, 0x0300u);
+    EXPECT_EQ(functions[1].Calls, 1u);
+    EXPECT_EQ(functions[1].Inclusive, 6 + 2 + 6 + 6u);
+    EXPECT_EQ(functions[1].Exclusive, 6 + 6u);
+    EXPECT_EQ(functions[2].Address, 0x0400u);
+    EXPECT_EQ(functions[2].Inclusive, 2 + 6u);
+    EXPECT_EQ(functions[2].Exclusive, 2 + 6u);
+
+    const std::vector<Profiler::Call> calls = profiler.Calls();
+    ASSERT_EQ(calls.size(), 2u);
+    EXPECT_EQ(Find(calls, Profiler::TopLevel, 0x0300).Inclusive, 20u);
+    EXPECT_EQ(Find(calls, 0x0300, 0x0400).Calls, 1u);
+    EXPECT_EQ(Find(calls, 0x0300, 0x0400).Inclusive, 8u);
+}
+
+TEST_F(ProfilerTests, GivesTheSameProfileOneInstructionPerExecute) {
+    // given:
+    LoadNestedCalls();
+    // when:
+    s32 used = 0;
+    while (used < NestedCallsCycles)
+        used += cpu.Execute(1, mem, profiler);
+    // then:
+    const std::vector<Profiler::Function> functions = profiler.Functions();
+    EXPECT_EQ(Find(functions, 0x0300).Inclusive, 20u);
+    EXPECT_EQ(Find(functions, 0x0300).Exclusive, 12u);
+    EXPECT_EQ(Find(functions, 0x0400).Inclusive, 8u);
+    EXPECT_EQ(Find(functions, Profiler::TopLevel).Exclusive, 8u);
+}
+
+TEST_F(ProfilerTests, CountsARecursiveSubroutineOnceInclusive) {
+    // given: $0300 calls itself until X runs out
+    Load(Start, { CPU::INS_LDX_IM, 0x03, CPU::INS_JSR, 0x00, 0x03, CPU::INS_NOP });
+    Load(0x0300, { CPU::INS_DEX, CPU::INS_BEQ, 0x03, CPU::INS_JSR, 0x00, 0x03, CPU::INS_RTS });
+    // three calls: DEX, BEQ, JSR; DEX, BEQ, JSR; DEX, BEQ taken, RTS; RTS; RTS
+    const s32 inside = 2 * (2 + 2 + 6) + 2 + 3 + 3 * 6;
+    // when:
+    cpu.Execute(2 + 6 + inside + 2, mem, profiler);
+    // then:
+    const Profiler::Function function = Find(profiler.Functions(), 0x0300);
+    EXPECT_EQ(function.Calls, 3u);
+    EXPECT_EQ(function.Inclusive, u64(inside));
+    EXPECT_EQ(function.Exclusive, u64(inside));
+    EXPECT_EQ(Find(profiler.Calls(), 0x0300, 0x0300).Calls, 2u);
+    EXPECT_EQ(cpu.PC, Start + 6);
+}
+
+TEST_F(ProfilerTests, EndsBothCallsWhenAReturnAddressIsDropped) {
+    // given: $0400 drops its return address, so its RTS returns from $0300 too
+    Load(Start, { CPU::INS_JSR, 0x00, 0x03, CPU::INS_NOP });
+    Load(0x0300, { CPU::INS_JSR, 0x00, 0x04, CPU::INS_RTS });
+    Load(0x0400, { CPU::INS_PLA, CPU::INS_PLA, CPU::INS_RTS });
+    // when:
+    cpu.Execute(6 + 6 + 4 + 4 + 6 + 2, mem, profiler);
+    // then:
+    EXPECT_EQ(cpu.PC, Start + 4);
+    EXPECT_EQ(Find(profiler.Functions(), 0x0400).Inclusive, 4 + 4 + 6u);
+    EXPECT_EQ(Find(profiler.Functions(), 0x0300).Inclusive, 6 + 4 + 4 + 6u);
+    EXPECT_EQ(Find(profiler.Functions(), Profiler::TopLevel).Exclusive, 6 + 2u);
+}
+
+TEST_F(ProfilerTests, CountsCallsStillRunning) {
+    // given: $0300 never returns
+    Load(Start, { CPU::INS_JSR, 0x00, 0x03 });
+    Load(0x0300, { CPU::INS_INX, CPU::INS_JMP_ABS, 0x00, 0x03 });
+    // when:
+    cpu.Execute(6 + 10 * 5, mem, profiler);
+    // then:
+    EXPECT_EQ(Find(profiler.Functions(), 0x0300).Inclusive, 50u);
+    EXPECT_EQ(Find(profiler.Calls(), Profiler::TopLevel, 0x0300).Inclusive, 50u);
+}
+
+TEST_F(ProfilerTests, WritesTheHottestPCFirst) {
+    // given:
+    Load(Start, { CPU::INS_LDX_IM, 0x05, CPU::INS_DEX, CPU::INS_BNE, Byte(-3) });
+    cpu.Execute(2 + 5 * 2 + 4 * 3 + 2, mem, profiler);
+    // when:
+    const std::string flat = Written([&](FILE* file) { profiler.WriteFlat(file); });
+    // then:
+    const size_t firstLine = flat.find('\n') + 1;
+    EXPECT_EQ(flat.compare(firstLine, 5, "$0203"), 0) << flat;
+}
+
+TEST_F(ProfilerTests, WritesCallersWithTheirCallees) {
+    // given:
+    LoadNestedCalls();
+    cpu.Execute(NestedCallsCycles, mem, profiler);
+    // when:
+    const std::string graph = Written([&](FILE* file) { profiler.WriteCallGraph(file); });
+    // then:
+    const size_t caller = graph.find("\n$0300");
+    ASSERT_NE(caller, std::string::npos) << graph;
+    EXPECT_EQ(graph.find("  -> $0400", caller), graph.find('\n', caller + 1) + 1) << graph;
+}
+
+TEST_F(ProfilerTests, ClearForgetsEverything) {
+    // given:
+    LoadNestedCalls();
+    cpu.Execute(NestedCallsCycles, mem, profiler);
+    // when:
+    profiler.Clear();
+    // then:
+    EXPECT_EQ(profiler.TotalInstructions(), 0u);
+    EXPECT_EQ(profiler.CyclesUsed(), 0u);
+    EXPECT_EQ(profiler.Functions().size(), 1u);
+    EXPECT_TRUE(profiler.Calls().empty());
+}
@@ -0,0 +1,181 @@
+#include <gtest/gtest.h>
+
+#include <new>
+#include <vector>
+
+#include "../core/cp6502.hpp"
+#include "../core/scheduler.hpp"
+
+using namespace cp6502;
+
+struct SchedulerTests : public testing::Test {
+    Mem mem;
+    CPU cpu;
+    Scheduler scheduler;
+
+    static constexpr Word Start = 0x0200;
+    static constexpr Word Handler = 0x0300;
+
+    virtual void SetUp() {
+        cpu.Reset(Start, mem);
+        mem[0xFFFA] = Handler & 0xFF;
+        mem[0xFFFB] = Handler >> 8;
+        mem[0xFFFE] = Handler & 0xFF;
+        mem[0xFFFF] = Handler >> 8;
+    }
+
+    virtual void TearDown() {
+    }
+
+    void Load(Word address, std::vector<Byte> const& code) {
+        for (Byte value : code)
+            mem[address++] = value;
+    }
+};
+
+TEST_F(SchedulerTests, EventsFireInOrderOfDueThenOfAdding) {
+    // given:
+    std::vector<int> fired;
+    scheduler.At(20, [&](u64) { fired.push_back(3); });
+    scheduler.At(10, [&](u64) { fired.push_back(1); });
+    scheduler.At(10, [&](u64) { fired.push_back(2); });
+    scheduler.At(30, [&](u64) { fired.push_back(4); });
+    // when:
+    scheduler.Now = 20;
+    scheduler.RunDue();
+    // then:
+    EXPECT_EQ(fired, (std::vector<int>{ 1, 2, 3 }));
+    EXPECT_EQ(scheduler.Pending(), 1u);
+    EXPECT_EQ(scheduler.UntilNext(), 10u);
+}
+
+TEST_F(SchedulerTests, CancelledEventsDoNotFire) {
+    // given:
+    u32 fired = 0;
+    const u32 once = scheduler.After(10, [&](u64) { ++fired; });
+    u32 every = 0;
+    every = scheduler.Every(5, [&](u64 due) {
+        ++fired;
+        if (due == 15)
+            scheduler.Cancel(every);
+    });
+    // when:
+    EXPECT_TRUE(scheduler.Cancel(once));
+    EXPECT_FALSE(scheduler.Cancel(once));
+    scheduler.Now = 100;
+    scheduler.RunDue();
+    // then:
+    EXPECT_EQ(fired, 3u);
+    EXPECT_EQ(scheduler.Pending(), 0u);
+    EXPECT_FALSE(scheduler.Cancel(every));
+}
+
+TEST_F(SchedulerTests, IRQPushesPCAndStatusWithBreakClear) {
+    // given:
+    cpu.C = 1;
+    cpu.AssertIRQ();
+    s32 cycles = 7;
+    // when:
+    EXPECT_TRUE(cpu.TakeInterrupt(cycles, mem));
+    // then:
+    EXPECT_EQ(cycles, 0);
+    EXPECT_EQ(cpu.PC, Handler);
+    EXPECT_TRUE(cpu.I);
+    EXPECT_EQ(cpu.SP, 0xFC);
+    EXPECT_EQ(mem[0x01FF], Start >> 8);
+    EXPECT_EQ(mem[0x01FE], Start & 0xFF);
+    EXPECT_EQ(mem[0x01FD], CarryFlag | UnusedFlag);
+    // and the line stays asserted, but I now masks it
+    EXPECT_FALSE(cpu.TakeInterrupt(cycles, mem));
+}
+
+TEST_F(SchedulerTests, NMIIsTakenOnceEvenWithIMasked) {
+    // given:
+    cpu.I = 1;
+    cpu.NMI = true;
+    mem[0xFFFA] = 0x00;
+    mem[0xFFFB] = 0x40;
+    s32 cycles = 14;
+    // when/then:
+    EXPECT_TRUE(cpu.TakeInterrupt(cycles, mem));
+    EXPECT_EQ(cpu.PC, 0x4000);
+    EXPECT_FALSE(cpu.TakeInterrupt(cycles, mem));
+    EXPECT_EQ(cycles, 7);
+}
+
+TEST_F(SchedulerTests, ACPUNeverResetHasNoInterruptPending) {
+    // given: a CPU built over leftover bytes, as in a JobRunner job
+    alignas(CPU) Byte storage[sizeof(CPU)];
+    memset(storage, 0xFF, sizeof(storage));
+    CPU* fresh = new (storage) CPU;
+    fresh->PC = Start;
+    fresh->SP = 0xFF;
+    fresh->PS = 0;
+    s32 cycles = 0;
+    // then:
+    EXPECT_FALSE(fresh->TakeInterrupt(cycles, mem));
+    EXPECT_EQ(cycles, 0);
+    EXPECT_EQ(fresh->PC, Start);
+}
+
+TEST_F(SchedulerTests, RESETLoadsTheResetVector) {
+    // given:
+    cpu.RESET = true;
+    cpu.NMI = true;
+    mem[0xFFFC] = 0x34;
+    mem[0xFFFD] = 0x12;
+    s32 cycles = 7;
+    // when:
+    EXPECT_TRUE(cpu.TakeInterrupt(cycles, mem));
+    // then:
+    EXPECT_EQ(cycles, 0);
+    EXPECT_EQ(cpu.PC, 0x1234);
+    EXPECT_EQ(cpu.SP, 0xFC);
+    EXPECT_TRUE(cpu.I);
+    EXPECT_TRUE(cpu.NMI);
+}
+
+TEST_F(SchedulerTests, PeriodicNMIRunsItsHandler) {
+    // given:
+    Load(Start, { CPU::INS_JMP_ABS, Start & 0xFF, Start >> 8 });
+    Load(Handler, { CPU::INS_INC_ZP, 0x10, CPU::INS_RTI });
+    u32 late = 0;
+    scheduler.Every(100, [&](u64 due) {
+        late = std::max<u64>(late, scheduler.Now - due);
+        cpu.NMI = true;
+    });
+    // when:
+    const s32 cyclesUsed = cpu.Execute(10000, mem, scheduler);
+    // then:
+    EXPECT_GE(cyclesUsed, 10000);
+    EXPECT_EQ(scheduler.Now, u64(cyclesUsed));
+    EXPECT_EQ(mem[0x10], 99);
+    EXPECT_LT(late, 3u);
+}
+
+TEST_F(SchedulerTests, MaskedIRQIsTakenOnceCLIRuns) {
+    // given:
+    Load(Start, { CPU::INS_SEI, CPU::INS_NOP, CPU::INS_NOP, CPU::INS_NOP, CPU::INS_NOP, CPU::INS_NOP,
+                  CPU::INS_CLI, CPU::INS_JMP_ABS, Start & 0xFF, Start >> 8 });
+    Load(Handler, { CPU::INS_JMP_ABS, Handler & 0xFF, Handler >> 8 });
+    scheduler.At(4, [&](u64) { cpu.AssertIRQ(); });
+    // when:
+    cpu.Execute(40, mem, scheduler);
+    // then:
+    EXPECT_EQ(cpu.PC, Handler);
+    const Word pushedPC = mem[0x01FF] << 8 | mem[0x01FE];
+    EXPECT_EQ(pushedPC, Start + 7);
+}
+
+TEST_F(SchedulerTests, ExecuteRunsEveryDispatchBetweenEvents) {
+    // given:
+    Load(Start, { CPU::INS_INX, CPU::INS_JMP_ABS, Start & 0xFF, Start >> 8 });
+    u32 fired = 0;
+    scheduler.Every(50, [&](u64) { ++fired; });
+    // when:
+    cpu.Execute<Dispatch::Switch>(500, mem, scheduler);
+    cpu.Execute<Dispatch::Table>(500, mem, scheduler);
+    // then:
+    EXPECT_EQ(fired, 19u);
+    EXPECT_EQ(cpu.X, 1000 / 5 % 256);
+}
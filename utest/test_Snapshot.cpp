@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+
+#include "../core/cp6502.hpp"
+#include "../core/blockcache.hpp"
+#include "../core/snapshot.hpp"
+
+using namespace cp6502;
+
+struct SnapshotTests : public testing::Test {
+    Mem mem;
+    CPU cpu;
+    Snapshotter snapshotter;
+
+    virtual void SetUp() {
+        cpu.Reset(0xFF00, mem);
+    }
+
+    virtual void TearDown() {
+    }
+};
+
+TEST_F(SnapshotTests, RestoreBringsBackCpuAndMemory) {
+    // given:
+    mem[0x1234] = 0x56;
+    cpu.A = 0x11;
+    cpu.C = 1;
+    Snapshot snapshot = snapshotter.Take(cpu, mem);
+    mem[0x1234] = 0x99;
+    mem[0x8000] = 0x01;
+    cpu.A = 0x22;
+    cpu.C = 0;
+    // when:
+    snapshotter.Restore(snapshot, cpu, mem);
+    // then:
+    EXPECT_EQ(mem[0x1234], 0x56);
+    EXPECT_EQ(mem[0x8000], 0x00);
+    EXPECT_EQ(cpu.A, 0x11);
+    EXPECT_EQ(cpu.C, 1);
+}
+
+TEST_F(SnapshotTests, SnapshotsShareUnwrittenPages) {
+    // given:
+    Snapshot first = snapshotter.Take(cpu, mem);
+    const u32 copiedByFirst = snapshotter.PagesCopied;
+    mem[0x2010] = 0x01;
+    // when:
+    Snapshot second = snapshotter.Take(cpu, mem);
+    // then:
+    EXPECT_EQ(copiedByFirst, Mem::NUM_PAGES);
+    EXPECT_EQ(snapshotter.PagesCopied, copiedByFirst + 1);
+    EXPECT_NE((*first.Pages)[0x20], (*second.Pages)[0x20]);
+    EXPECT_EQ((*first.Pages)[0x21], (*second.Pages)[0x21]);
+    EXPECT_EQ((*(*first.Pages)[0x20])[0x10], 0x00);
+    EXPECT_EQ((*(*second.Pages)[0x20])[0x10], 0x01);
+}
+
+TEST_F(SnapshotTests, SnapshotsWithNothingWrittenBetweenShareOneTable) {
+    // given:
+    Snapshot first = snapshotter.Take(cpu, mem);
+    const u32 copiedByFirst = snapshotter.PagesCopied;
+    cpu.A = 0x42;
+    // when:
+    Snapshot second = snapshotter.Take(cpu, mem);
+    // then:
+    EXPECT_EQ(first.Pages, second.Pages);
+    EXPECT_EQ(snapshotter.PagesCopied, copiedByFirst);
+    EXPECT_EQ(second.Cpu.A, 0x42);
+}
+
+TEST_F(SnapshotTests, RestoreCopiesOnlyPagesThatDiffer) {
+    // given:
+    Snapshot snapshot = snapshotter.Take(cpu, mem);
+    for (int fork = 0; fork < 3; ++fork) {
+        const u32 copiedBefore = snapshotter.PagesCopied;
+        mem[0x0080] = fork + 1;
+        mem[0x4000] = fork + 1;
+        // when:
+        snapshotter.Restore(snapshot, cpu, mem);
+        // then:
+        EXPECT_EQ(snapshotter.PagesCopied, copiedBefore + 2);
+        EXPECT_EQ(mem[0x0080], 0);
+        EXPECT_EQ(mem[0x4000], 0);
+    }
+}
+
+TEST_F(SnapshotTests, RestoringAnotherSnapshotCopiesOnlyThePagesTheyDoNotShare) {
+    // given:
+    Snapshot first = snapshotter.Take(cpu, mem);
+    mem[0x5000] = 0x01;
+    Snapshot second = snapshotter.Take(cpu, mem);
+    mem[0x6000] = 0x02;
+    const u32 copiedBefore = snapshotter.PagesCopied;
+    // when:
+    snapshotter.Restore(first, cpu, mem);
+    // then: $50 differs between the snapshots, $60 was written since
+    EXPECT_EQ(snapshotter.PagesCopied, copiedBefore + 2);
+    EXPECT_EQ(mem.Data[0x5000], 0x00);
+    EXPECT_EQ(mem.Data[0x6000], 0x00);
+    snapshotter.Restore(second, cpu, mem);
+    EXPECT_EQ(snapshotter.PagesCopied, copiedBefore + 3);
+    EXPECT_EQ(mem.Data[0x5000], 0x01);
+}
+
+TEST_F(SnapshotTests, RestoreInvalidatesDecodedBlocks) {
+    // given:
+    Byte prog[] = {
+        0x00, 0x10,
+        0xA9, 0x01,         // $1000 LDA #1
+        0x4C, 0x00, 0x10,   // $1002 JMP $1000
+    };
+    cpu.PC = cpu.LoadProg(prog, sizeof(prog), mem);
+    Snapshot snapshot = snapshotter.Take(cpu, mem);
+    BlockCache cache;
+    mem[0x1001] = 0x02;
+    cpu.Execute(5, mem, cache);
+    EXPECT_EQ(cpu.A, 2);
+    // when:
+    snapshotter.Restore(snapshot, cpu, mem);
+    cpu.Execute(5, mem, cache);
+    // then:
+    EXPECT_EQ(cpu.A, 1);
+}
+
+TEST_F(SnapshotTests, SnapshotsOfAnotherMemAreNotShared) {
+    // given:
+    Mem other;
+    other.Initialise();
+    other[0x3000] = 0x42;
+    Snapshot snapshot = snapshotter.Take(cpu, mem);
+    // when:
+    Snapshot otherSnapshot = snapshotter.Take(cpu, other);
+    // then:
+    EXPECT_EQ((*(*otherSnapshot.Pages)[0x30])[0], 0x42);
+    EXPECT_EQ((*(*snapshot.Pages)[0x30])[0], 0x00);
+}
@@ -320,3 +320,34 @@ TEST_F(SubstractWithCarryTests, SBCINDYSub_n20_n17_WithNoCarry) {
     TestINDY(data_n20_n17_WithNoCarry);
 }
 
+
+TEST_F(SubstractWithCarryTests, SBCImSubDecimal_46_12_WithNoCarry) {
+    cpu.D = 1;
+    SBCTestData test = {
+        .Carry = true,
+        .A = 0x46,
+        .Operand = 0x12,
+
+        .Answer = 0x34,
+        .ExpectC = true,
+        .ExpectZ = false,
+        .ExpectV = false,
+        .ExpectN = false,
+    };
+    TestIM(test);
+}
+TEST_F(SubstractWithCarryTests, SBCImSubDecimal_0_1_WithNoCarry) {
+    cpu.D = 1;
+    SBCTestData test = {
+        .Carry = true,
+        .A = 0x00,
+        .Operand = 0x01,
+
+        .Answer = 0x99,
+        .ExpectC = false,
+        .ExpectZ = false,
+        .ExpectV = false,
+        .ExpectN = true,
+    };
+    TestIM(test);
+}
@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <string>
+
+#include "../core/cp6502.hpp"
+#include "../core/disassembler.hpp"
+#include "../core/profiler.hpp"
+#include "../core/symbols.hpp"
+#include "../core/trace.hpp"
+
+using namespace cp6502;
+
+struct SymbolsTests : public testing::Test {
+    Mem mem;
+    CPU cpu;
+    Symbols symbols;
+
+    virtual void SetUp() {
+    }
+
+    virtual void TearDown() {
+    }
+
+    // What write(file) writes
+    template <typename WriteFn>
+    static std::string Written(WriteFn write) {
+        FILE* file = tmpfile();
+        write(file);
+        std::string text(ftell(file), '\0');
+        rewind(file);
+        fread(text.data(), 1, text.size(), file);
+        fclose(file);
+        return text;
+    }
+};
+
+TEST_F(SymbolsTests, LoadsTheLabelsOfAnAS65Listing) {
+    // when:
+    ASSERT_TRUE(symbols.LoadListing(CP6502_STEST_DIR "/6502_functional_test.lst"));
+    // then:
+    EXPECT_GT(symbols.Count(), 300u);
+    EXPECT_EQ(symbols.Find(0x0400).Name, "start");
+    EXPECT_EQ(symbols.Find(0x0400).Address, 0x0400);
+    EXPECT_EQ(symbols.Find(0x0218).Name, "abs1");
+}
+
+TEST_F(SymbolsTests, FailsOnAMissingListing) {
+    EXPECT_FALSE(symbols.LoadListing(CP6502_STEST_DIR "/no_such_listing.lst"));
+    EXPECT_EQ(symbols.Count(), 0u);
+}
+
+TEST_F(SymbolsTests, FormatsLabelPlusOffset) {
+    // given:
+    symbols.AddListing("0400 : d8               start   cld\n"
+                       "0401 : a2ff                     ldx #$ff\n");
+    // then:
+    EXPECT_EQ(symbols.Format(0x0400), "start");
+    EXPECT_EQ(symbols.Format(0x0401), "start+1");
+    EXPECT_EQ(symbols.Format(0x0500), "start+256");
+    EXPECT_EQ(symbols.Format(0x03FF), "$03FF");
+}
+
+TEST_F(SymbolsTests, LeavesOutEquatesAndLinesNotAssembled) {
+    // given:
+    symbols.AddListing("0400 =                  code_segment = $400\n"
+                       "                        skipped lda #0\n"
+                       "000c =                 >test_num = test_num + 1\n");
+    // then:
+    EXPECT_EQ(symbols.Count(), 0u);
+    EXPECT_TRUE(symbols.Find(0x0400).Name.empty());
+}
+
+TEST_F(SymbolsTests, KeepsTheLastLabelAtAnAddress) {
+    // given:
+    symbols.AddListing("000c :                  zpt                         ;6 bytes store/modify test area\r\n"
+                       "000c : 00               adfc    ds  1               ;carry flag before op\r\n");
+    // then:
+    EXPECT_EQ(symbols.Find(0x000c).Name, "adfc");
+    EXPECT_EQ(symbols.Format(0x000d), "adfc+1");
+}
+
+TEST_F(SymbolsTests, AddsLabelsOneByOne) {
+    // given:
+    symbols.Add("low", 0x1000);
+    symbols.Add("high", 0x2000);
+    // when:
+    symbols.Add("middle", 0x1800);
+    // then:
+    EXPECT_EQ(symbols.Format(0x17FF), "low+2047");
+    EXPECT_EQ(symbols.Format(0x1801), "middle+1");
+    EXPECT_EQ(symbols.Format(0x2001), "high+1");
+}
+
+TEST_F(SymbolsTests, DisassemblesWithAndWithoutLabels) {
+    // given:
+    symbols.Add("start", 0x0400);
+    symbols.Add("zpt", 0x000c);
+    // then:
+    EXPECT_EQ(Disassemble(0x0400, CPU::INS_LDA_IM, 0x01, 0x00), "LDA #$01");
+    EXPECT_EQ(Disassemble(0x0400, CPU::INS_LDA_IM, 0x01, 0x00, &symbols), "LDA #$01");
+    EXPECT_EQ(Disassemble(0x0400, CPU::INS_STA_ZPX, 0x0d, 0x00), "STA $0D,X");
+    EXPECT_EQ(Disassemble(0x0400, CPU::INS_STA_ZPX, 0x0d, 0x00, &symbols), "STA zpt+1,X");
+    EXPECT_EQ(Disassemble(0x0500, CPU::INS_JMP_ABS, 0x00, 0x04, &symbols), "JMP start");
+    EXPECT_EQ(Disassemble(0x0403, CPU::INS_BNE, Byte(-4), 0x00, &symbols), "BNE start+1");
+    EXPECT_EQ(Disassemble(0x0400, CPU::INS_LDA_INDY, 0x0c, 0x00, &symbols), "LDA (zpt),Y");
+    EXPECT_EQ(Disassemble(0x0400, CPU::INS_ASL_ACC, 0x00, 0x00), "ASL A");
+    EXPECT_EQ(Disassemble(0x0400, 0xFF, 0x00, 0x00), ".byte $FF");
+}
+
+TEST_F(SymbolsTests, DisassemblesTheFunctionalTest) {
+    // given:
+    ASSERT_TRUE(symbols.LoadListing(CP6502_STEST_DIR "/6502_functional_test.lst"));
+    mem[0x369c] = CPU::INS_JMP_ABS;
+    mem[0x369d] = 0x00;
+    mem[0x369e] = 0x04;
+    // then:
+    EXPECT_EQ(Disassemble(0x369c, mem, &symbols), "JMP start");
+}
+
+TEST_F(SymbolsTests, WritesTracesWithLabels) {
+    // given:
+    symbols.Add("start", 0x0400);
+    TraceRing trace(4);
+    cpu.Reset(0x0400, mem);
+    mem[0x0400] = CPU::INS_LDA_IM;
+    mem[0x0401] = 0x42;
+    mem[0x0402] = CPU::INS_NOP;
+    cpu.Execute(2 + 2, mem, trace);
+    // when:
+    const std::string text = Written([&](FILE* file) { trace.WriteText(file, &symbols); });
+    // then:
+    const size_t second = text.find('\n') + 1;
+    EXPECT_EQ(text.compare(0, 12, "$0400 start "), 0) << text;
+    EXPECT_NE(text.find("LDA #$42\n"), std::string::npos) << text;
+    EXPECT_EQ(text.compare(second, 14, "$0402 start+2 "), 0) << text;
+    EXPECT_NE(text.find("A=42", second), std::string::npos) << text;
+}
+
+TEST_F(SymbolsTests, ProfilesWithLabels) {
+    // given:
+    symbols.Add("start", 0x0400);
+    symbols.Add("delay", 0x0500);
+    Profiler profiler;
+    cpu.Reset(0x0400, mem);
+    mem[0x0400] = CPU::INS_JSR;
+    mem[0x0401] = 0x00;
+    mem[0x0402] = 0x05;
+    mem[0x0500] = CPU::INS_RTS;
+    cpu.Execute(6 + 6, mem, profiler);
+    // when:
+    const std::string flat = Written([&](FILE* file) { profiler.WriteFlat(file, 20, &symbols); });
+    const std::string graph = Written([&](FILE* file) { profiler.WriteCallGraph(file, &symbols); });
+    // then:
+    EXPECT_NE(flat.find("\nstart "), std::string::npos) << flat;
+    EXPECT_NE(flat.find("\ndelay "), std::string::npos) << flat;
+    EXPECT_NE(graph.find("\ndelay "), std::string::npos) << graph;
+    EXPECT_NE(graph.find("  -> delay "), std::string::npos) << graph;
+}
@@ -98,3 +98,21 @@ TEST_F(SystemFunctionTests, NOP) {
     EXPECT_EQ(cpu.X, cpuCopy.X);
     EXPECT_EQ(cpu.Y, cpuCopy.Y);
 }
+
+TEST_F(SystemFunctionTests, BRKStopsExecuteWhenItIsABreakpoint) {
+    // given:
+    cpu.StopOnBRK = true;
+    mem[0xFF00] = CPU::INS_NOP;
+    mem[0xFF01] = CPU::INS_BRK;
+    mem[0xFFFE] = 0x00;
+    mem[0xFFFF] = 0x90;
+    // when:
+    const ExecuteResult result = cpu.Execute(100, mem);
+    // then:
+    EXPECT_EQ(result.Reason, StopReason::Breakpoint);
+    EXPECT_EQ(result.Cycles, 2);
+    EXPECT_EQ(result.PC, 0xFF01);
+    EXPECT_EQ(cpu.PC, 0xFF01);
+    EXPECT_EQ(cpu.SP, 0xFF);
+    EXPECT_FALSE(cpu.I);
+}
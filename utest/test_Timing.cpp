@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+
+#include "../core/cp6502.hpp"
+
+using namespace cp6502;
+
+struct TimingTests : public testing::Test {
+    using PerAccessCPU = BasicCPU<Mem, Timing::PerAccess>;
+    using PerInstructionCPU = BasicCPU<Mem, Timing::PerInstruction>;
+
+    static constexpr s32 FUNCTIONAL_TEST_CYCLES = 84032391;
+
+    virtual void SetUp() {
+    }
+
+    virtual void TearDown() {
+    }
+
+    void LoadFunctionalTest(Mem& mem) {
+        mem.Initialise();
+        FILE* fp = fopen(CP6502_STEST_DIR "/6502_functional_test.bin", "rb");
+        ASSERT_NE(fp, nullptr);
+        const size_t size = Mem::MAX_MEM - 0x000A;
+        ASSERT_EQ(fread(&mem.Data[0x000A], 1, size, fp), size);
+        fclose(fp);
+    }
+
+    template <Dispatch D>
+    void PerInstructionPassesFunctionalTest() {
+        // given:
+        static Mem mem;
+        LoadFunctionalTest(mem);
+        PerInstructionCPU cpu;
+        cpu.Reset(0x0400);
+        // when:
+        const s32 cyclesUsed = cpu.Execute<D>(FUNCTIONAL_TEST_CYCLES, mem);
+        // then:
+        EXPECT_EQ(cyclesUsed, FUNCTIONAL_TEST_CYCLES);
+        EXPECT_EQ(cpu.PC, 0x3699);
+    }
+};
+
+TEST_F(TimingTests, SwitchPerInstructionPassesFunctionalTest) {
+    PerInstructionPassesFunctionalTest<Dispatch::Switch>();
+}
+
+TEST_F(TimingTests, TablePerInstructionPassesFunctionalTest) {
+    PerInstructionPassesFunctionalTest<Dispatch::Table>();
+}
+
+#if CP6502_HAS_COMPUTED_GOTO
+TEST_F(TimingTests, ThreadedPerInstructionPassesFunctionalTest) {
+    PerInstructionPassesFunctionalTest<Dispatch::Threaded>();
+}
+#endif
+
+TEST_F(TimingTests, EveryInstructionCostsTheSameInBothModes) {
+    // given:
+    static Mem perAccessMem, perInstructionMem;
+    LoadFunctionalTest(perAccessMem);
+    LoadFunctionalTest(perInstructionMem);
+    PerAccessCPU perAccess;
+    PerInstructionCPU perInstruction;
+    perAccess.Reset(0x0400);
+    perInstruction.Reset(0x0400);
+    // when/then:
+    for (u32 step = 0; step < 200000; ++step) {
+        const Word pc = perAccess.PC;
+        const s32 expected = perAccess.Execute(1, perAccessMem);
+        ASSERT_EQ(perInstruction.Execute(1, perInstructionMem), expected)
+            << "opcode " << std::hex << int(perAccessMem[pc]) << " at " << pc;
+        ASSERT_EQ(perInstruction.PC, perAccess.PC);
+    }
+}
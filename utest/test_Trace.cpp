@@ -0,0 +1,190 @@
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <vector>
+
+#include "../core/cp6502.hpp"
+#include "../core/trace.hpp"
+
+using namespace cp6502;
+
+struct TraceTests : public testing::Test {
+    Mem mem;
+    CPU cpu;
+
+    static constexpr Word Start = 0x0200;
+
+    virtual void SetUp() {
+        cpu.Reset(Start, mem);
+    }
+
+    virtual void TearDown() {
+    }
+
+    void Load(std::vector<Byte> const& code) {
+        Word address = Start;
+        for (Byte value : code)
+            mem[address++] = value;
+    }
+};
+
+TEST_F(TraceTests, RecordsEachInstructionBeforeItRuns) {
+    // given:
+    Load({ CPU::INS_LDA_IM, 0x42, CPU::INS_LDX_ZP, 0x10, CPU::INS_STA_ABS, 0x34, 0x12 });
+    mem[0x10] = 0x07;
+    TraceRing trace;
+    // when:
+    const s32 cyclesUsed = cpu.Execute(2 + 3 + 4, mem, trace);
+    // then:
+    EXPECT_EQ(cyclesUsed, 9);
+    ASSERT_EQ(trace.Count(), 3u);
+    const std::vector<TraceEntry> entries = trace.Last(3);
+    ASSERT_EQ(entries.size(), 3u);
+    EXPECT_EQ(entries[0].Cycle, 0u);
+    EXPECT_EQ(entries[0].PC, Start);
+    EXPECT_EQ(entries[0].Opcode, CPU::INS_LDA_IM);
+    EXPECT_EQ(entries[0].Operand[0], 0x42);
+    EXPECT_EQ(entries[0].Operand[1], 0x00);
+    EXPECT_EQ(entries[0].Length, 2);
+    EXPECT_EQ(entries[0].A, 0x00);
+    EXPECT_EQ(entries[1].Cycle, 2u);
+    EXPECT_EQ(entries[1].PC, Start + 2);
+    EXPECT_EQ(entries[1].A, 0x42);
+    EXPECT_EQ(entries[1].X, 0x00);
+    EXPECT_EQ(entries[2].Cycle, 5u);
+    EXPECT_EQ(entries[2].Opcode, CPU::INS_STA_ABS);
+    EXPECT_EQ(entries[2].Operand[0], 0x34);
+    EXPECT_EQ(entries[2].Operand[1], 0x12);
+    EXPECT_EQ(entries[2].Length, 3);
+    EXPECT_EQ(entries[2].X, 0x07);
+}
+
+TEST_F(TraceTests, KeepsOnlyTheLastCapacityInstructions) {
+    // given:
+    Load(std::vector<Byte>(10, CPU::INS_NOP));
+    TraceRing trace(2);
+    // when:
+    cpu.Execute(10 * 2, mem, trace);
+    // then:
+    EXPECT_EQ(trace.Count(), 10u);
+    const std::vector<TraceEntry> entries = trace.Last(100);
+    ASSERT_EQ(entries.size(), 3u);
+    for (u32 i = 0; i < 3; ++i)
+        EXPECT_EQ(entries[i].PC, Start + 7 + i);
+    ASSERT_EQ(trace.Last(1).size(), 1u);
+    EXPECT_EQ(trace.Last(1)[0].PC, Start + 9);
+}
+
+TEST_F(TraceTests, PublishesEveryEntryAcrossExecutesThatWrapTheRing) {
+    // given: 16 slots, published every 4, and Executes that stop between
+    Load(std::vector<Byte>(40, CPU::INS_NOP));
+    TraceRing trace(4);
+    EXPECT_EQ(trace.Capacity(), 12u);
+    // when:
+    for (s32 instructions : { 3, 6, 1, 13, 7 }) {
+        cpu.Execute(instructions * 2, mem, trace);
+        // then:
+        ASSERT_EQ(trace.Last(1).size(), 1u);
+        EXPECT_EQ(trace.Last(1)[0].PC, cpu.PC - 1);
+    }
+    EXPECT_EQ(trace.Count(), 30u);
+    const std::vector<TraceEntry> entries = trace.Last(100);
+    ASSERT_EQ(entries.size(), 12u);
+    for (u32 i = 0; i < 12; ++i) {
+        EXPECT_EQ(entries[i].PC, Start + 18 + i);
+        EXPECT_EQ(entries[i].Cycle, 2 * (18 + i));
+    }
+}
+
+TEST_F(TraceTests, RecordsOperandsAtTheTopOfMemory) {
+    // given:
+    cpu.Reset(0xFFFE);
+    mem[0xFFFE] = CPU::INS_LDA_IM;
+    mem[0xFFFF] = 0x42;
+    mem[0x0000] = 0x99;
+    TraceRing trace;
+    // when:
+    cpu.Execute(2, mem, trace);
+    // then:
+    const std::vector<TraceEntry> entries = trace.Last(1);
+    ASSERT_EQ(entries.size(), 1u);
+    EXPECT_EQ(entries[0].PC, 0xFFFE);
+    EXPECT_EQ(entries[0].Operand[0], 0x42);
+    EXPECT_EQ(entries[0].Operand[1], 0x00);
+}
+
+TEST_F(TraceTests, CyclesCountAcrossExecutes) {
+    // given:
+    Load(std::vector<Byte>(4, CPU::INS_NOP));
+    TraceRing trace;
+    // when:
+    cpu.Execute(2 * 2, mem, trace);
+    cpu.Execute(2 * 2, mem, trace);
+    // then:
+    const std::vector<TraceEntry> entries = trace.Last(4);
+    ASSERT_EQ(entries.size(), 4u);
+    for (u32 i = 0; i < 4; ++i)
+        EXPECT_EQ(entries[i].Cycle, 2 * i);
+}
+
+TEST_F(TraceTests, RecordsFlagsAsInstructionsSeeThem) {
+    // given:
+    Load({ CPU::INS_SEC, CPU::INS_LDA_IM, 0x00, CPU::INS_NOP });
+    TraceRing trace;
+    // when:
+    cpu.Execute(2 + 2 + 2, mem, trace);
+    // then:
+    const std::vector<TraceEntry> entries = trace.Last(3);
+    ASSERT_EQ(entries.size(), 3u);
+    EXPECT_TRUE(entries[1].PS & CarryFlag);
+    EXPECT_FALSE(entries[1].PS & ZeroFlag);
+    EXPECT_TRUE(entries[2].PS & CarryFlag);
+    EXPECT_TRUE(entries[2].PS & ZeroFlag);
+}
+
+TEST_F(TraceTests, UntracedExecuteLeavesTheTraceAlone) {
+    // given:
+    Load(std::vector<Byte>(4, CPU::INS_NOP));
+    TraceRing trace;
+    cpu.Execute(2, mem, trace);
+    // when:
+    cpu.Execute(2, mem);
+    // then:
+    EXPECT_EQ(trace.Count(), 1u);
+}
+
+TEST_F(TraceTests, WritesPackedEntries) {
+    // given:
+    Load(std::vector<Byte>(5, CPU::INS_NOP));
+    TraceRing trace;
+    cpu.Execute(5 * 2, mem, trace);
+    FILE* file = tmpfile();
+    ASSERT_NE(file, nullptr);
+    // when:
+    const size_t written = trace.Write(file);
+    // then:
+    EXPECT_EQ(written, 5u);
+    EXPECT_EQ(ftell(file), long(5 * sizeof(TraceEntry)));
+    rewind(file);
+    TraceEntry entries[5];
+    ASSERT_EQ(fread(entries, sizeof(TraceEntry), 5, file), 5u);
+    EXPECT_EQ(entries[0].PC, Start);
+    EXPECT_EQ(entries[4].PC, Start + 4);
+    EXPECT_EQ(entries[4].Cycle, 8u);
+    fclose(file);
+}
+
+TEST_F(TraceTests, ClearEmptiesTheTrace) {
+    // given:
+    Load(std::vector<Byte>(4, CPU::INS_NOP));
+    TraceRing trace;
+    cpu.Execute(2 * 2, mem, trace);
+    // when:
+    trace.Clear();
+    cpu.Execute(2 * 2, mem, trace);
+    // then:
+    const std::vector<TraceEntry> entries = trace.Last(4);
+    ASSERT_EQ(entries.size(), 2u);
+    EXPECT_EQ(entries[0].Cycle, 0u);
+    EXPECT_EQ(entries[0].PC, Start + 2);
+}
@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "../core/cp6502.hpp"
+#include "../core/trace.hpp"
+#include "../core/tracefile.hpp"
+
+using namespace cp6502;
+
+struct TraceFileTests : public testing::Test {
+    Mem mem;
+    CPU cpu;
+    FILE* file = nullptr;
+
+    static constexpr Word Start = 0x0200;
+
+    virtual void SetUp() {
+        cpu.Reset(Start, mem);
+        file = tmpfile();
+        ASSERT_NE(file, nullptr);
+    }
+
+    virtual void TearDown() {
+        fclose(file);
+    }
+
+    void Load(std::vector<Byte> const& code) {
+        Word address = Start;
+        for (Byte value : code)
+            mem[address++] = value;
+    }
+
+    std::vector<TraceEntry> ReadBack() {
+        rewind(file);
+        TraceReader reader(file);
+        EXPECT_TRUE(reader.Valid());
+        std::vector<TraceEntry> entries;
+        TraceEntry entry;
+        while (reader.Next(entry))
+            entries.push_back(entry);
+        return entries;
+    }
+
+    static void ExpectSameEntries(std::vector<TraceEntry> const& actual, std::vector<TraceEntry> const& expected) {
+        ASSERT_EQ(actual.size(), expected.size());
+        for (size_t i = 0; i < actual.size(); ++i)
+            EXPECT_EQ(memcmp(&actual[i], &expected[i], sizeof(TraceEntry)), 0) << "entry " << i;
+    }
+};
+
+TEST_F(TraceFileTests, ReadsBackWhatATraceRingRecords) {
+    // given: a loop storing X down a page, a subroutine call and a jump back
+    Load({ CPU::INS_LDX_IM, 0x20, CPU::INS_TXA, CPU::INS_STA_ABSX, 0x00, 0x30, CPU::INS_DEX,
+           CPU::INS_BNE, Byte(-7), CPU::INS_JSR, 0x00, 0x04, CPU::INS_JMP_ABS, Start & 0xFF, Start >> 8 });
+    mem[0x0400] = CPU::INS_SEC;
+    mem[0x0401] = CPU::INS_ADC_IM;
+    mem[0x0402] = 0x80;
+    mem[0x0403] = CPU::INS_RTS;
+    CPU ringCpu = cpu;
+    static Mem ringMem;
+    ringMem = mem;
+    TraceRing ring;
+    TraceWriter writer(file);
+    // when:
+    cpu.Execute(5000, mem, writer);
+    cpu.Execute(3000, mem, writer);
+    ASSERT_TRUE(writer.Close());
+    ringCpu.Execute(5000, ringMem, ring);
+    ringCpu.Execute(3000, ringMem, ring);
+    // then:
+    EXPECT_EQ(writer.Count(), ring.Count());
+    ExpectSameEntries(ReadBack(), ring.Last(ring.Capacity()));
+}
+
+TEST_F(TraceFileTests, StoresALoopInAFewBytesAnInstruction) {
+    // given:
+    Load({ CPU::INS_LDX_IM, 0x00, CPU::INS_DEX, CPU::INS_BNE, Byte(-3), CPU::INS_INY,
+           CPU::INS_JMP_ABS, Start & 0xFF, Start >> 8 });
+    TraceWriter writer(file);
+    // when:
+    cpu.Execute(1'000'000, mem, writer);
+    ASSERT_TRUE(writer.Close());
+    // then:
+    EXPECT_GT(writer.Count(), 100'000u);
+    EXPECT_LT(writer.BytesWritten(), writer.Count() * 4);
+    fseek(file, 0, SEEK_END);
+    EXPECT_EQ(u64(ftell(file)), writer.BytesWritten());
+}
+
+TEST_F(TraceFileTests, KeepsEveryInstructionWhenTheQueueFills) {
+    // given:
+    Load({ CPU::INS_INX, CPU::INS_JMP_ABS, Start & 0xFF, Start >> 8 });
+    TraceWriter writer(file, 8);
+    // when:
+    cpu.Execute(100'000 * 5, mem, writer);
+    ASSERT_TRUE(writer.Close());
+    // then:
+    EXPECT_EQ(writer.Count(), 200'000u);
+    const std::vector<TraceEntry> entries = ReadBack();
+    ASSERT_EQ(entries.size(), 200'000u);
+    EXPECT_EQ(entries.back().PC, Start + 1);
+    EXPECT_EQ(entries.back().X, Byte(100'000));
+    EXPECT_EQ(entries.back().Cycle, 100'000u * 5 - 3);
+}
+
+TEST_F(TraceFileTests, RecordsCodeChangedAtAPCItHasRun) {
+    // given:
+    Load({ CPU::INS_LDA_IM, 0x01 });
+    TraceWriter writer(file);
+    cpu.Execute(2, mem, writer);
+    cpu.PC = Start;
+    mem[Start + 1] = 0x02;
+    // when:
+    cpu.Execute(2, mem, writer);
+    ASSERT_TRUE(writer.Close());
+    // then:
+    const std::vector<TraceEntry> entries = ReadBack();
+    ASSERT_EQ(entries.size(), 2u);
+    EXPECT_EQ(entries[0].Operand[0], 0x01);
+    EXPECT_EQ(entries[1].PC, Start);
+    EXPECT_EQ(entries[1].Operand[0], 0x02);
+    EXPECT_EQ(entries[1].A, 0x01);
+}
+
+TEST_F(TraceFileTests, RejectsAFileThatIsNotATrace) {
+    // given:
+    fputs("not a trace", file);
+    rewind(file);
+    // when:
+    TraceReader reader(file);
+    // then:
+    TraceEntry entry;
+    EXPECT_FALSE(reader.Valid());
+    EXPECT_FALSE(reader.Next(entry));
+}